@@ -1,18 +1,47 @@
 #include "BehaviorTree.h"
+#include "BehaviorTreeArena.h"
+#include "BehaviorTreeAsync.h"
+#include "BehaviorTreeCache.h"
+#include "BehaviorTreeInternal.h"
+#include "BehaviorTreeIterative.h"
+#include "BehaviorTreeParallel.h"
+#include "BehaviorTreeProfile.h"
+#include "BehaviorTreeTrace.h"
+#include "BehaviorTreeUtility.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
-static int invertDecorator(BehaviorNode *node);
-static int repeatDecorator(BehaviorNode *node);
-static int conditionalDecorator(BehaviorNode *node);
-static int repeatUntilSuccessDecorator(BehaviorNode *node);
-static int delayDecorator(BehaviorNode *node);
-static int sequenceNode(BehaviorNode *node);
-static int selectorNode(BehaviorNode *node);
-static int decoratorNode(BehaviorNode *node);
-static int parallelNode(BehaviorNode *node);
+static int invertDecorator(BehaviorNode *node, BtContext *ctx);
+static int repeatDecorator(BehaviorNode *node, BtContext *ctx);
+static int conditionalDecorator(BehaviorNode *node, BtContext *ctx);
+static int repeatUntilSuccessDecorator(BehaviorNode *node, BtContext *ctx);
+static int delayDecorator(BehaviorNode *node, BtContext *ctx);
+static int timeoutDecorator(BehaviorNode *node, BtContext *ctx);
+static int cooldownDecorator(BehaviorNode *node, BtContext *ctx);
+static int cacheDecorator(BehaviorNode *node, BtContext *ctx);
+static int sequenceNode(BehaviorNode *node, BtContext *ctx);
+static int selectorNode(BehaviorNode *node, BtContext *ctx);
+static int decoratorNode(BehaviorNode *node, BtContext *ctx);
+static int parallelNode(BehaviorNode *node, BtContext *ctx);
+static int utilityNode(BehaviorNode *node, BtContext *ctx);
+static int runNode(BehaviorNode *node, BtContext *ctx);
+static int executeChild(BehaviorNode *node, BtContext *ctx);
+static NodeStatus tickNode(BehaviorNode *node, BtContext *ctx, uint64_t now);
+static NodeStatus runTick(BehaviorNode *node, BtContext *ctx, uint64_t now);
+static NodeStatus tickSequence(BehaviorNode *node, BtContext *ctx, uint64_t now);
+static NodeStatus tickSelector(BehaviorNode *node, BtContext *ctx, uint64_t now);
+static NodeStatus tickMemory(BehaviorNode *node, BtContext *ctx, uint64_t now);
+static NodeStatus tickParallel(BehaviorNode *node, BtContext *ctx, uint64_t now);
+static NodeStatus tickUtility(BehaviorNode *node, BtContext *ctx, uint64_t now);
+static NodeStatus tickDecorator(BehaviorNode *node, BtContext *ctx, uint64_t now);
+static NodeStatus tickDelay(BehaviorNode *node, BtContext *ctx, uint64_t now);
+static NodeStatus tickTimeout(BehaviorNode *node, BtContext *ctx, uint64_t now);
+static NodeStatus tickCooldown(BehaviorNode *node, BtContext *ctx, uint64_t now);
+static NodeStatus tickCache(BehaviorNode *node, BtContext *ctx, uint64_t now);
+static void haltNode(BehaviorNode *node, BtContext *ctx);
 static BehaviorNode *BehaviorNodeCheck(NodeType type, BehaviorNode *node);
 static BehaviorNode *checkActionNode(BehaviorNode *node);
 static BehaviorNode *checkConditionNode(BehaviorNode *node);
@@ -21,8 +50,28 @@ static BehaviorNode *checkSelectorNode(BehaviorNode *node);
 static BehaviorNode *checkParallelNode(BehaviorNode *node);
 static BehaviorNode *checkDecoratorNode(BehaviorNode *node);
 static BehaviorNode *checkMemoryNode(BehaviorNode *node);
+static BehaviorNode *checkUtilityNode(BehaviorNode *node);
 static void handleMemoryError();
 
+// 每次从外部执行或 tick 一棵树时加一, 用于只在当前 tick 内有效的缓存
+static atomic_uint tickSerial;
+
+// 当前线程正在执行的 tick 的序号, 由 beginTick 设置, 并行子任务继承父节点的值
+static _Thread_local uint32_t currentTick;
+
+// executeNode 使用的引擎, 见 btSetEngine
+static atomic_int currentEngine = BT_ENGINE_RECURSIVE;
+
+// 适配器: 旧的 int (*)(void) 动作和新的上下文动作走同一个调用点
+static inline int callAction(BehaviorNode *node, BtContext *ctx)
+{
+    if (node->ctx_action)
+        return node->ctx_action(ctx);
+    if (node->action)
+        return node->action();
+    return btAsyncRun(node->async, ctx);
+}
+
 /**
  * @brief Executes a node in the behavior tree.
  *
@@ -34,6 +83,89 @@ static void handleMemoryError();
  * @return int Returns 1 if the node execution succeeds, 0 if it fails or for unknown node types.
  */
 int executeNode(BehaviorNode *node)
+{
+    return executeNodeWithContext(node, NULL);
+}
+
+/**
+ * @brief Executes a node on behalf of an agent.
+ *
+ * Same as executeNode, but context actions receive ctx, so one tree can be
+ * run for several agents that each have their own blackboard. Each call is
+ * a new tick for per-tick cache decorators.
+ *
+ * @param node Pointer to the BehaviorNode to be executed.
+ * @param ctx  Agent context passed to context actions, may be NULL.
+ * @return int Returns 1 if the node execution succeeds, 0 if it fails or for unknown node types.
+ */
+int executeNodeWithContext(BehaviorNode *node, BtContext *ctx)
+{
+    uint32_t previous = currentTick;
+    uint32_t tick = atomic_fetch_add_explicit(&tickSerial, 1, memory_order_relaxed) + 1;
+    int result;
+
+    currentTick = tick;
+    // executeNodeParallel 下保持递归, 子节点才能分给线程池
+    if (atomic_load_explicit(&currentEngine, memory_order_relaxed) == BT_ENGINE_ITERATIVE &&
+        btCurrentExecutor() == NULL)
+        result = btExecuteIterative(node, ctx, tick);
+    else
+        result = executeChild(node, ctx);
+    currentTick = previous; // action 中嵌套执行另一棵树后恢复外层的 tick
+    return result;
+}
+
+/**
+ * @brief Executes a subtree as part of an ongoing tick.
+ *
+ * Used by the parallel executor: the children of a parallel node share the
+ * tick serial of their parent, whichever thread runs them.
+ */
+int btExecuteInTick(BehaviorNode *node, BtContext *ctx, uint32_t tick)
+{
+    uint32_t previous = currentTick;
+
+    currentTick = tick;
+    int result = executeChild(node, ctx);
+    currentTick = previous;
+    return result;
+}
+
+/**
+ * @brief Selects the engine used by executeNode for all threads.
+ *
+ * tickTree and the flat engines are not affected.
+ */
+void btSetEngine(BtEngine engine)
+{
+    atomic_store_explicit(&currentEngine, engine, memory_order_relaxed);
+}
+
+BtEngine btGetEngine(void)
+{
+    return (BtEngine)atomic_load_explicit(&currentEngine, memory_order_relaxed);
+}
+
+// 树内部的递归执行, 不开始新的 tick
+static int executeChild(BehaviorNode *node, BtContext *ctx)
+{
+    int result;
+#ifdef BT_ENABLE_PROFILING
+    if (node)
+    {
+        uint64_t start = btProfileBegin(node);
+        result = runNode(node, ctx);
+        btProfileEnd(node, result ? BT_SUCCESS : BT_FAILURE, start);
+        btTraceResult(node, result ? BT_SUCCESS : BT_FAILURE);
+        return result;
+    }
+#endif
+    result = runNode(node, ctx);
+    btTraceResult(node, result ? BT_SUCCESS : BT_FAILURE);
+    return result;
+}
+
+static int runNode(BehaviorNode *node, BtContext *ctx)
 {
     if (node == NULL)
     {
@@ -44,21 +176,28 @@ int executeNode(BehaviorNode *node)
     switch (node->type)
     {
     case NODE_TYPE_ACTION:
-        return node->action();
+        return callAction(node, ctx);
     case NODE_TYPE_CONDITION:
-        return node->action();
+        return callAction(node, ctx);
     case NODE_TYPE_SEQUENCE:
         // Recursive call to handle sequence nodes
-        return sequenceNode(node);
+        return sequenceNode(node, ctx);
     case NODE_TYPE_SELECTOR:
         // Recursive call to handle selector nodes
-        return selectorNode(node);
+        return selectorNode(node, ctx);
     case NODE_TYPE_DECORATOR:
         // Recursive call to handle decorator nodes
-        return decoratorNode(node);
+        return decoratorNode(node, ctx);
     case NODE_TYPE_PARALLEL:
         // Recursive call to handle parallel nodes
-        return parallelNode(node);
+        return parallelNode(node, ctx);
+    case NODE_TYPE_MEMORY:
+        // 一次执行完所有子节点, 没有可以跳过的已完成子节点
+        if (node->params.memory.kind == MEMORY_SELECTOR)
+            return selectorNode(node, ctx);
+        return sequenceNode(node, ctx);
+    case NODE_TYPE_UTILITY:
+        return utilityNode(node, ctx);
     default:
         return 0; // Unknown node type
     }
@@ -75,11 +214,11 @@ int executeNode(BehaviorNode *node)
  *             It must have a valid list of child nodes to execute.
  * @return int Returns 1 if all child nodes succeed, 0 if any child node fails.
  */
-static int sequenceNode(BehaviorNode *node)
+static int sequenceNode(BehaviorNode *node, BtContext *ctx)
 {
     for (int i = 0; i < node->child_count; i++)
     {
-        int result = executeNode(node->children[i]);
+        int result = executeChild(node->children[i], ctx);
 
         if (!result)
         {
@@ -99,11 +238,11 @@ static int sequenceNode(BehaviorNode *node)
  *             It must have a valid list of child nodes to execute.
  * @return int Returns 1 if any child node succeeds, 0 if all child nodes fail.
  */
-static int selectorNode(BehaviorNode *node)
+static int selectorNode(BehaviorNode *node, BtContext *ctx)
 {
     for (int i = 0; i < node->child_count; i++)
     {
-        int result = executeNode(node->children[i]);
+        int result = executeChild(node->children[i], ctx);
 
         if (result)
         {
@@ -113,12 +252,25 @@ static int selectorNode(BehaviorNode *node)
     return 0; // Failure if all children fail
 }
 
+/**
+ * @brief Executes a utility node: scores the children and runs the chosen one.
+ *
+ * @return int The result of the chosen child; the others are not run.
+ */
+static int utilityNode(BehaviorNode *node, BtContext *ctx)
+{
+    uint32_t chosen = btUtilityChoose(node->params.utility.table, ctx,
+                                      (BtUtilityMode)node->params.utility.mode, &node->state.counter);
+    return executeChild(node->children[chosen], ctx);
+}
+
 /**
  * @brief Executes a decorator node in the behavior tree.
  *
  * This function processes a decorator node by executing its child node
  * according to the decorator's type. It supports various decorator types
- * such as invert, repeat, repeat until success, conditional, and delay.
+ * such as invert, repeat, repeat until success, conditional, delay, timeout
+ * and cooldown.
  *
  * @param node Pointer to the BehaviorNode structure representing the decorator node.
  *             It must have exactly one child node and a valid decorator.
@@ -126,7 +278,7 @@ static int selectorNode(BehaviorNode *node)
  *             - 1 for success
  *             - 0 for failure or if the decorator type is unknown
  */
-static int decoratorNode(BehaviorNode *node)
+static int decoratorNode(BehaviorNode *node, BtContext *ctx)
 {
     Decorator *decorator = node->decorator;
 
@@ -138,19 +290,28 @@ static int decoratorNode(BehaviorNode *node)
     switch (decorator->type)
     {
     case DECORATOR_TYPE_INVERT:
-        return invertDecorator(node);
+        return invertDecorator(node, ctx);
 
     case DECORATOR_TYPE_REPEAT:
-        return repeatDecorator(node);
+        return repeatDecorator(node, ctx);
 
     case DECORATOR_TYPE_REPEAT_UNTIL_SUCCESS:
-        return repeatUntilSuccessDecorator(node);
+        return repeatUntilSuccessDecorator(node, ctx);
 
     case DECORATOR_TYPE_CONDITIONAL:
-        return conditionalDecorator(node);
+        return conditionalDecorator(node, ctx);
 
     case DECORATOR_TYPE_DELAY:
-        return delayDecorator(node);
+        return delayDecorator(node, ctx);
+
+    case DECORATOR_TYPE_TIMEOUT:
+        return timeoutDecorator(node, ctx);
+
+    case DECORATOR_TYPE_COOLDOWN:
+        return cooldownDecorator(node, ctx);
+
+    case DECORATOR_TYPE_CACHE:
+        return cacheDecorator(node, ctx);
 
     default:
         return 0;
@@ -158,161 +319,1012 @@ static int decoratorNode(BehaviorNode *node)
 }
 
 /**
- * @brief Executes an invert decorator node in the behavior tree.
+ * @brief Executes an invert decorator node in the behavior tree.
+ *
+ * This function processes an invert decorator node by executing its child node
+ * and inverting the result. If the child node succeeds, the invert decorator
+ * returns failure, and vice versa.
+ *
+ * @param node Pointer to the BehaviorNode structure representing the invert decorator node.
+ *             It must have exactly one child node.
+ * @return int Returns 1 if the child node fails, 0 if the child node succeeds.
+ */
+static int invertDecorator(BehaviorNode *node, BtContext *ctx)
+{
+    return executeChild(node->children[0], ctx) == 0 ? 1 : 0; // 反转结果
+}
+
+/**
+ * @brief Executes a repeat decorator node in the behavior tree.
+ *
+ * This function processes a repeat decorator node by executing its child node
+ * a specified number of times. The repeat count is determined by the decorator's
+ * parameters. The function returns the result of the last execution of the child node.
+ *
+ * @param node Pointer to the BehaviorNode structure representing the repeat decorator node.
+ *             It must have exactly one child node and a valid repeat decorator.
+ * @return int Returns the result of the last execution of the child node:
+ *             - 1 for success
+ *             - 0 for failure
+ */
+static int repeatDecorator(BehaviorNode *node, BtContext *ctx)
+{
+    Decorator *decorator = node->decorator;
+    uint32_t repeat = decorator->params.repeat;
+
+    int result = 0; // repeat 为 0 时失败
+    while (repeat--)
+    {
+        result = executeChild(node->children[0], ctx);
+    }
+    return result; // 返回最后的执行结果
+}
+
+static int repeatUntilSuccessDecorator(BehaviorNode *node, BtContext *ctx)
+{
+    Decorator *decorator = node->decorator;
+    int result;
+
+    do
+    {
+        result = executeChild(node->children[0], ctx);
+    } while (!result);
+
+    return result; // 返回最后的执行结果
+}
+
+static int conditionalDecorator(BehaviorNode *node, BtContext *ctx)
+{
+    Decorator *decorator = node->decorator;
+    int result;
+    result = executeChild(node->children[0], ctx);
+
+    if (node->child_count == 1)
+        return result;
+
+    if (result)
+    {
+        return executeChild(node->children[1], ctx);
+    }
+    if (node->child_count < 3)
+    {
+        return 0;
+    }
+    return executeChild(node->children[2], ctx);
+}
+
+static int delayDecorator(BehaviorNode *node, BtContext *ctx)
+{
+    uint32_t delay = btDecoratorDurationMs(node->decorator);
+
+    int result = executeChild(node->children[0], ctx);
+    if (result == 1)
+        btSleepMs(delay);
+    return result;
+}
+
+/**
+ * @brief Executes a timeout decorator node.
+ *
+ * The child runs to completion; the decorator fails if it took longer than
+ * params.timeout milliseconds.
+ */
+static int timeoutDecorator(BehaviorNode *node, BtContext *ctx)
+{
+    uint64_t start = btMonotonicMs();
+    int result = executeChild(node->children[0], ctx);
+
+    if (btMonotonicMs() - start > node->decorator->params.timeout)
+    {
+        return 0;
+    }
+    return result;
+}
+
+/**
+ * @brief Executes a cooldown decorator node.
+ *
+ * After the child has run, the decorator fails without running it until
+ * params.cooldown milliseconds have passed. The end of the cooldown is kept
+ * in node->state, like in tick mode.
+ */
+static int cooldownDecorator(BehaviorNode *node, BtContext *ctx)
+{
+    uint32_t now = (uint32_t)btMonotonicMs();
+
+    if (node->state.running_child == 1 && (int32_t)(now - node->state.counter) < 0)
+    {
+        return 0;
+    }
+    int result = executeChild(node->children[0], ctx);
+    node->state.counter = (uint32_t)btMonotonicMs() + node->decorator->params.cooldown;
+    node->state.running_child = 1;
+    return result;
+}
+
+/**
+ * @brief Executes a cache decorator node.
+ *
+ * Returns the stored result of the child while it is valid (see
+ * BehaviorTreeCache.h), otherwise runs the child and stores its result.
+ */
+static int cacheDecorator(BehaviorNode *node, BtContext *ctx)
+{
+    uint32_t ttl = node->decorator->params.ttl;
+    uint32_t now = ttl == BT_CACHE_PER_TICK ? 0 : (uint32_t)btMonotonicMs();
+    uint32_t tick = currentTick;
+    NodeStatus status;
+
+    if (btCacheLookupShared(&node->state, ttl, now, tick, &status))
+        return status;
+    int result = executeChild(node->children[0], ctx);
+    btCacheStoreShared(&node->state, ttl, now, tick, result ? BT_SUCCESS : BT_FAILURE);
+    return result;
+}
+
+/**
+ * @brief Resolves the success/failure thresholds of a parallel node.
+ */
+static void parallelThresholds(BehaviorNode *node, uint32_t *success, uint32_t *failure)
+{
+    uint32_t count = (uint32_t)node->child_count;
+    uint32_t successThreshold = node->params.parallel.success_threshold;
+    uint32_t failureThreshold = node->params.parallel.failure_threshold;
+
+    if (successThreshold == 0 || successThreshold > count)
+        successThreshold = count;
+    if (failureThreshold == 0)
+        failureThreshold = count - successThreshold + 1;
+    *success = successThreshold;
+    *failure = failureThreshold;
+}
+
+// Parallel node behavior (succeeds once success_threshold children succeed)
+/**
+ * @brief Executes a parallel node in the behavior tree.
+ *
+ * The children run in order and the first threshold reached decides the
+ * result; the children after that point are not executed. When called
+ * through executeNodeParallel the children run concurrently on the
+ * executor's threads and children that have not started yet once the
+ * result is decided are skipped, so the outcome does not depend on thread
+ * timing.
+ *
+ * @param node Pointer to the BehaviorNode structure representing the parallel node.
+ * @return int Returns 1 if the success threshold is reached, 0 otherwise.
+ */
+static int parallelNode(BehaviorNode *node, BtContext *ctx)
+{
+    BtExecutor *executor = btCurrentExecutor();
+    uint32_t successThreshold, failureThreshold;
+    uint32_t successCount = 0, failureCount = 0;
+
+    parallelThresholds(node, &successThreshold, &failureThreshold);
+    if (executor != NULL && node->child_count > 1)
+    {
+        return btExecutorRunChildren(executor, node->children, node->child_count,
+                                     successThreshold, failureThreshold, ctx, currentTick);
+    }
+
+    for (int i = 0; i < node->child_count; i++)
+    {
+        if (executeChild(node->children[i], ctx))
+        {
+            if (++successCount >= successThreshold)
+                return 1;
+        }
+        else if (++failureCount >= failureThreshold)
+        {
+            return 0;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Returns a monotonic timestamp in milliseconds.
+ *
+ * The value is unaffected by wall-clock changes and is the time base used by
+ * tickTree for delays.
+ *
+ * @return uint64_t Milliseconds since an unspecified starting point.
+ */
+uint64_t btMonotonicMs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+/**
+ * @brief Ticks a behavior tree once without blocking.
+ *
+ * Unlike executeNode, no node ever waits inside this call. Delays and actions
+ * that need more time return BT_RUNNING and are resumed on the next tick, so
+ * a single thread can drive many trees by calling tickTree on each in turn.
+ *
+ * @param root Pointer to the root BehaviorNode of the tree.
+ * @return NodeStatus BT_SUCCESS, BT_FAILURE, or BT_RUNNING if the tree must be ticked again.
+ */
+NodeStatus tickTree(BehaviorNode *root)
+{
+    return tickTreeAt(root, btMonotonicMs());
+}
+
+/**
+ * @brief Ticks a behavior tree once against a caller-supplied clock.
+ *
+ * Lets a caller that drives many trees read the clock once per frame and
+ * share the value between all of them.
+ *
+ * @param root   Pointer to the root BehaviorNode of the tree.
+ * @param now_ms Current time as returned by btMonotonicMs().
+ * @return NodeStatus BT_SUCCESS, BT_FAILURE, or BT_RUNNING if the tree must be ticked again.
+ */
+NodeStatus tickTreeAt(BehaviorNode *root, uint64_t now_ms)
+{
+    return tickTreeWithContext(root, NULL, now_ms);
+}
+
+/**
+ * @brief Ticks a behavior tree once on behalf of an agent.
+ *
+ * @param root   Pointer to the root BehaviorNode of the tree.
+ * @param ctx    Agent context passed to context actions, may be NULL.
+ * @param now_ms Current time as returned by btMonotonicMs().
+ * @return NodeStatus BT_SUCCESS, BT_FAILURE, or BT_RUNNING if the tree must be ticked again.
+ */
+NodeStatus tickTreeWithContext(BehaviorNode *root, BtContext *ctx, uint64_t now_ms)
+{
+    uint32_t previous = currentTick;
+
+    currentTick = atomic_fetch_add_explicit(&tickSerial, 1, memory_order_relaxed) + 1;
+    NodeStatus status = tickNode(root, ctx, now_ms);
+    currentTick = previous;
+    return status;
+}
+
+/**
+ * @brief Aborts a tree that tickTree left running.
+ *
+ * Every node that is still BT_RUNNING is halted, children first: leaves call
+ * their halt callback and async leaves cancel their handle, then all running
+ * nodes forget their progress and return to BT_IDLE. The next tick starts
+ * the tree from scratch. Halting a tree that is not running does nothing.
+ *
+ * tickTree halts subtrees itself when they lose control: the children a
+ * parallel node no longer needs once a threshold is reached, a running
+ * child of a sequence or selector when an earlier child decides the result,
+ * the child of an expired timeout and the branch a conditional decorator
+ * leaves.
+ *
+ * @param root Pointer to the root BehaviorNode of the tree.
+ */
+void haltTree(BehaviorNode *root)
+{
+    haltNode(root, NULL);
+}
+
+/**
+ * @brief Aborts a running tree on behalf of an agent.
+ *
+ * @param ctx Agent context passed to the halt callbacks, may be NULL.
+ */
+void haltTreeWithContext(BehaviorNode *root, BtContext *ctx)
+{
+    haltNode(root, ctx);
+}
+
+static void haltNode(BehaviorNode *node, BtContext *ctx)
+{
+    if (node == NULL || node->state.status != BT_RUNNING)
+        return;
+
+    if (node->type == NODE_TYPE_ACTION || node->type == NODE_TYPE_CONDITION)
+    {
+        if (node->async)
+            btAsyncHalt(node->async, &node->state);
+        if (node->halt)
+            node->halt(ctx);
+    }
+    else
+    {
+        // 只有仍在运行的子节点会被处理, 已结束的直接跳过
+        for (int i = 0; i < node->child_count; i++)
+            haltNode(node->children[i], ctx);
+    }
+
+    // 运行中的缓存装饰器没有缓存条目, 所有节点类型都可以直接清零
+    node->state.running_child = 0;
+    node->state.counter = 0;
+    node->state.status = BT_IDLE;
+}
+
+static NodeStatus tickNode(BehaviorNode *node, BtContext *ctx, uint64_t now)
+{
+    NodeStatus status;
+#ifdef BT_ENABLE_PROFILING
+    if (node)
+    {
+        uint64_t start = btProfileBegin(node);
+        status = runTick(node, ctx, now);
+        btProfileEnd(node, status, start);
+        btTraceResult(node, status);
+        return status;
+    }
+#endif
+    status = runTick(node, ctx, now);
+    btTraceResult(node, status);
+    return status;
+}
+
+static NodeStatus runTick(BehaviorNode *node, BtContext *ctx, uint64_t now)
+{
+    NodeStatus status;
+
+    if (node == NULL)
+    {
+        handleMemoryError();
+        return BT_FAILURE;
+    }
+
+    switch (node->type)
+    {
+    case NODE_TYPE_ACTION:
+    case NODE_TYPE_CONDITION:
+    {
+        if (node->async)
+        {
+            status = btAsyncTick(node->async, &node->state, ctx);
+            break;
+        }
+        int result = callAction(node, ctx);
+        if (result == BT_RUNNING)
+            status = BT_RUNNING;
+        else
+            status = result ? BT_SUCCESS : BT_FAILURE;
+        break;
+    }
+    case NODE_TYPE_SEQUENCE:
+        status = tickSequence(node, ctx, now);
+        break;
+    case NODE_TYPE_SELECTOR:
+        status = tickSelector(node, ctx, now);
+        break;
+    case NODE_TYPE_DECORATOR:
+        status = tickDecorator(node, ctx, now);
+        break;
+    case NODE_TYPE_PARALLEL:
+        status = tickParallel(node, ctx, now);
+        break;
+    case NODE_TYPE_MEMORY:
+        status = tickMemory(node, ctx, now);
+        break;
+    case NODE_TYPE_UTILITY:
+        status = tickUtility(node, ctx, now);
+        break;
+    default:
+        status = BT_FAILURE; // Unknown node type
+        break;
+    }
+
+    node->state.status = status;
+    return status;
+}
+
+/**
+ * @brief Remembers the running child of a sequence or selector.
+ *
+ * decided is the index of the child that decided this tick. A child after
+ * it that was still running from the previous tick was not ticked and is
+ * halted, e.g. a running action whose guard condition now fails.
+ */
+static inline void preempt(BehaviorNode *node, BtContext *ctx, int decided, NodeStatus status)
+{
+    uint32_t previous = node->state.running_child; // 上一次运行中的子节点下标 + 1
+
+    if (previous > (uint32_t)decided + 1)
+        haltNode(node->children[previous - 1], ctx);
+    node->state.running_child = status == BT_RUNNING ? (uint32_t)decided + 1 : 0;
+}
+
+/**
+ * @brief Ticks a sequence node.
+ *
+ * Children are ticked in order every tick. The first child that fails or is
+ * still running decides the result.
+ */
+static NodeStatus tickSequence(BehaviorNode *node, BtContext *ctx, uint64_t now)
+{
+    NodeStatus status = BT_SUCCESS;
+    int i;
+
+    for (i = 0; i < node->child_count; i++)
+    {
+        status = tickNode(node->children[i], ctx, now);
+        if (status != BT_SUCCESS)
+            break;
+    }
+    preempt(node, ctx, i, status);
+    return status;
+}
+
+/**
+ * @brief Ticks a selector node.
+ *
+ * Children are ticked in order every tick. The first child that succeeds or
+ * is still running decides the result; a lower-priority child that was
+ * running is halted.
+ */
+static NodeStatus tickSelector(BehaviorNode *node, BtContext *ctx, uint64_t now)
+{
+    NodeStatus status = BT_FAILURE;
+    int i;
+
+    for (i = 0; i < node->child_count; i++)
+    {
+        status = tickNode(node->children[i], ctx, now);
+        if (status != BT_FAILURE)
+            break;
+    }
+    preempt(node, ctx, i, status);
+    return status;
+}
+
+/**
+ * @brief Ticks a memory sequence or memory selector.
+ *
+ * Like tickSequence/tickSelector, except that a child that is still running
+ * is remembered and the next tick resumes from it, so the children that
+ * finished before it are not run again. The memory is cleared when the node
+ * finishes.
+ */
+static NodeStatus tickMemory(BehaviorNode *node, BtContext *ctx, uint64_t now)
+{
+    NodeStatus next = node->params.memory.kind == MEMORY_SELECTOR ? BT_FAILURE : BT_SUCCESS;
+    NodeStatus status = next;
+    uint32_t i;
+
+    for (i = node->state.running_child; i < (uint32_t)node->child_count; i++)
+    {
+        status = tickNode(node->children[i], ctx, now);
+        if (status != next)
+            break;
+    }
+    node->state.running_child = status == BT_RUNNING ? i : 0;
+    return status;
+}
+
+/**
+ * @brief Ticks a utility node.
+ *
+ * BT_UTILITY_MAX scores the children again every tick and switches to a new
+ * winner right away, halting the child that was running. A weighted random
+ * pick is kept until the chosen child finishes, otherwise every tick would
+ * draw again.
+ */
+static NodeStatus tickUtility(BehaviorNode *node, BtContext *ctx, uint64_t now)
+{
+    uint32_t previous = node->state.running_child; // 上一次运行中的子节点下标 + 1
+    uint32_t chosen;
+
+    if (previous && node->params.utility.mode == BT_UTILITY_WEIGHTED_RANDOM)
+    {
+        chosen = previous - 1;
+    }
+    else
+    {
+        chosen = btUtilityChoose(node->params.utility.table, ctx,
+                                 (BtUtilityMode)node->params.utility.mode, &node->state.counter);
+        if (previous && previous != chosen + 1)
+            haltNode(node->children[previous - 1], ctx);
+    }
+
+    NodeStatus status = tickNode(node->children[chosen], ctx, now);
+    node->state.running_child = status == BT_RUNNING ? chosen + 1 : 0;
+    return status;
+}
+
+/**
+ * @brief Ticks a parallel node.
+ *
+ * Every child that has not finished yet is ticked, in order. Children that
+ * finished on an earlier tick keep their result until the parallel node
+ * itself finishes, so they are not run twice. As soon as one of the
+ * thresholds in params.parallel is reached the remaining children are not
+ * ticked and those still running are halted.
+ */
+static NodeStatus tickParallel(BehaviorNode *node, BtContext *ctx, uint64_t now)
+{
+    uint32_t successCount = 0;
+    uint32_t failureCount = 0;
+    uint32_t successThreshold, failureThreshold;
+    int fresh = node->state.status != BT_RUNNING;
+    NodeStatus result = BT_RUNNING;
+
+    parallelThresholds(node, &successThreshold, &failureThreshold);
+    for (int i = 0; i < node->child_count && result == BT_RUNNING; i++)
+    {
+        BehaviorNode *child = node->children[i];
+        NodeStatus status = (NodeStatus)child->state.status;
+
+        if (fresh || status == BT_RUNNING || status == BT_IDLE)
+        {
+            status = tickNode(child, ctx, now);
+        }
+        if (status == BT_SUCCESS && ++successCount >= successThreshold)
+            result = BT_SUCCESS;
+        else if (status == BT_FAILURE && ++failureCount >= failureThreshold)
+            result = BT_FAILURE;
+    }
+    if (result == BT_RUNNING && successCount + failureCount == (uint32_t)node->child_count)
+        result = BT_FAILURE;
+
+    if (result == BT_RUNNING)
+    {
+        return BT_RUNNING;
+    }
+    // 结束本轮: 中止仍在运行的子节点, 清除子节点结果以便下一轮重新执行
+    for (int i = 0; i < node->child_count; i++)
+    {
+        haltNode(node->children[i], ctx);
+        node->children[i]->state.status = BT_IDLE;
+    }
+    return result;
+}
+
+/**
+ * @brief Ticks a decorator node.
+ *
+ * Same decorator types as decoratorNode, but nothing loops or sleeps across
+ * ticks: repeat keeps its count in the node state, repeat-until-success tries
+ * once per tick, and delay waits on the monotonic clock.
+ */
+static NodeStatus tickDecorator(BehaviorNode *node, BtContext *ctx, uint64_t now)
+{
+    Decorator *decorator = node->decorator;
+    NodeStatus status;
+
+    if (node->child_count == 0 || decorator == NULL)
+    {
+        handleMemoryError();
+        return BT_FAILURE;
+    }
+
+    switch (decorator->type)
+    {
+    case DECORATOR_TYPE_INVERT:
+        status = tickNode(node->children[0], ctx, now);
+        if (status == BT_RUNNING)
+            return BT_RUNNING;
+        return status == BT_SUCCESS ? BT_FAILURE : BT_SUCCESS;
+
+    case DECORATOR_TYPE_REPEAT:
+        status = BT_FAILURE; // repeat 为 0 时失败, 与 executeNode 相同
+        while (node->state.counter < decorator->params.repeat)
+        {
+            status = tickNode(node->children[0], ctx, now);
+            if (status == BT_RUNNING)
+                return BT_RUNNING;
+            node->state.counter++;
+        }
+        node->state.counter = 0;
+        return status; // 返回最后的执行结果
+
+    case DECORATOR_TYPE_REPEAT_UNTIL_SUCCESS:
+        // 每个 tick 只尝试一次, 失败则下次 tick 重试
+        status = tickNode(node->children[0], ctx, now);
+        return status == BT_SUCCESS ? BT_SUCCESS : BT_RUNNING;
+
+    case DECORATOR_TYPE_CONDITIONAL:
+        status = tickNode(node->children[0], ctx, now);
+        if (node->child_count == 1)
+            return status;
+        // 条件改变时中止另一个分支; 条件仍在运行时两个分支都中止
+        if (status != BT_SUCCESS)
+            haltNode(node->children[1], ctx);
+        if (status != BT_FAILURE && node->child_count > 2)
+            haltNode(node->children[2], ctx);
+        if (status == BT_RUNNING)
+            return status;
+        if (status == BT_SUCCESS)
+            return tickNode(node->children[1], ctx, now);
+        if (node->child_count < 3)
+            return BT_FAILURE;
+        return tickNode(node->children[2], ctx, now);
+
+    case DECORATOR_TYPE_DELAY:
+        return tickDelay(node, ctx, now);
+
+    case DECORATOR_TYPE_TIMEOUT:
+        return tickTimeout(node, ctx, now);
+
+    case DECORATOR_TYPE_COOLDOWN:
+        return tickCooldown(node, ctx, now);
+
+    case DECORATOR_TYPE_CACHE:
+        return tickCache(node, ctx, now);
+
+    default:
+        return BT_FAILURE;
+    }
+}
+
+/**
+ * @brief Ticks a delay decorator.
+ *
+ * Runs the child; once it succeeds the decorator keeps returning BT_RUNNING
+ * until the delay has passed on the monotonic clock. The deadline is stored
+ * as wrapping 32-bit milliseconds in state.counter.
+ */
+static NodeStatus tickDelay(BehaviorNode *node, BtContext *ctx, uint64_t now)
+{
+    NodeState *state = &node->state;
+
+    if (state->running_child == 0)
+    {
+        NodeStatus status = tickNode(node->children[0], ctx, now);
+        if (status != BT_SUCCESS)
+            return status;
+        state->counter = (uint32_t)(now + btDecoratorDurationMs(node->decorator));
+        state->running_child = 1; // 进入等待阶段
+    }
+
+    if ((int32_t)((uint32_t)now - state->counter) < 0)
+    {
+        return BT_RUNNING;
+    }
+    state->running_child = 0;
+    return BT_SUCCESS;
+}
+
+/**
+ * @brief Ticks a timeout decorator.
+ *
+ * The deadline is set when the child starts. If the child is still running
+ * when it passes, the decorator fails.
+ */
+static NodeStatus tickTimeout(BehaviorNode *node, BtContext *ctx, uint64_t now)
+{
+    NodeState *state = &node->state;
+
+    if (state->running_child == 0)
+    {
+        state->counter = (uint32_t)(now + node->decorator->params.timeout);
+        state->running_child = 1;
+    }
+    else if ((int32_t)((uint32_t)now - state->counter) >= 0)
+    {
+        state->running_child = 0;
+        haltNode(node->children[0], ctx);
+        return BT_FAILURE; // 超时
+    }
+
+    NodeStatus status = tickNode(node->children[0], ctx, now);
+    if (status != BT_RUNNING)
+        state->running_child = 0;
+    return status;
+}
+
+/**
+ * @brief Ticks a cooldown decorator.
+ *
+ * Once the child finishes, the decorator fails without ticking it until
+ * params.cooldown milliseconds have passed.
+ */
+static NodeStatus tickCooldown(BehaviorNode *node, BtContext *ctx, uint64_t now)
+{
+    NodeState *state = &node->state;
+
+    if (state->running_child == 1)
+    {
+        if ((int32_t)((uint32_t)now - state->counter) < 0)
+            return BT_FAILURE; // 冷却中
+        state->running_child = 0;
+    }
+
+    NodeStatus status = tickNode(node->children[0], ctx, now);
+    if (status != BT_RUNNING)
+    {
+        state->counter = (uint32_t)(now + node->decorator->params.cooldown);
+        state->running_child = 1;
+    }
+    return status;
+}
+
+/**
+ * @brief Ticks a cache decorator.
+ *
+ * Same as cacheDecorator; a running child is ticked again on the next tick.
+ */
+static NodeStatus tickCache(BehaviorNode *node, BtContext *ctx, uint64_t now)
+{
+    uint32_t ttl = node->decorator->params.ttl;
+    uint32_t tick = currentTick;
+    NodeStatus status;
+
+    if (btCacheLookupShared(&node->state, ttl, (uint32_t)now, tick, &status))
+        return status;
+    status = tickNode(node->children[0], ctx, now);
+    btCacheStoreShared(&node->state, ttl, (uint32_t)now, tick, status);
+    return status;
+}
+
+/**
+ * @brief Initialises a freshly allocated node and copies its child pointers.
+ *
+ * Shared by the heap and arena constructors. childStorage must have room for
+ * child_count pointers and is ignored when child_count is 0.
+ */
+static void initBehaviorNode(BehaviorNode *node,
+                             BehaviorNode **childStorage,
+                             BehaviorNode **children,
+                             int child_count,
+                             NodeType type,
+                             int (*actionFunc)(void))
+{
+    // 初始化节点
+    node->type = type;
+    node->action = actionFunc;
+    node->ctx_action = NULL;
+    node->async = NULL;
+    node->halt = NULL;
+    node->decorator = NULL; // 由调用者在创建后设置
+    atomic_init(&node->reference_count, 0); // 还没有父节点
+    node->child_count = child_count;
+    memset(&node->params, 0, sizeof(node->params));
+    node->state.running_child = 0;
+    node->state.counter = 0;
+    node->state.status = BT_IDLE;
+
+    if (child_count > 0)
+    {
+        node->children = childStorage;
+        for (int i = 0; i < child_count; i++)
+        {
+            node->children[i] = children[i]; // 指向子节点
+            if (children[i])
+            {
+                atomic_fetch_add_explicit(&children[i]->reference_count, 1, memory_order_relaxed); // 增加子节点的引用计数
+            }
+        }
+    }
+    else
+    {
+        node->children = NULL; // No children
+    }
+}
+
+BehaviorNode *createBehaviorNode(BehaviorNode **children,
+                                 int child_count,
+                                 NodeType type,
+                                 int (*actionFunc)(void))
+{
+    BehaviorNode **childStorage = NULL;
+
+    // 分配节点内存
+    BehaviorNode *node = (BehaviorNode *)malloc(sizeof(BehaviorNode));
+    if (!node)
+    {
+        handleMemoryError();
+        return NULL;
+    }
+
+    // 分配子节点指针的内存
+    if (child_count > 0)
+    {
+        childStorage = (BehaviorNode **)malloc(sizeof(BehaviorNode *) * child_count);
+        if (!childStorage)
+        {
+            free(node); // 释放已分配的节点内存
+            handleMemoryError();
+            return NULL;
+        }
+    }
+    initBehaviorNode(node, childStorage, children, child_count, type, actionFunc);
+    btTraceCreate(node, type);
+
+    return BehaviorNodeCheck(type, node);
+}
+
+/**
+ * @brief Creates an action or condition node whose callback receives the agent context.
+ *
+ * @param type      NODE_TYPE_ACTION or NODE_TYPE_CONDITION.
+ * @param ctxAction Callback called with the BtContext passed to
+ *                  executeNodeWithContext / tickTreeWithContext.
+ * @return BehaviorNode* The new node, or NULL if it fails validation.
+ */
+BehaviorNode *createContextNode(NodeType type, int (*ctxAction)(BtContext *ctx))
+{
+    BehaviorNode *node = (BehaviorNode *)malloc(sizeof(BehaviorNode));
+    if (!node)
+    {
+        handleMemoryError();
+        return NULL;
+    }
+    initBehaviorNode(node, NULL, NULL, 0, type, NULL);
+    node->ctx_action = ctxAction;
+    btTraceCreate(node, type);
+
+    return BehaviorNodeCheck(type, node);
+}
+
+/**
+ * @brief Creates an action or condition node that runs an async action.
  *
- * This function processes an invert decorator node by executing its child node
- * and inverting the result. If the child node succeeds, the invert decorator
- * returns failure, and vice versa.
+ * tickTree reports BT_RUNNING while the action's handle is in flight;
+ * executeNode waits for it. The action must outlive the node.
  *
- * @param node Pointer to the BehaviorNode structure representing the invert decorator node.
- *             It must have exactly one child node.
- * @return int Returns 1 if the child node fails, 0 if the child node succeeds.
+ * @param type  NODE_TYPE_ACTION or NODE_TYPE_CONDITION.
+ * @param async Loop, start callback and user data, see BehaviorTreeAsync.h.
+ * @return BehaviorNode* The new node, or NULL if it fails validation.
  */
-static int invertDecorator(BehaviorNode *node)
+BehaviorNode *createAsyncNode(NodeType type, const BtAsyncAction *async)
 {
-    return executeNode(node->children[0]) == 0 ? 1 : 0; // 反转结果
+    BehaviorNode *node = (BehaviorNode *)malloc(sizeof(BehaviorNode));
+    if (!node)
+    {
+        handleMemoryError();
+        return NULL;
+    }
+    initBehaviorNode(node, NULL, NULL, 0, type, NULL);
+    node->async = (async && async->start) ? async : NULL;
+    btTraceCreate(node, type);
+
+    return BehaviorNodeCheck(type, node);
 }
 
 /**
- * @brief Executes a repeat decorator node in the behavior tree.
+ * @brief Creates a parallel node with explicit thresholds.
  *
- * This function processes a repeat decorator node by executing its child node
- * a specified number of times. The repeat count is determined by the decorator's
- * parameters. The function returns the result of the last execution of the child node.
- *
- * @param node Pointer to the BehaviorNode structure representing the repeat decorator node.
- *             It must have exactly one child node and a valid repeat decorator.
- * @return int Returns the result of the last execution of the child node:
- *             - 1 for success
- *             - 0 for failure
+ * @param success_threshold Number of children that must succeed, 0 for all.
+ * @param failure_threshold Number of failed children that fail the node,
+ *                          0 for "success is no longer reachable".
+ * @return BehaviorNode* The new node, or NULL if it fails validation.
  */
-static int repeatDecorator(BehaviorNode *node)
+BehaviorNode *createParallelNode(BehaviorNode **children,
+                                 int child_count,
+                                 uint32_t success_threshold,
+                                 uint32_t failure_threshold)
 {
-    Decorator *decorator = node->decorator;
-    uint32_t repeat = decorator->params.repeat;
-
-    int result;
-    while (repeat--)
+    BehaviorNode *node = createBehaviorNode(children, child_count, NODE_TYPE_PARALLEL, NULL);
+    if (node)
     {
-        result = executeNode(node->children[0]);
+        node->params.parallel.success_threshold = success_threshold;
+        node->params.parallel.failure_threshold = failure_threshold;
     }
-    return result; // 返回最后的执行结果
+    return node;
 }
 
-static int repeatUntilSuccessDecorator(BehaviorNode *node)
+/**
+ * @brief Creates a memory sequence or memory selector.
+ *
+ * Ticked with tickTree, the node resumes from the child that was running on
+ * the previous tick instead of starting over from the first child.
+ *
+ * @return BehaviorNode* The new node, or NULL if it fails validation.
+ */
+BehaviorNode *createMemoryNode(BehaviorNode **children,
+                               int child_count,
+                               MemoryKind kind)
 {
-    Decorator *decorator = node->decorator;
-    int result;
-
-    do
+    BehaviorNode *node = createBehaviorNode(children, child_count, NODE_TYPE_MEMORY, NULL);
+    if (node)
     {
-        result = executeNode(node->children[0]);
-    } while (result);
-
-    return result; // 返回最后的执行结果
+        node->params.memory.kind = kind;
+    }
+    return node;
 }
 
-static int conditionalDecorator(BehaviorNode *node)
+/**
+ * @brief Creates a utility selector.
+ *
+ * Each tick or execution scores the children with table (option i is child
+ * i) and runs only the chosen child, whose result is the node's result. The
+ * table is not owned by the node and must outlive it.
+ *
+ * @param table Scoring table with child_count options, see BehaviorTreeUtility.h.
+ * @param mode  Highest score or weighted random pick.
+ * @return BehaviorNode* The new node, or NULL if it fails validation.
+ */
+BehaviorNode *createUtilityNode(BehaviorNode **children,
+                                int child_count,
+                                const BtUtility *table,
+                                BtUtilityMode mode)
 {
-    Decorator *decorator = node->decorator;
-    int result;
-    result = executeNode(node->children[0]);
-
-    if (node->child_count == 1)
-        return result;
+    BehaviorNode **childStorage = NULL;
 
-    if (result)
+    BehaviorNode *node = (BehaviorNode *)malloc(sizeof(BehaviorNode));
+    if (!node)
     {
-        return executeNode(node->children[1]);
+        handleMemoryError();
+        return NULL;
     }
-    if (node->child_count < 3)
+    if (child_count > 0)
     {
-        return 0;
+        childStorage = (BehaviorNode **)malloc(sizeof(BehaviorNode *) * child_count);
+        if (!childStorage)
+        {
+            free(node);
+            handleMemoryError();
+            return NULL;
+        }
     }
-    return executeNode(node->children[2]);
-}
-
-static int delayDecorator(BehaviorNode *node)
-{
-    Decorator *decorator = node->decorator;
-    uint32_t delay = decorator->params.delay;
+    initBehaviorNode(node, childStorage, children, child_count, NODE_TYPE_UTILITY, NULL);
+    // 参数在校验前设置, 校验需要检查得分表
+    node->params.utility.table = table;
+    node->params.utility.mode = mode;
+    btTraceCreate(node, NODE_TYPE_UTILITY);
 
-    int result = executeNode(node->children[0]);
-    if (result == 1)
-    {
-        sleep(delay);
-    }
-    return result;
+    return BehaviorNodeCheck(NODE_TYPE_UTILITY, node);
 }
 
-// Parallel node behavior (example: succeeds if all children succeed)
 /**
- * @brief Executes a parallel node in the behavior tree.
+ * @brief Creates a behavior node inside an arena.
  *
- * This function executes all child nodes of a parallel node concurrently.
- * It counts the number of successful executions and considers the parallel
- * node successful only if all child nodes succeed.
+ * Same as createBehaviorNode, but the node and its child array are carved
+ * out of one arena allocation and nothing is logged. The node is released
+ * with the arena and must not be passed to freeBehaviorTree.
  *
- * @param node Pointer to the BehaviorNode structure representing the parallel node.
- * @return int Returns 1 if all child nodes succeed, 0 otherwise.
+ * @param arena Arena returned by btArenaCreate.
+ * @return BehaviorNode* The new node, or NULL if it fails validation.
  */
-static int parallelNode(BehaviorNode *node)
+BehaviorNode *btArenaCreateBehaviorNode(BtArena *arena,
+                                        BehaviorNode **children,
+                                        int child_count,
+                                        NodeType type,
+                                        int (*actionFunc)(void))
 {
-    int successCount = 0;
-    for (int i = 0; i < node->child_count; i++)
+    size_t size = sizeof(BehaviorNode);
+    if (child_count > 0)
     {
-        int result = executeNode(node->children[i]);
-        if (!result)
-        {
-            successCount++;
-        }
+        size += sizeof(BehaviorNode *) * (size_t)child_count;
+    }
+
+    BehaviorNode *node = (BehaviorNode *)btArenaAlloc(arena, size);
+    if (!node)
+    {
+        handleMemoryError();
+        return NULL;
     }
-    return (successCount == node->child_count) ? 1 : 0; // Succeeds if all succeed
+    initBehaviorNode(node, (BehaviorNode **)(node + 1), children, child_count, type, actionFunc);
+
+    return BehaviorNodeCheck(type, node);
 }
 
-BehaviorNode *createBehaviorNode(BehaviorNode **children,
-                                 int child_count,
-                                 NodeType type,
-                                 int (*actionFunc)(void))
+/**
+ * @brief Creates an action or condition node with a context action inside an arena.
+ *
+ * Arena counterpart of createContextNode.
+ */
+BehaviorNode *btArenaCreateContextNode(BtArena *arena, NodeType type, int (*ctxAction)(BtContext *ctx))
 {
-    // 分配节点内存
-    BehaviorNode *node = (BehaviorNode *)malloc(sizeof(BehaviorNode));
+    BehaviorNode *node = (BehaviorNode *)btArenaAlloc(arena, sizeof(BehaviorNode));
     if (!node)
     {
         handleMemoryError();
         return NULL;
     }
-    printf("create behavior node, the type is:%d \n", type);
-    // 初始化节点
-    node->type = type;
-    node->action = actionFunc;
-    node->reference_count = 0; // 初始引用计数设置为 1
-    node->child_count = child_count;
+    initBehaviorNode(node, NULL, NULL, 0, type, NULL);
+    node->ctx_action = ctxAction;
 
-    // 分配子节点指针的内存
-    if (child_count > 0)
-    {
-        node->children = (BehaviorNode **)malloc(sizeof(BehaviorNode *) * child_count);
-        if (!node->children)
-        {
-            free(node); // 释放已分配的节点内存
-            handleMemoryError();
-            return NULL;
-        }
+    return BehaviorNodeCheck(type, node);
+}
 
-        for (int i = 0; i < child_count; i++)
-        {
-            node->children[i] = children[i]; // 指向子节点
-            if (children[i])
-            {
-                children[i]->reference_count++; // 增加子节点的引用计数
-            }
-        }
-    }
-    else
+/**
+ * Arena counterpart of createAsyncNode.
+ */
+BehaviorNode *btArenaCreateAsyncNode(BtArena *arena, NodeType type, const BtAsyncAction *async)
+{
+    BehaviorNode *node = (BehaviorNode *)btArenaAlloc(arena, sizeof(BehaviorNode));
+    if (!node)
     {
-        node->children = NULL; // No children
+        handleMemoryError();
+        return NULL;
     }
+    initBehaviorNode(node, NULL, NULL, 0, type, NULL);
+    node->async = (async && async->start) ? async : NULL;
 
     return BehaviorNodeCheck(type, node);
 }
@@ -346,6 +1358,64 @@ Decorator *createDelayDecorator(uint32_t delayTime)
     return decorator;
 }
 
+/**
+ * @brief Creates a delay decorator with a delay in milliseconds.
+ */
+Decorator *createDelayDecoratorMs(uint32_t delayMs)
+{
+    Decorator *decorator = createDelayDecorator(delayMs);
+    decorator->flags |= DECORATOR_FLAG_MILLISECONDS;
+    return decorator;
+}
+
+Decorator *createTimeoutDecorator(uint32_t timeoutMs)
+{
+    return createDecorator(DECORATOR_TYPE_TIMEOUT, &timeoutMs);
+}
+
+/**
+ * @brief Creates a decorator that fails for cooldownMs after its child finishes.
+ *
+ * The cooldown is kept by executeNode, tickTree and tickInstance. The
+ * read-only engines (executeFlat, executeCompact, btSharedExecute) keep no
+ * state between calls and run the child every time.
+ */
+Decorator *createCooldownDecorator(uint32_t cooldownMs)
+{
+    return createDecorator(DECORATOR_TYPE_COOLDOWN, &cooldownMs);
+}
+
+/**
+ * @brief Creates a decorator that caches its child's result.
+ *
+ * Meant for expensive conditions, in particular ones shared by several
+ * parents: the child runs once and its result is reused until it expires.
+ *
+ * Results are kept by executeNode, tickTree and tickInstance. The read-only
+ * engines (executeFlat, executeCompact, btSharedExecute) have nowhere to
+ * keep them and run the child every time.
+ *
+ * @param ttlMs How long a result stays valid, BT_CACHE_PER_TICK (0) to only
+ *              reuse it within the same tick.
+ */
+Decorator *createCacheDecorator(uint32_t ttlMs)
+{
+    return createDecorator(DECORATOR_TYPE_CACHE, &ttlMs);
+}
+
+/**
+ * @brief Returns the duration of a delay, timeout or cooldown decorator in milliseconds.
+ *
+ * Delays created with createDelayDecorator count in seconds, the others in
+ * milliseconds.
+ */
+uint32_t btDecoratorDurationMs(const Decorator *decorator)
+{
+    if (decorator->type == DECORATOR_TYPE_DELAY && !(decorator->flags & DECORATOR_FLAG_MILLISECONDS))
+        return decorator->params.delay * 1000u;
+    return decorator->params.repeat; // 同一块存储
+}
+
 Decorator *createConditionalDecorator()
 {
     Decorator *decorator = createEmptyDecorator();
@@ -358,15 +1428,8 @@ Decorator *createConditionalDecorator()
     return decorator;
 }
 
-Decorator *createDecorator(DecoratorType type, void *param)
+static void initDecorator(Decorator *decorator, DecoratorType type, void *param)
 {
-    Decorator *decorator = createEmptyDecorator();
-    if (!decorator)
-    {
-        handleMemoryError();
-        return NULL;
-    }
-
     decorator->type = type;
 
     switch (type)
@@ -374,6 +1437,9 @@ Decorator *createDecorator(DecoratorType type, void *param)
     case DECORATOR_TYPE_REPEAT:
     case DECORATOR_TYPE_REPEAT_UNTIL_SUCCESS:
     case DECORATOR_TYPE_DELAY:
+    case DECORATOR_TYPE_TIMEOUT:
+    case DECORATOR_TYPE_COOLDOWN:
+    case DECORATOR_TYPE_CACHE:
         decorator->params.repeat = *(uint32_t *)param;
         break;
     case DECORATOR_TYPE_CONDITIONAL:
@@ -385,6 +1451,58 @@ Decorator *createDecorator(DecoratorType type, void *param)
         // 处理未知的类型（可选）
         break;
     }
+}
+
+Decorator *createDecorator(DecoratorType type, void *param)
+{
+    Decorator *decorator = createEmptyDecorator();
+    if (!decorator)
+    {
+        handleMemoryError();
+        return NULL;
+    }
+
+    initDecorator(decorator, type, param);
+    return decorator;
+}
+
+Decorator *btArenaCreateEmptyDecorator(BtArena *arena)
+{
+    Decorator *decorator = (Decorator *)btArenaAlloc(arena, sizeof(Decorator));
+    if (!decorator)
+    {
+        handleMemoryError();
+        return NULL;
+    }
+    memset(decorator, 0, sizeof(Decorator));
+    return decorator;
+}
+
+Decorator *btArenaCreateRepeatDecorator(BtArena *arena, uint32_t repeatCount)
+{
+    return btArenaCreateDecorator(arena, DECORATOR_TYPE_REPEAT, &repeatCount);
+}
+
+Decorator *btArenaCreateDelayDecorator(BtArena *arena, uint32_t delayTime)
+{
+    return btArenaCreateDecorator(arena, DECORATOR_TYPE_DELAY, &delayTime);
+}
+
+Decorator *btArenaCreateConditionalDecorator(BtArena *arena)
+{
+    return btArenaCreateDecorator(arena, DECORATOR_TYPE_CONDITIONAL, NULL);
+}
+
+/**
+ * @brief Creates a decorator inside an arena.
+ *
+ * Arena counterpart of createDecorator. The decorator is released with the
+ * arena.
+ */
+Decorator *btArenaCreateDecorator(BtArena *arena, DecoratorType type, void *param)
+{
+    Decorator *decorator = btArenaCreateEmptyDecorator(arena);
+    initDecorator(decorator, type, param);
     return decorator;
 }
 
@@ -406,6 +1524,8 @@ static BehaviorNode *BehaviorNodeCheck(NodeType type, BehaviorNode *node)
         return checkDecoratorNode(node);
     case NODE_TYPE_MEMORY:
         return checkMemoryNode(node);
+    case NODE_TYPE_UTILITY:
+        return checkUtilityNode(node);
     default:
         return NULL;
     }
@@ -416,7 +1536,7 @@ static BehaviorNode *checkActionNode(BehaviorNode *node)
     if (node == NULL)
         return NULL;
 
-    if (node->action == NULL)
+    if (node->action == NULL && node->ctx_action == NULL && node->async == NULL)
         return NULL;
 
     if (node->children != NULL)
@@ -433,7 +1553,7 @@ static BehaviorNode *checkConditionNode(BehaviorNode *node)
     if (node == NULL)
         return NULL;
 
-    if (node->action == NULL)
+    if (node->action == NULL && node->ctx_action == NULL && node->async == NULL)
         return NULL;
 
     if (node->children != NULL)
@@ -533,19 +1653,62 @@ static BehaviorNode *checkParallelNode(BehaviorNode *node)
 /**
  * @brief Validates the structure of a memory node in the behavior tree.
  *
- * This function is intended to check if the given node meets the criteria for a valid memory node.
- * However, the current implementation always returns NULL, indicating that memory nodes are not
- * yet supported or implemented in this behavior tree system.
+ * A memory node is a sequence or selector that remembers its running child,
+ * so it has the same requirements: at least one child, no decorator, and no
+ * action function.
  *
  * @param node Pointer to the BehaviorNode structure to be checked.
  *             This node is expected to be of type NODE_TYPE_MEMORY.
  *
- * @return BehaviorNode* Always returns NULL in the current implementation, indicating
- *                       that memory nodes are not supported or the check fails.
+ * @return BehaviorNode* Returns the input node if it's a valid memory node,
+ *                       NULL otherwise (indicating an invalid memory node structure).
  */
 static BehaviorNode *checkMemoryNode(BehaviorNode *node)
 {
-    return NULL;
+    if (node == NULL)
+        return NULL;
+
+    if (node->children == NULL || node->decorator != NULL)
+        return NULL;
+
+    if (node->child_count == 0)
+        return NULL;
+
+    if (node->action != NULL || node->params.memory.kind > MEMORY_SELECTOR)
+        return NULL;
+
+    return node;
+}
+
+/**
+ * @brief Validates the structure of a utility node in the behavior tree.
+ *
+ * A valid utility node has at least one child, no decorator and no action
+ * function, and a scoring table with exactly one option per child.
+ *
+ * @param node Pointer to the BehaviorNode structure to be checked.
+ *             This node is expected to be of type NODE_TYPE_UTILITY.
+ *
+ * @return BehaviorNode* Returns the input node if it's a valid utility node,
+ *                       NULL otherwise (indicating an invalid utility node structure).
+ */
+static BehaviorNode *checkUtilityNode(BehaviorNode *node)
+{
+    if (node == NULL)
+        return NULL;
+
+    if (node->children == NULL || node->decorator != NULL)
+        return NULL;
+
+    if (node->child_count == 0 || node->action != NULL)
+        return NULL;
+
+    const BtUtility *table = node->params.utility.table;
+    if (table == NULL || btUtilityOptionCount(table) != (uint32_t)node->child_count ||
+        node->params.utility.mode > BT_UTILITY_WEIGHTED_RANDOM)
+        return NULL;
+
+    return node;
 }
 
 /**
@@ -576,56 +1739,77 @@ static BehaviorNode *checkDecoratorNode(BehaviorNode *node)
 
 // 释放行为树
 /**
- * @brief Recursively frees the memory allocated for a behavior tree.
+ * @brief Frees the memory allocated for a behavior tree.
  *
- * This function traverses the behavior tree starting from the given node,
- * recursively freeing all child nodes, managing decorators, and finally
- * freeing the node itself. It uses reference counting to ensure proper
- * memory management for shared nodes and decorators.
+ * reference_count counts the parents of a node, so a tree may be a DAG in
+ * which a subtree is shared by several parents (see btDedupTree). A node is
+ * freed together with its child array when its last parent is freed, and
+ * only then are its own children released; every node is therefore freed
+ * exactly once. A decorator is freed with its node unless its
+ * reference_count says it has further owners (0 and 1 both mean one owner).
+ * The counts are atomic: two threads may free two trees that share
+ * subtrees at the same time, and the shared nodes are freed once, by the
+ * thread that releases the last parent. The traversal uses a
+ * heap-allocated stack, so deep trees cannot overflow the C stack.
  *
  * @param node Pointer to the root BehaviorNode of the tree or subtree to be freed.
  *             If NULL, the function does nothing.
  *
- * @return void This function does not return a value.
+ * @return int 1 on success, 0 if node is NULL or is still the child of
+ *             another node, in which case nothing is freed.
  */
 int freeBehaviorTree(BehaviorNode *node)
 {
-    int result;
-    if (!node)
+    BehaviorNode **stack;
+    int capacity = 64, top = 0;
+
+    if (!node || atomic_load_explicit(&node->reference_count, memory_order_acquire) > 0)
     {
         return 0;
     }
-    // 递归释放子节点
-    for (int i = 0; i < node->child_count; i++)
+    stack = (BehaviorNode **)malloc(sizeof(BehaviorNode *) * (size_t)capacity);
+    if (!stack)
     {
-        if (node->children[i] == NULL)
-        {
-            return 0;
-        }
-        result = freeBehaviorTree(node->children[i]);
-        if (result == 0)
+        handleMemoryError();
+    }
+    stack[0] = node;
+
+    while (top >= 0)
+    {
+        node = stack[top--];
+
+        // 子节点只在最后一个父节点释放时释放
+        for (int i = 0; i < node->child_count; i++)
         {
-            return 0;
-        }
+            BehaviorNode *child = node->children[i];
+            // 最后一个父节点负责释放; acq_rel 保证其他线程对子树的写入先于释放
+            if (child == NULL || atomic_fetch_sub_explicit(&child->reference_count, 1, memory_order_acq_rel) > 1)
+            {
+                continue;
+            }
+            if (top + 1 == capacity)
+            {
+                BehaviorNode **grown = (BehaviorNode **)realloc(stack, sizeof(BehaviorNode *) * (size_t)capacity * 2);
+                if (!grown)
+                {
+                    handleMemoryError();
+                }
+                stack = grown;
+                capacity *= 2;
+            }
+            stack[++top] = child;
         }
 
-    // 管理 Decorator
-    if (node->decorator) // 确保 decorator 不为 NULL
-    {
-        // 减少引用计数
-        if (--node->decorator->reference_count == 0)
+        // 管理 Decorator
+        if (node->decorator &&
+            atomic_fetch_sub_explicit(&node->decorator->reference_count, 1, memory_order_acq_rel) <= 1)
         {
             free(node->decorator);
-            node->decorator = NULL;
         }
-    }
-
-    // 减少行为节点的引用计数并释放自身
-    if (--node->reference_count == 0)
-    {
+        free(node->children);
         free(node);
-        node = NULL;
     }
+    free(stack);
     return 1;
 }
 
@@ -1,3 +1,7 @@
+#ifndef BEHAVIOR_TREE_H
+#define BEHAVIOR_TREE_H
+
+#include <stdatomic.h>
 #include <stdint.h>
 
 typedef enum
@@ -8,51 +12,217 @@ typedef enum
     NODE_TYPE_SELECTOR,
     NODE_TYPE_PARALLEL,
     NODE_TYPE_DECORATOR,
-    NODE_TYPE_MEMORY
+    NODE_TYPE_MEMORY,
+    NODE_TYPE_UTILITY // 按得分选择一个子节点, 见 BehaviorTreeUtility.h
 } NodeType;
 
+/**
+ * @brief Result of ticking a node.
+ *
+ * BT_FAILURE and BT_SUCCESS keep the 0/1 values returned by executeNode, so
+ * existing actions stay valid. An action returns BT_RUNNING to tell tickTree
+ * that it has not finished yet and wants to be ticked again.
+ */
+typedef enum
+{
+    BT_FAILURE = 0,
+    BT_SUCCESS = 1,
+    BT_RUNNING = 2,
+    BT_IDLE = 3 // 尚未被 tick 过
+} NodeStatus;
+
 typedef enum
 {
     DECORATOR_TYPE_INVERT,
     DECORATOR_TYPE_REPEAT,
     DECORATOR_TYPE_REPEAT_UNTIL_SUCCESS,
     DECORATOR_TYPE_CONDITIONAL,
-    DECORATOR_TYPE_DELAY
+    DECORATOR_TYPE_DELAY,
+    DECORATOR_TYPE_TIMEOUT, // 子节点运行超过 params.timeout 毫秒则失败
+    DECORATOR_TYPE_COOLDOWN, // 子节点结束后 params.cooldown 毫秒内直接失败
+    DECORATOR_TYPE_CACHE     // 缓存子节点结果 params.ttl 毫秒, 见 BehaviorTreeCache.h
 } DecoratorType;
 
 typedef union
 {
     uint32_t delay;
     uint32_t repeat;
+    uint32_t timeout;  // 毫秒
+    uint32_t cooldown; // 毫秒
+    uint32_t ttl;      // 毫秒, 0 表示只在当前 tick 内有效
 } DecoratorParams;
 
+// params.delay 以毫秒为单位 (默认为秒)
+#define DECORATOR_FLAG_MILLISECONDS 0x1u
+
 typedef struct Decorator
 {
     DecoratorType type;
     DecoratorParams params;
-    int reference_count; // 引用计数
+    atomic_int reference_count; // 引用计数, 原子操作
+    uint32_t flags;
 } Decorator;
 
+// NODE_TYPE_MEMORY 的变体
+typedef enum
+{
+    MEMORY_SEQUENCE,
+    MEMORY_SELECTOR
+} MemoryKind;
+
+// NODE_TYPE_UTILITY 如何根据得分选择子节点
+typedef enum
+{
+    BT_UTILITY_MAX,            // 得分最高的子节点, 相同时取靠前的
+    BT_UTILITY_WEIGHTED_RANDOM // 按 max(得分, 0) 的比例随机选择
+} BtUtilityMode;
+
+/**
+ * @brief Per-type node parameters that do not belong to a decorator.
+ *
+ * parallel: the node succeeds once success_threshold children succeeded and
+ * fails once failure_threshold children failed. 0 selects the defaults: all
+ * children must succeed, and the node fails as soon as success is no longer
+ * reachable.
+ *
+ * memory: whether the memory node is a sequence or a selector.
+ *
+ * utility: the scoring table (one option per child) and the BtUtilityMode.
+ */
+typedef union
+{
+    struct
+    {
+        uint32_t success_threshold;
+        uint32_t failure_threshold;
+    } parallel;
+    struct
+    {
+        uint32_t kind; // MemoryKind
+    } memory;
+    struct
+    {
+        const struct BtUtility *table;
+        uint32_t mode; // BtUtilityMode
+    } utility;
+} NodeParams;
+
+/**
+ * @brief Runtime state kept between ticks.
+ *
+ * Only used by tickTree. The meaning of the fields depends on the node type:
+ * the delay decorator keeps its phase in running_child and its deadline (ms,
+ * wrapping) in counter, the repeat decorator keeps the finished iterations in
+ * counter, the parallel node reads the status of its children, the memory
+ * node keeps the index of the child it resumes from in running_child, and
+ * sequences and selectors keep the index + 1 of their running child there so
+ * that it can be halted when an earlier child takes over. Utility nodes keep
+ * the index + 1 of their running child too, and the state of their random
+ * generator in counter.
+ */
+typedef struct NodeState
+{
+    uint32_t running_child; // 正在运行的子节点 / 阶段
+    uint32_t counter;       // 装饰器计数 / 截止时间
+    uint8_t status;         // 上一次 tick 的结果 (NodeStatus)
+} NodeState;
+
+/**
+ * @brief Agent context handed to context actions.
+ *
+ * Lets one tree and one set of callbacks serve many agents: each agent has
+ * its own context and blackboard instead of globals in the callbacks.
+ */
+typedef struct Blackboard Blackboard;
+typedef struct BtContext
+{
+    void *agent;            // 调用者自定义的 agent 数据
+    Blackboard *blackboard; // agent 的黑板, 可为 NULL
+} BtContext;
+
 typedef struct BehaviorNode
 {
     Decorator *decorator;
     int (*action)(void); // Action function pointer
+    int (*ctx_action)(BtContext *ctx); // 带上下文的 action, 优先于 action
+    const struct BtAsyncAction *async; // 异步 action, 两者都为 NULL 时使用, 见 BehaviorTreeAsync.h
+    void (*halt)(BtContext *ctx); // 叶子节点在 RUNNING 时被中止时调用, 可为 NULL, 见 haltTree
     int child_count;
-    int reference_count; // 引用计数
+    atomic_int reference_count; // 父节点个数, 原子操作, 共享子树可以在多个线程中释放
     NodeType type;
     struct BehaviorNode **children;
+    NodeParams params; // 节点参数 (并行阈值等)
+    NodeState state;   // tick 模式下的运行状态
 } BehaviorNode;
 
+/**
+ * @brief Implementation used by executeNode and executeNodeWithContext.
+ *
+ * Both engines give the same results. The iterative one does not recurse,
+ * so deep trees cannot overflow the C stack (see BehaviorTreeIterative.h).
+ */
+typedef enum
+{
+    BT_ENGINE_RECURSIVE,
+    BT_ENGINE_ITERATIVE
+} BtEngine;
+
 // Function prototypes
+void btSetEngine(BtEngine engine);
+BtEngine btGetEngine(void);
 int executeNode(BehaviorNode *node);
+int executeNodeWithContext(BehaviorNode *node, BtContext *ctx);
+NodeStatus tickTree(BehaviorNode *root);
+NodeStatus tickTreeAt(BehaviorNode *root, uint64_t now_ms);
+NodeStatus tickTreeWithContext(BehaviorNode *root, BtContext *ctx, uint64_t now_ms);
+void haltTree(BehaviorNode *root);
+void haltTreeWithContext(BehaviorNode *root, BtContext *ctx);
+uint64_t btMonotonicMs(void);
 BehaviorNode *createBehaviorNode(BehaviorNode **children,
                                  int child_count,
                                  NodeType type,
                                  int (*actionFunc)(void));
+BehaviorNode *createContextNode(NodeType type, int (*ctxAction)(BtContext *ctx));
+BehaviorNode *createAsyncNode(NodeType type, const struct BtAsyncAction *async);
+BehaviorNode *createParallelNode(BehaviorNode **children,
+                                 int child_count,
+                                 uint32_t success_threshold,
+                                 uint32_t failure_threshold);
+BehaviorNode *createMemoryNode(BehaviorNode **children,
+                               int child_count,
+                               MemoryKind kind);
+BehaviorNode *createUtilityNode(BehaviorNode **children,
+                                int child_count,
+                                const struct BtUtility *table,
+                                BtUtilityMode mode);
 Decorator *createEmptyDecorator();
 Decorator *createRepeatDecorator(uint32_t repeatCount);
 Decorator *createDelayDecorator(uint32_t delayTime);
+Decorator *createDelayDecoratorMs(uint32_t delayMs);
+Decorator *createTimeoutDecorator(uint32_t timeoutMs);
+Decorator *createCooldownDecorator(uint32_t cooldownMs);
+Decorator *createCacheDecorator(uint32_t ttlMs);
+uint32_t btDecoratorDurationMs(const Decorator *decorator);
 Decorator *createConditionalDecorator();
 Decorator *createDecorator(DecoratorType type,
                            void *param);
-int freeBehaviorTree(BehaviorNode *node);
\ No newline at end of file
+int freeBehaviorTree(BehaviorNode *node);
+
+// Arena 版本: 节点、子节点数组和装饰器都放在同一个 arena 中, 随 btArenaDestroy 一次释放
+typedef struct BtArena BtArena;
+BehaviorNode *btArenaCreateBehaviorNode(BtArena *arena,
+                                        BehaviorNode **children,
+                                        int child_count,
+                                        NodeType type,
+                                        int (*actionFunc)(void));
+BehaviorNode *btArenaCreateContextNode(BtArena *arena, NodeType type, int (*ctxAction)(BtContext *ctx));
+BehaviorNode *btArenaCreateAsyncNode(BtArena *arena, NodeType type, const struct BtAsyncAction *async);
+Decorator *btArenaCreateEmptyDecorator(BtArena *arena);
+Decorator *btArenaCreateRepeatDecorator(BtArena *arena, uint32_t repeatCount);
+Decorator *btArenaCreateDelayDecorator(BtArena *arena, uint32_t delayTime);
+Decorator *btArenaCreateConditionalDecorator(BtArena *arena);
+Decorator *btArenaCreateDecorator(BtArena *arena,
+                                  DecoratorType type,
+                                  void *param);
+
+#endif // BEHAVIOR_TREE_H
@@ -0,0 +1,133 @@
+#include "BehaviorTreeArena.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+#define ARENA_ALIGN 16u
+#define ARENA_MIN_CHUNK 4096u
+
+typedef struct ArenaChunk
+{
+    struct ArenaChunk *next; // 上一个(更早的)块
+    size_t size;             // 可用字节数
+    size_t used;
+} ArenaChunk;
+
+struct BtArena
+{
+    ArenaChunk *current; // 当前分配的块
+    ArenaChunk *first;   // 与 arena 一起分配的块, reset 时保留
+    size_t total_used;
+};
+
+static size_t alignUp(size_t size)
+{
+    return (size + (ARENA_ALIGN - 1)) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+static unsigned char *chunkData(ArenaChunk *chunk)
+{
+    return (unsigned char *)chunk + alignUp(sizeof(ArenaChunk));
+}
+
+/**
+ * @brief Creates an arena for building behavior trees.
+ *
+ * The arena and its first chunk are one allocation. When a chunk is full a
+ * new one of at least twice the size is chained in, so a tree of n nodes
+ * costs O(log n) mallocs in total.
+ *
+ * @param capacity Expected number of bytes, 0 for a small default.
+ * @return BtArena* The new arena, or NULL if memory could not be allocated.
+ */
+BtArena *btArenaCreate(size_t capacity)
+{
+    size_t header = alignUp(sizeof(BtArena));
+    size_t size = alignUp(capacity < ARENA_MIN_CHUNK ? ARENA_MIN_CHUNK : capacity);
+    unsigned char *block = malloc(header + alignUp(sizeof(ArenaChunk)) + size);
+    if (!block)
+        return NULL;
+
+    BtArena *arena = (BtArena *)block;
+    ArenaChunk *chunk = (ArenaChunk *)(block + header);
+    chunk->next = NULL;
+    chunk->size = size;
+    chunk->used = 0;
+    arena->current = chunk;
+    arena->first = chunk;
+    arena->total_used = 0;
+    return arena;
+}
+
+/**
+ * @brief Allocates size bytes from the arena, aligned to 16 bytes.
+ *
+ * @return void* The memory, or NULL if a new chunk could not be allocated.
+ */
+void *btArenaAlloc(BtArena *arena, size_t size)
+{
+    ArenaChunk *chunk = arena->current;
+    size = alignUp(size);
+
+    if (chunk->size - chunk->used < size)
+    {
+        size_t chunkSize = chunk->size * 2;
+        if (chunkSize < size)
+            chunkSize = size;
+
+        ArenaChunk *grown = malloc(alignUp(sizeof(ArenaChunk)) + chunkSize);
+        if (!grown)
+            return NULL;
+        grown->next = chunk;
+        grown->size = chunkSize;
+        grown->used = 0;
+        arena->current = grown;
+        chunk = grown;
+    }
+
+    void *memory = chunkData(chunk) + chunk->used;
+    chunk->used += size;
+    arena->total_used += size;
+    return memory;
+}
+
+/**
+ * @brief Releases everything allocated from the arena but keeps the arena.
+ *
+ * Only the extra chunks are returned to the system; the first chunk is kept
+ * for the next tree.
+ */
+void btArenaReset(BtArena *arena)
+{
+    ArenaChunk *chunk = arena->current;
+    while (chunk != arena->first)
+    {
+        ArenaChunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    arena->first->used = 0;
+    arena->current = arena->first;
+    arena->total_used = 0;
+}
+
+/**
+ * @brief Frees the arena and every node and decorator created in it.
+ *
+ * No tree walk is needed: the cost depends on the number of chunks, not on
+ * the number of nodes.
+ */
+void btArenaDestroy(BtArena *arena)
+{
+    if (!arena)
+        return;
+    btArenaReset(arena);
+    free(arena);
+}
+
+/**
+ * @brief Returns the number of bytes handed out since creation or the last reset.
+ */
+size_t btArenaUsed(const BtArena *arena)
+{
+    return arena->total_used;
+}
@@ -0,0 +1,14 @@
+#ifndef BEHAVIOR_TREE_ARENA_H
+#define BEHAVIOR_TREE_ARENA_H
+
+#include <stddef.h>
+
+typedef struct BtArena BtArena;
+
+BtArena *btArenaCreate(size_t capacity);
+void *btArenaAlloc(BtArena *arena, size_t size);
+void btArenaReset(BtArena *arena);
+void btArenaDestroy(BtArena *arena);
+size_t btArenaUsed(const BtArena *arena);
+
+#endif // BEHAVIOR_TREE_ARENA_H
@@ -0,0 +1,352 @@
+#include "BehaviorTreeAsync.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#define ASYNC_BATCH 64
+#define ASYNC_INDEX_MASK 0xFFFFFFu // 句柄低 24 位: 下标 + 1, 高 8 位: 代数
+#define ASYNC_RUN_POLL_MS 10       // executeNode 等待时的轮询间隔, 其他线程可能先取走唤醒
+#define ASYNC_IN_USE 0x1u
+
+typedef struct AsyncSlot
+{
+    atomic_uchar status; // NodeStatus
+    atomic_uint tag;     // 代数 << 1 | 使用中; 释放后代数加一, 过期句柄不再匹配
+    int fd;              // 监视的描述符, -1 表示没有
+    BtAsyncReady ready;
+    void *user;
+    uint32_t next_free;  // 空闲链表, 下标 + 1
+} AsyncSlot;
+
+struct BtAsyncLoop
+{
+    int epoll_fd;
+    int event_fd;
+    uint32_t capacity;
+    uint32_t free_head; // 下标 + 1, 0 表示已满
+    uint32_t pending;   // 已分配的句柄数
+    atomic_uint signalled; // btAsyncComplete 的次数, 由 btAsyncPoll 取走
+    pthread_mutex_t lock;
+    AsyncSlot slots[];
+};
+
+static uint32_t tagOf(BtAsyncHandle handle)
+{
+    return ((handle >> 24) << 1) | ASYNC_IN_USE;
+}
+
+// 标记只在持锁时修改, 但 btAsyncResult 不加锁读取
+static AsyncSlot *slotOf(const BtAsyncLoop *loop, BtAsyncHandle handle)
+{
+    uint32_t index = (handle & ASYNC_INDEX_MASK) - 1;
+    if (handle == 0 || index >= loop->capacity)
+        return NULL;
+    AsyncSlot *slot = (AsyncSlot *)&loop->slots[index];
+    if (atomic_load_explicit(&slot->tag, memory_order_acquire) != tagOf(handle))
+        return NULL;
+    return slot;
+}
+
+/**
+ * @brief Creates an event loop for async actions.
+ *
+ * @param max_handles Maximum number of handles in flight (at most 2^24 - 1).
+ * @return BtAsyncLoop* The loop, or NULL if memory or descriptors ran out.
+ */
+BtAsyncLoop *btAsyncLoopCreate(uint32_t max_handles)
+{
+    if (max_handles == 0 || max_handles > ASYNC_INDEX_MASK)
+        return NULL;
+
+    BtAsyncLoop *loop = calloc(1, sizeof(BtAsyncLoop) + sizeof(AsyncSlot) * max_handles);
+    if (!loop)
+        return NULL;
+    loop->capacity = max_handles;
+    loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    loop->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    // eventfd 以 data.u32 = 0 注册, 句柄从不为 0
+    struct epoll_event event = {EPOLLIN, {.u32 = 0}};
+    if (loop->epoll_fd < 0 || loop->event_fd < 0 ||
+        epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, loop->event_fd, &event) != 0)
+    {
+        if (loop->epoll_fd >= 0)
+            close(loop->epoll_fd);
+        if (loop->event_fd >= 0)
+            close(loop->event_fd);
+        free(loop);
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < max_handles; i++)
+    {
+        loop->slots[i].fd = -1;
+        loop->slots[i].next_free = i + 2 <= max_handles ? i + 2 : 0;
+    }
+    loop->free_head = 1;
+    pthread_mutex_init(&loop->lock, NULL);
+    return loop;
+}
+
+/**
+ * @brief Destroys a loop. Watched descriptors are not closed.
+ */
+void btAsyncLoopDestroy(BtAsyncLoop *loop)
+{
+    if (!loop)
+        return;
+    close(loop->epoll_fd);
+    close(loop->event_fd);
+    pthread_mutex_destroy(&loop->lock);
+    free(loop);
+}
+
+/**
+ * @brief Returns the epoll descriptor, to wait for the loop inside another event loop.
+ */
+int btAsyncLoopFd(const BtAsyncLoop *loop)
+{
+    return loop->epoll_fd;
+}
+
+uint32_t btAsyncPending(const BtAsyncLoop *loop)
+{
+    return loop->pending;
+}
+
+/**
+ * @brief Allocates a handle in the BT_RUNNING state. Called by start callbacks.
+ *
+ * @return BtAsyncHandle The handle, or 0 if max_handles are in flight.
+ */
+BtAsyncHandle btAsyncBegin(BtAsyncLoop *loop)
+{
+    pthread_mutex_lock(&loop->lock);
+    uint32_t index = loop->free_head;
+    if (index == 0)
+    {
+        pthread_mutex_unlock(&loop->lock);
+        return 0;
+    }
+    AsyncSlot *slot = &loop->slots[index - 1];
+    loop->free_head = slot->next_free;
+    loop->pending++;
+    slot->fd = -1;
+    // release: 读到新状态的 btAsyncResult 也能看到之前释放时改过的标记
+    atomic_store_explicit(&slot->status, BT_RUNNING, memory_order_release);
+    uint32_t tag = atomic_load_explicit(&slot->tag, memory_order_relaxed) | ASYNC_IN_USE;
+    atomic_store_explicit(&slot->tag, tag, memory_order_release);
+    BtAsyncHandle handle = ((BtAsyncHandle)(tag >> 1) << 24) | index;
+    pthread_mutex_unlock(&loop->lock);
+    return handle;
+}
+
+/**
+ * @brief Completes a handle; safe to call from any thread.
+ *
+ * Completing a handle that was already released is ignored.
+ */
+void btAsyncComplete(BtAsyncLoop *loop, BtAsyncHandle handle, NodeStatus status)
+{
+    uint64_t one = 1;
+
+    pthread_mutex_lock(&loop->lock);
+    AsyncSlot *slot = slotOf(loop, handle);
+    if (slot)
+        atomic_store_explicit(&slot->status, status == BT_SUCCESS ? BT_SUCCESS : BT_FAILURE, memory_order_release);
+    pthread_mutex_unlock(&loop->lock);
+    if (!slot)
+        return;
+    atomic_fetch_add_explicit(&loop->signalled, 1, memory_order_relaxed);
+    while (write(loop->event_fd, &one, sizeof(one)) < 0 && errno == EINTR)
+        ;
+}
+
+/**
+ * @brief Completes the handle when fd becomes ready.
+ *
+ * @param events EPOLLIN, EPOLLOUT, ...; the descriptor is watched level-triggered.
+ * @param ready  Called by btAsyncPoll with the ready events; it returns
+ *               BT_RUNNING to keep watching or the result of the handle.
+ * @return int 1 on success, 0 if the handle is invalid, already watches a
+ *             descriptor, or epoll_ctl fails.
+ */
+int btAsyncWatchFd(BtAsyncLoop *loop, BtAsyncHandle handle, int fd, uint32_t events,
+                   BtAsyncReady ready, void *user)
+{
+    struct epoll_event event = {events, {.u32 = handle}};
+    int ok = 0;
+
+    pthread_mutex_lock(&loop->lock);
+    AsyncSlot *slot = slotOf(loop, handle);
+    if (slot && slot->fd < 0 && ready && epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, fd, &event) == 0)
+    {
+        slot->fd = fd;
+        slot->ready = ready;
+        slot->user = user;
+        ok = 1;
+    }
+    pthread_mutex_unlock(&loop->lock);
+    return ok;
+}
+
+// 调用者持有锁
+static void unwatch(BtAsyncLoop *loop, AsyncSlot *slot)
+{
+    epoll_ctl(loop->epoll_fd, EPOLL_CTL_DEL, slot->fd, NULL);
+    slot->fd = -1;
+}
+
+/**
+ * @brief Waits for ready descriptors and completions and dispatches them.
+ *
+ * Ready descriptors are collected up to 64 per epoll_wait; when a batch is
+ * full the loop is polled again without waiting, so one call drains
+ * everything that is ready.
+ *
+ * @param timeout_ms Like epoll_wait: -1 blocks, 0 returns at once.
+ * @return int Number of handles completed, -1 if epoll_wait fails.
+ */
+int btAsyncPoll(BtAsyncLoop *loop, int timeout_ms)
+{
+    struct epoll_event events[ASYNC_BATCH];
+    int completed = 0, count;
+
+    do
+    {
+        count = epoll_wait(loop->epoll_fd, events, ASYNC_BATCH, timeout_ms);
+        if (count < 0)
+            return errno == EINTR ? 0 : -1;
+        timeout_ms = 0;
+
+        pthread_mutex_lock(&loop->lock);
+        for (int i = 0; i < count; i++)
+        {
+            if (events[i].data.u32 == 0)
+            {
+                uint64_t value;
+                ssize_t ignored = read(loop->event_fd, &value, sizeof(value));
+                (void)ignored;
+                continue;
+            }
+            AsyncSlot *slot = slotOf(loop, events[i].data.u32);
+            if (!slot || slot->fd < 0)
+                continue; // 本批次中已释放
+            NodeStatus status = slot->ready(slot->fd, events[i].events, slot->user);
+            if (status == BT_RUNNING)
+                continue;
+            unwatch(loop, slot);
+            atomic_store_explicit(&slot->status, status == BT_SUCCESS ? BT_SUCCESS : BT_FAILURE,
+                                  memory_order_release);
+            completed++;
+        }
+        pthread_mutex_unlock(&loop->lock);
+    } while (count == ASYNC_BATCH);
+
+    return completed + (int)atomic_exchange_explicit(&loop->signalled, 0, memory_order_relaxed);
+}
+
+/**
+ * @brief Returns BT_RUNNING until the handle completes, then its result.
+ *
+ * Invalid or released handles report BT_FAILURE.
+ */
+NodeStatus btAsyncResult(const BtAsyncLoop *loop, BtAsyncHandle handle)
+{
+    const AsyncSlot *slot = slotOf(loop, handle);
+    if (!slot)
+        return BT_FAILURE;
+    NodeStatus status = (NodeStatus)atomic_load_explicit(&slot->status, memory_order_acquire);
+    // 读状态期间句柄可能在其他线程被释放并重新分配, 此时读到的不是它的状态
+    if (!slotOf(loop, handle))
+        return BT_FAILURE;
+    return status;
+}
+
+/**
+ * @brief Frees a handle. A handle still running is cancelled: its descriptor
+ * is no longer watched and a later btAsyncComplete is ignored.
+ */
+void btAsyncRelease(BtAsyncLoop *loop, BtAsyncHandle handle)
+{
+    pthread_mutex_lock(&loop->lock);
+    AsyncSlot *slot = slotOf(loop, handle);
+    if (slot)
+    {
+        if (slot->fd >= 0)
+            unwatch(loop, slot);
+        uint32_t generation = (atomic_load_explicit(&slot->tag, memory_order_relaxed) >> 1) + 1;
+        atomic_store_explicit(&slot->tag, (generation & 0xFFu) << 1, memory_order_release);
+        slot->next_free = loop->free_head;
+        loop->free_head = (uint32_t)(slot - loop->slots) + 1;
+        loop->pending--;
+    }
+    pthread_mutex_unlock(&loop->lock);
+}
+
+/**
+ * @brief Tick-mode step of an async leaf.
+ *
+ * The first tick starts the work; later ticks read the handle without
+ * blocking. The handle is released once its result has been reported.
+ */
+NodeStatus btAsyncTick(const BtAsyncAction *async, NodeState *state, BtContext *ctx)
+{
+    if (state->running_child == 0)
+    {
+        BtAsyncHandle handle = async->start(async->loop, ctx, async->user);
+        if (handle == 0)
+            return BT_FAILURE;
+        state->running_child = 1;
+        state->counter = (int)handle;
+    }
+
+    BtAsyncHandle handle = (BtAsyncHandle)state->counter;
+    NodeStatus status = btAsyncResult(async->loop, handle);
+    if (status == BT_RUNNING)
+        return BT_RUNNING;
+    btAsyncRelease(async->loop, handle);
+    state->running_child = 0;
+    state->counter = 0;
+    return status;
+}
+
+/**
+ * @brief Cancels the handle of a halted async leaf, see haltTree.
+ */
+void btAsyncHalt(const BtAsyncAction *async, NodeState *state)
+{
+    if (state->running_child == 0)
+        return;
+    btAsyncRelease(async->loop, (BtAsyncHandle)state->counter);
+    state->running_child = 0;
+    state->counter = 0;
+}
+
+/**
+ * @brief Runs an async leaf to completion, polling the loop while it waits.
+ *
+ * Used by executeNode and executeFlat, which have no RUNNING state. Other
+ * handles completed meanwhile are dispatched as well.
+ *
+ * @return int 1 if the handle succeeded, 0 otherwise.
+ */
+int btAsyncRun(const BtAsyncAction *async, BtContext *ctx)
+{
+    BtAsyncHandle handle = async->start(async->loop, ctx, async->user);
+    if (handle == 0)
+        return 0;
+
+    NodeStatus status;
+    while ((status = btAsyncResult(async->loop, handle)) == BT_RUNNING)
+    {
+        if (btAsyncPoll(async->loop, ASYNC_RUN_POLL_MS) < 0)
+            break;
+    }
+    btAsyncRelease(async->loop, handle);
+    return status == BT_SUCCESS;
+}
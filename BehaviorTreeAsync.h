@@ -0,0 +1,67 @@
+#ifndef BEHAVIOR_TREE_ASYNC_H
+#define BEHAVIOR_TREE_ASYNC_H
+
+#include "BehaviorTree.h"
+
+/*
+ * Asynchronous actions (Linux: epoll + eventfd).
+ *
+ * An async leaf does not run its work inside the tick. Its start callback
+ * begins the work and returns a handle from btAsyncBegin; the node then
+ * reports BT_RUNNING until the handle completes, so many leaves of many
+ * agents can be in flight at once. A handle completes either
+ *
+ *   - from any thread with btAsyncComplete (e.g. a worker that did a
+ *     blocking read), which wakes the loop through its eventfd, or
+ *   - when a file descriptor registered with btAsyncWatchFd becomes ready
+ *     and its ready callback returns a final status.
+ *
+ * The application calls btAsyncPoll once per frame (or blocks in it while
+ * nothing else is to do); it collects ready descriptors in batches of up to
+ * 64 per epoll_wait. tickTree and tickInstance then pick up the results on
+ * the next tick. executeNode and executeFlat wait for the handle, polling
+ * the loop themselves.
+ *
+ * In tick mode the node keeps the handle in its NodeState (running_child 1,
+ * counter the handle). Sequences and selectors tick their children again
+ * from the first one every tick, which starts a finished async leaf anew;
+ * put several async steps under a memory sequence.
+ */
+typedef struct BtAsyncLoop BtAsyncLoop;
+typedef uint32_t BtAsyncHandle; // 0 表示无效
+
+typedef struct BtAsyncAction
+{
+    BtAsyncLoop *loop;
+    // 开始工作并返回 btAsyncBegin 的句柄; 返回 0 表示无法开始, 节点失败
+    BtAsyncHandle (*start)(BtAsyncLoop *loop, BtContext *ctx, void *user);
+    void *user;
+} BtAsyncAction;
+
+/**
+ * @brief Called by btAsyncPoll when a watched descriptor is ready.
+ *
+ * Returns BT_RUNNING to keep waiting, otherwise the result of the handle.
+ * Runs under the loop's lock and must not call other btAsync functions.
+ */
+typedef NodeStatus (*BtAsyncReady)(int fd, uint32_t events, void *user);
+
+BtAsyncLoop *btAsyncLoopCreate(uint32_t max_handles);
+void btAsyncLoopDestroy(BtAsyncLoop *loop);
+int btAsyncLoopFd(const BtAsyncLoop *loop);
+uint32_t btAsyncPending(const BtAsyncLoop *loop);
+int btAsyncPoll(BtAsyncLoop *loop, int timeout_ms);
+
+BtAsyncHandle btAsyncBegin(BtAsyncLoop *loop);
+void btAsyncComplete(BtAsyncLoop *loop, BtAsyncHandle handle, NodeStatus status);
+int btAsyncWatchFd(BtAsyncLoop *loop, BtAsyncHandle handle, int fd, uint32_t events,
+                   BtAsyncReady ready, void *user);
+NodeStatus btAsyncResult(const BtAsyncLoop *loop, BtAsyncHandle handle);
+void btAsyncRelease(BtAsyncLoop *loop, BtAsyncHandle handle);
+
+// 引擎内部使用
+NodeStatus btAsyncTick(const BtAsyncAction *async, NodeState *state, BtContext *ctx);
+void btAsyncHalt(const BtAsyncAction *async, NodeState *state);
+int btAsyncRun(const BtAsyncAction *async, BtContext *ctx);
+
+#endif // BEHAVIOR_TREE_ASYNC_H
@@ -0,0 +1,247 @@
+#include "BehaviorTreeBinary.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct BtMappedTree
+{
+    BtFlatTree tree; // 数组指针指向映射的页
+    void *base;
+    size_t size;
+    BtAction actions[]; // 通过注册表解析出的 action 表
+};
+
+static size_t fileSize(uint32_t nodeCount, uint32_t actionCount, uint32_t namesSize)
+{
+    return sizeof(BtFileHeader) +
+           (3 * (size_t)nodeCount + actionCount) * sizeof(uint32_t) +
+           2 * (size_t)nodeCount + namesSize;
+}
+
+/**
+ * @brief Writes a compiled tree to a binary tree file.
+ *
+ * Every action of the tree must be registered in registry, its name is what
+ * the file stores.
+ *
+ * @return int 1 on success, 0 if an action has no name or the file could not be written.
+ */
+int btSaveTree(const BtFlatTree *tree, const BtRegistry *registry, const char *path)
+{
+    uint32_t *offsets = malloc(sizeof(uint32_t) * (tree->action_count ? tree->action_count : 1));
+    uint32_t namesSize = 0;
+
+    if (!offsets)
+        return 0;
+    if (tree->utility_count > 0)
+    {
+        free(offsets);
+        return 0; // 得分表是运行时对象, 文件中无法表示
+    }
+    for (uint32_t i = 0; i < tree->action_count; i++)
+    {
+        const char *name = btRegistryNameOf(registry, tree->actions[i]);
+        if (!name)
+        {
+            free(offsets);
+            return 0; // 未注册的 action 无法序列化
+        }
+        offsets[i] = namesSize;
+        namesSize += (uint32_t)strlen(name) + 1;
+    }
+
+    FILE *file = fopen(path, "wb");
+    if (!file)
+    {
+        free(offsets);
+        return 0;
+    }
+
+    BtFileHeader header = {0};
+    header.magic = BT_FILE_MAGIC;
+    header.version = BT_FILE_VERSION;
+    header.header_size = sizeof(BtFileHeader);
+    header.byte_order = BT_FILE_BYTE_ORDER;
+    header.node_count = tree->node_count;
+    header.action_count = tree->action_count;
+    header.names_size = namesSize;
+
+    size_t n = tree->node_count;
+    int ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+             fwrite(tree->subtree_end, sizeof(uint32_t), n, file) == n &&
+             fwrite(tree->dec_param, sizeof(uint32_t), n, file) == n &&
+             fwrite(tree->action, sizeof(uint32_t), n, file) == n &&
+             fwrite(offsets, sizeof(uint32_t), tree->action_count, file) == tree->action_count &&
+             fwrite(tree->kind, 1, n, file) == n &&
+             fwrite(tree->dec_type, 1, n, file) == n;
+    for (uint32_t i = 0; ok && i < tree->action_count; i++)
+    {
+        const char *name = btRegistryNameOf(registry, tree->actions[i]);
+        ok = fwrite(name, 1, strlen(name) + 1, file) == strlen(name) + 1;
+    }
+    free(offsets);
+    if (fclose(file) != 0)
+        ok = 0;
+    return ok;
+}
+
+/**
+ * @brief Checks that the node arrays describe a well-formed pre-order tree.
+ *
+ * Node kinds and decorator types must be known (utility nodes cannot be
+ * stored), subtree ranges must nest, leaves must reference an existing action,
+ * decorators must have a child and cache decorators an earlier cache
+ * decorator that holds their entry, so that the executors never index out
+ * of bounds.
+ */
+static int verifyNodes(const BtFlatTree *tree)
+{
+    uint32_t n = tree->node_count;
+    uint32_t *open = malloc(sizeof(uint32_t) * (n ? n : 1));
+    uint32_t depth = 0;
+
+    if (!open)
+        return 0;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        uint32_t end = tree->subtree_end[i];
+        while (depth > 0 && open[depth - 1] <= i)
+            depth--;
+        if (end <= i || end > (depth ? open[depth - 1] : n) || (i == 0 && end != n))
+            break;
+
+        uint8_t kind = tree->kind[i];
+        if (kind >= NODE_TYPE_UTILITY || tree->dec_type[i] > DECORATOR_TYPE_CACHE)
+            break; // 未知的类型; 文件中也没有得分表
+        if ((kind == NODE_TYPE_ACTION || kind == NODE_TYPE_CONDITION) &&
+            tree->action[i] >= tree->action_count)
+            break;
+        if (kind == NODE_TYPE_DECORATOR && end == i + 1)
+            break;
+        // 缓存条目必须在之前的同类节点中, 见 BtFlatTree
+        if (kind == NODE_TYPE_DECORATOR && tree->dec_type[i] == DECORATOR_TYPE_CACHE &&
+            (tree->action[i] > i || tree->kind[tree->action[i]] != NODE_TYPE_DECORATOR ||
+             tree->dec_type[tree->action[i]] != DECORATOR_TYPE_CACHE))
+            break;
+        open[depth++] = end;
+        if (i == n - 1)
+        {
+            free(open);
+            return 1;
+        }
+    }
+    free(open);
+    return 0;
+}
+
+/**
+ * @brief Maps a binary tree file and prepares it for execution in place.
+ *
+ * The node arrays are not copied: executeFlat and tickInstance read them from
+ * the mapped pages, which the page cache shares between processes. Only the
+ * action table is built, by looking every action name up in registry.
+ *
+ * @param flags BT_MAP_TRUSTED skips the per-node checks, so loading costs
+ *              O(actions) instead of O(nodes).
+ * @return BtMappedTree* The mapped tree, or NULL if the file cannot be read,
+ *                       is malformed, or names an unregistered action.
+ */
+BtMappedTree *btMapTree(const char *path, const BtRegistry *registry, uint32_t flags)
+{
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+
+    if (fd < 0)
+        return NULL;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(BtFileHeader))
+    {
+        close(fd);
+        return NULL;
+    }
+
+    size_t size = (size_t)st.st_size;
+    void *base = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+        return NULL;
+
+    const BtFileHeader *header = base;
+    if (header->magic != BT_FILE_MAGIC || header->version != BT_FILE_VERSION ||
+        header->byte_order != BT_FILE_BYTE_ORDER || header->header_size != sizeof(BtFileHeader) ||
+        header->node_count == 0 ||
+        fileSize(header->node_count, header->action_count, header->names_size) != size)
+    {
+        munmap(base, size);
+        return NULL;
+    }
+
+    uint32_t n = header->node_count;
+    BtMappedTree *mapped = malloc(sizeof(BtMappedTree) + sizeof(BtAction) * header->action_count);
+    if (!mapped)
+    {
+        munmap(base, size);
+        return NULL;
+    }
+    mapped->base = base;
+    mapped->size = size;
+
+    // 只读映射, 执行器不会写树
+    BtFlatTree *tree = &mapped->tree;
+    tree->node_count = n;
+    tree->action_count = header->action_count;
+    tree->utility_count = 0;
+    tree->utilities = NULL;
+    tree->subtree_end = (uint32_t *)(header + 1);
+    tree->dec_param = tree->subtree_end + n;
+    tree->action = tree->dec_param + n;
+    const uint32_t *nameOffset = tree->action + n;
+    tree->kind = (uint8_t *)(nameOffset + header->action_count);
+    tree->dec_type = tree->kind + n;
+    const char *names = (const char *)(tree->dec_type + n);
+    tree->actions = mapped->actions;
+
+    for (uint32_t i = 0; i < header->action_count; i++)
+    {
+        const BtAction *action = NULL;
+        // 名字必须在名字表内且以 NUL 结尾
+        if (nameOffset[i] < header->names_size &&
+            memchr(names + nameOffset[i], '\0', header->names_size - nameOffset[i]))
+            action = btRegistryFind(registry, names + nameOffset[i]);
+        if (!action)
+        {
+            btUnmapTree(mapped);
+            return NULL;
+        }
+        mapped->actions[i] = *action;
+    }
+
+    if (!(flags & BT_MAP_TRUSTED) && !verifyNodes(tree))
+    {
+        btUnmapTree(mapped);
+        return NULL;
+    }
+    return mapped;
+}
+
+/**
+ * @brief Returns the executable view of a mapped tree.
+ *
+ * Valid until btUnmapTree; pass it to executeFlat, btCreateInstances,
+ * tickInstance and friends like a compiled tree.
+ */
+const BtFlatTree *btMappedFlatTree(const BtMappedTree *mapped)
+{
+    return &mapped->tree;
+}
+
+void btUnmapTree(BtMappedTree *mapped)
+{
+    if (!mapped)
+        return;
+    munmap(mapped->base, mapped->size);
+    free(mapped);
+}
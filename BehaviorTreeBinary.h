@@ -0,0 +1,50 @@
+#ifndef BEHAVIOR_TREE_BINARY_H
+#define BEHAVIOR_TREE_BINARY_H
+
+#include "BehaviorTreeFlat.h"
+#include "BehaviorTreeRegistry.h"
+
+/*
+ * Binary tree file, version 1. All integers are in host byte order, which is
+ * recorded in the header, and every reference is an index or an offset, so
+ * the file can be mapped at any address:
+ *
+ *     BtFileHeader
+ *     uint32_t subtree_end[node_count]
+ *     uint32_t dec_param[node_count]
+ *     uint32_t action[node_count]
+ *     uint32_t name_offset[action_count]   // 指向名字表
+ *     uint8_t  kind[node_count]
+ *     uint8_t  dec_type[node_count]
+ *     char     names[names_size]           // 以 NUL 结尾的 action 名字
+ *
+ * The node arrays are exactly those of BtFlatTree, so a mapped file is
+ * executed in place by executeFlat and tickInstance.
+ */
+#define BT_FILE_MAGIC 0x45525442u // "BTRE"
+#define BT_FILE_VERSION 1u
+#define BT_FILE_BYTE_ORDER 0x01020304u
+
+typedef struct BtFileHeader
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;
+    uint32_t byte_order;
+    uint32_t node_count;
+    uint32_t action_count;
+    uint32_t names_size;
+    uint32_t reserved[2];
+} BtFileHeader;
+
+// btMapTree 的选项
+#define BT_MAP_TRUSTED 0x1u // 跳过逐节点校验, 只用于自己生成的文件
+
+typedef struct BtMappedTree BtMappedTree;
+
+int btSaveTree(const BtFlatTree *tree, const BtRegistry *registry, const char *path);
+BtMappedTree *btMapTree(const char *path, const BtRegistry *registry, uint32_t flags);
+const BtFlatTree *btMappedFlatTree(const BtMappedTree *mapped);
+void btUnmapTree(BtMappedTree *mapped);
+
+#endif // BEHAVIOR_TREE_BINARY_H
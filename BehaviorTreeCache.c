@@ -0,0 +1,32 @@
+#include "BehaviorTreeCache.h"
+
+atomic_uint btCacheGeneration;
+atomic_ullong btCacheHits;
+atomic_ullong btCacheMisses;
+atomic_flag btCacheEntryLocks[64]; // 静态存储期, 初始为清除状态
+
+/**
+ * @brief Drops every cached result, in all trees and instances.
+ *
+ * Call it when the world the cached conditions observe has changed in a way
+ * their TTL does not cover, e.g. after a teleport or a map reload.
+ */
+void btCacheInvalidateAll(void)
+{
+    atomic_fetch_add_explicit(&btCacheGeneration, 1, memory_order_relaxed);
+}
+
+/**
+ * @brief Reads the hit and miss counters of all cache decorators.
+ */
+void btCacheGetStats(BtCacheStats *out)
+{
+    out->hits = atomic_load_explicit(&btCacheHits, memory_order_relaxed);
+    out->misses = atomic_load_explicit(&btCacheMisses, memory_order_relaxed);
+}
+
+void btCacheResetStats(void)
+{
+    atomic_store_explicit(&btCacheHits, 0, memory_order_relaxed);
+    atomic_store_explicit(&btCacheMisses, 0, memory_order_relaxed);
+}
@@ -0,0 +1,101 @@
+#ifndef BEHAVIOR_TREE_CACHE_H
+#define BEHAVIOR_TREE_CACHE_H
+
+#include <stdatomic.h>
+#include "BehaviorTree.h"
+
+/*
+ * Result cache of DECORATOR_TYPE_CACHE.
+ *
+ * A cached result stays valid while all of the following hold:
+ *   - the cache generation has not changed (btCacheInvalidateAll),
+ *   - with a TTL of 0 (BT_CACHE_PER_TICK): it was stored during the current tick,
+ *   - with a TTL > 0: fewer than ttl milliseconds have passed.
+ * BT_RUNNING is never cached.
+ *
+ * The entry lives in the decorator's NodeState; in an instance of a compiled
+ * tree, every copy of a shared decorator uses the state of its first copy
+ * (see BtFlatTree). running_child holds the generation in the upper 30 bits
+ * and the cached value in the lower 2 bits (0 empty, 1 failure, 2 success);
+ * counter holds the tick serial or the expiry time in wrapping milliseconds.
+ *
+ * The tick serial is taken once when executeNode or tickTree is entered
+ * and handed down to every node of that call, including the children that
+ * executeNodeParallel runs on other threads. In a pointer tree the entry is
+ * shared by every thread running the tree, so it is read and written under a
+ * lock (btCacheLookupShared / btCacheStoreShared). Parallel children that
+ * reach the same cached node at the same time may both miss and run it.
+ */
+#define BT_CACHE_PER_TICK 0u
+
+typedef struct BtCacheStats
+{
+    uint64_t hits;
+    uint64_t misses;
+} BtCacheStats;
+
+void btCacheInvalidateAll(void);
+void btCacheGetStats(BtCacheStats *out);
+void btCacheResetStats(void);
+
+// 引擎内部使用
+extern atomic_uint btCacheGeneration;
+extern atomic_ullong btCacheHits;
+extern atomic_ullong btCacheMisses;
+extern atomic_flag btCacheEntryLocks[64];
+
+static inline int btCacheLookup(const NodeState *state, uint32_t ttl, uint32_t now, uint32_t tick, NodeStatus *out)
+{
+    uint32_t entry = state->running_child;
+    uint32_t generation = atomic_load_explicit(&btCacheGeneration, memory_order_relaxed);
+
+    if ((entry & 3u) != 0 && (entry >> 2) == (generation & 0x3FFFFFFFu) &&
+        (ttl == BT_CACHE_PER_TICK ? state->counter == tick : (int32_t)(now - state->counter) < 0))
+    {
+        atomic_fetch_add_explicit(&btCacheHits, 1, memory_order_relaxed);
+        *out = (entry & 3u) == 2u ? BT_SUCCESS : BT_FAILURE;
+        return 1;
+    }
+    atomic_fetch_add_explicit(&btCacheMisses, 1, memory_order_relaxed);
+    return 0;
+}
+
+static inline void btCacheStore(NodeState *state, uint32_t ttl, uint32_t now, uint32_t tick, NodeStatus status)
+{
+    if (status == BT_RUNNING)
+    {
+        state->running_child = 0;
+        return;
+    }
+    uint32_t generation = atomic_load_explicit(&btCacheGeneration, memory_order_relaxed);
+    state->running_child = (generation << 2) | (status == BT_SUCCESS ? 2u : 1u);
+    state->counter = ttl == BT_CACHE_PER_TICK ? tick : now + ttl;
+}
+
+// 指针树的条目按节点地址分段加锁, 只保护读写, 不在执行子节点时持有
+static inline atomic_flag *btCacheEntryLock(const NodeState *state)
+{
+    uintptr_t address = (uintptr_t)state;
+    return &btCacheEntryLocks[(address >> 4 ^ address >> 10) & 63u];
+}
+
+static inline int btCacheLookupShared(const NodeState *state, uint32_t ttl, uint32_t now, uint32_t tick, NodeStatus *out)
+{
+    atomic_flag *lock = btCacheEntryLock(state);
+    while (atomic_flag_test_and_set_explicit(lock, memory_order_acquire))
+        ;
+    int hit = btCacheLookup(state, ttl, now, tick, out);
+    atomic_flag_clear_explicit(lock, memory_order_release);
+    return hit;
+}
+
+static inline void btCacheStoreShared(NodeState *state, uint32_t ttl, uint32_t now, uint32_t tick, NodeStatus status)
+{
+    atomic_flag *lock = btCacheEntryLock(state);
+    while (atomic_flag_test_and_set_explicit(lock, memory_order_acquire))
+        ;
+    btCacheStore(state, ttl, now, tick, status);
+    atomic_flag_clear_explicit(lock, memory_order_release);
+}
+
+#endif // BEHAVIOR_TREE_CACHE_H
@@ -0,0 +1,268 @@
+#include "BehaviorTreeCodegen.h"
+#include <ctype.h>
+#include <stdlib.h>
+
+// 每隔这么多层拆出一个辅助函数, 避免生成的表达式括号嵌套过深
+#define CODEGEN_SPLIT_DEPTH 32u
+
+typedef struct
+{
+    const BtFlatTree *tree;
+    const BtRegistry *registry;
+    const char *prefix;
+    uint8_t *helper; // 节点是否生成为独立的辅助函数
+    FILE *out;
+} Codegen;
+
+static int validIdentifier(const char *name)
+{
+    if (!name || !(isalpha((unsigned char)*name) || *name == '_'))
+        return 0;
+    for (; *name; name++)
+    {
+        if (!isalnum((unsigned char)*name) && *name != '_')
+            return 0;
+    }
+    return 1;
+}
+
+static int supported(const BtFlatTree *tree, uint32_t index)
+{
+    if (tree->kind[index] == NODE_TYPE_DECORATOR)
+    {
+        switch (tree->dec_type[index])
+        {
+        case DECORATOR_TYPE_INVERT:
+        case DECORATOR_TYPE_REPEAT:
+        case DECORATOR_TYPE_REPEAT_UNTIL_SUCCESS:
+        case DECORATOR_TYPE_CONDITIONAL:
+            return 1;
+        default:
+            return 0;
+        }
+    }
+    return tree->kind[index] <= NODE_TYPE_MEMORY;
+}
+
+// 需要语句 (循环、计数) 的节点
+static int needsStatements(const BtFlatTree *tree, uint32_t index)
+{
+    if (tree->kind[index] == NODE_TYPE_PARALLEL)
+        return 1;
+    return tree->kind[index] == NODE_TYPE_DECORATOR &&
+           (tree->dec_type[index] == DECORATOR_TYPE_REPEAT ||
+            tree->dec_type[index] == DECORATOR_TYPE_REPEAT_UNTIL_SUCCESS);
+}
+
+static void emitExpr(Codegen *gen, uint32_t index, int inlineRoot);
+
+static void emitCall(Codegen *gen, uint32_t index)
+{
+    const BtFlatTree *tree = gen->tree;
+    const BtAction *action = &tree->actions[tree->action[index]];
+    const char *name = btRegistryNameOf(gen->registry, *action);
+
+    fprintf(gen->out, action->ctx_action ? "%s(ctx)" : "%s()", name);
+}
+
+// 用 op 连接所有子节点; 只有一个子节点时不加括号
+static void emitChain(Codegen *gen, uint32_t index, const char *op)
+{
+    const uint32_t *end = gen->tree->subtree_end;
+    int single = end[index + 1] == end[index];
+
+    if (!single)
+        fputc('(', gen->out);
+    for (uint32_t child = index + 1; child < end[index]; child = end[child])
+    {
+        if (child != index + 1)
+            fprintf(gen->out, " %s ", op);
+        emitExpr(gen, child, 0);
+    }
+    if (!single)
+        fputc(')', gen->out);
+}
+
+/**
+ * @brief Writes the expression of a node.
+ *
+ * Nodes that have their own helper are emitted as a call, unless inlineRoot
+ * is set because the helper body itself is being written.
+ */
+static void emitExpr(Codegen *gen, uint32_t index, int inlineRoot)
+{
+    const BtFlatTree *tree = gen->tree;
+    const uint32_t *end = tree->subtree_end;
+    uint32_t child = index + 1;
+
+    if (gen->helper[index] && !inlineRoot)
+    {
+        fprintf(gen->out, "%s_n%u(ctx)", gen->prefix, index);
+        return;
+    }
+
+    switch (tree->kind[index])
+    {
+    case NODE_TYPE_ACTION:
+    case NODE_TYPE_CONDITION:
+        emitCall(gen, index);
+        break;
+    case NODE_TYPE_SEQUENCE:
+        emitChain(gen, index, "&&");
+        break;
+    case NODE_TYPE_SELECTOR:
+        emitChain(gen, index, "||");
+        break;
+    case NODE_TYPE_MEMORY:
+        // 一次执行完整棵树, 与 executeFlat 相同
+        emitChain(gen, index, tree->dec_param[index] == MEMORY_SELECTOR ? "||" : "&&");
+        break;
+    default: // 装饰器, 循环类的已经由 helper 处理
+        if (tree->dec_type[index] == DECORATOR_TYPE_INVERT)
+        {
+            fputs("!", gen->out);
+            emitExpr(gen, child, 0);
+            break;
+        }
+        // conditional: 条件 ? then : else
+        if (end[child] >= end[index])
+        {
+            emitExpr(gen, child, 0);
+            break;
+        }
+        fputc('(', gen->out);
+        emitExpr(gen, child, 0);
+        fputs(" ? ", gen->out);
+        emitExpr(gen, end[child], 0);
+        fputs(" : ", gen->out);
+        if (end[end[child]] < end[index])
+            emitExpr(gen, end[end[child]], 0);
+        else
+            fputc('0', gen->out);
+        fputc(')', gen->out);
+        break;
+    }
+}
+
+static void emitHelper(Codegen *gen, uint32_t index)
+{
+    const BtFlatTree *tree = gen->tree;
+    const uint32_t *end = tree->subtree_end;
+    FILE *out = gen->out;
+
+    fprintf(out, "static inline int %s_n%u(BtContext *ctx)\n{\n    (void)ctx;\n", gen->prefix, index);
+    if (tree->kind[index] == NODE_TYPE_PARALLEL)
+    {
+        // 按子节点顺序执行, 第一个达到的阈值决定结果
+        fputs("    uint32_t successes = 0, failures = 0;\n", out);
+        for (uint32_t child = index + 1; child < end[index]; child = end[child])
+        {
+            fputs("    if (", out);
+            emitExpr(gen, child, 0);
+            fprintf(out, ")\n    {\n        if (++successes >= %uu)\n            return 1;\n    }\n", tree->dec_param[index]);
+            fprintf(out, "    else if (++failures >= %uu)\n    {\n        return 0;\n    }\n", tree->action[index]);
+        }
+        fputs("    return 0;\n", out);
+    }
+    else if (tree->kind[index] == NODE_TYPE_DECORATOR && tree->dec_type[index] == DECORATOR_TYPE_REPEAT)
+    {
+        fputs("    int result = 0;\n", out);
+        fprintf(out, "    for (uint32_t i = 0; i < %uu; i++)\n        result = ", tree->dec_param[index]);
+        emitExpr(gen, index + 1, 0);
+        fputs(";\n    return result;\n", out);
+    }
+    else if (tree->kind[index] == NODE_TYPE_DECORATOR && tree->dec_type[index] == DECORATOR_TYPE_REPEAT_UNTIL_SUCCESS)
+    {
+        fputs("    int result;\n    while (!(result = ", out);
+        emitExpr(gen, index + 1, 0);
+        fputs("))\n        ;\n    return result;\n", out);
+    }
+    else
+    {
+        fputs("    return ", out);
+        emitExpr(gen, index, 1);
+        fputs(";\n", out);
+    }
+    fputs("}\n\n", out);
+}
+
+/**
+ * @brief Emits C source that executes a compiled tree.
+ *
+ * The output defines `int function_name(BtContext *ctx)`, equivalent to
+ * executeFlat(tree, ctx), and helpers prefixed with function_name.
+ *
+ * @param registry      Gives the C name of every action; names must be valid identifiers.
+ * @param include       Header to #include for the action declarations (e.g.
+ *                      static inline definitions), or NULL to emit extern
+ *                      prototypes.
+ * @return int 1 on success, 0 if the tree uses an unsupported decorator, a utility node,
+ *             an async action or an action without a valid name.
+ */
+int btGenerateC(const BtFlatTree *tree, const BtRegistry *registry,
+                const char *function_name, const char *include, FILE *out)
+{
+    uint32_t n = tree->node_count;
+
+    if (n == 0 || !validIdentifier(function_name))
+        return 0;
+    for (uint32_t i = 0; i < tree->action_count; i++)
+    {
+        // 异步动作需要事件循环, 生成的代码不支持
+        if (tree->actions[i].async || !validIdentifier(btRegistryNameOf(registry, tree->actions[i])))
+            return 0;
+    }
+    for (uint32_t i = 0; i < n; i++)
+    {
+        if (!supported(tree, i))
+            return 0;
+    }
+
+    Codegen gen = {tree, registry, function_name, calloc(n, 1), out};
+    uint32_t *depth = malloc(sizeof(uint32_t) * n);
+    if (!gen.helper || !depth)
+    {
+        free(gen.helper);
+        free(depth);
+        return 0;
+    }
+
+    // 深度按先序计算: 子节点深度 = 父节点 + 1
+    depth[0] = 0;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        for (uint32_t child = i + 1; child < tree->subtree_end[i]; child = tree->subtree_end[child])
+            depth[child] = depth[i] + 1;
+        gen.helper[i] = i > 0 && (needsStatements(tree, i) || depth[i] % CODEGEN_SPLIT_DEPTH == 0);
+    }
+    gen.helper[0] = needsStatements(tree, 0);
+
+    fprintf(out, "/* Generated by btGenerateC, do not edit. */\n#include <stdint.h>\n#include \"BehaviorTree.h\"\n");
+    if (include)
+        fprintf(out, "#include \"%s\"\n", include);
+    fputc('\n', out);
+    if (!include)
+    {
+        for (uint32_t i = 0; i < tree->action_count; i++)
+        {
+            const char *name = btRegistryNameOf(registry, tree->actions[i]);
+            fprintf(out, tree->actions[i].ctx_action ? "int %s(BtContext *ctx);\n" : "int %s(void);\n", name);
+        }
+        fputc('\n', out);
+    }
+
+    // 子孙节点下标更大, 倒序输出保证辅助函数先定义后使用
+    for (uint32_t i = n; i-- > 0;)
+    {
+        if (gen.helper[i])
+            emitHelper(&gen, i);
+    }
+
+    fprintf(out, "int %s(BtContext *ctx)\n{\n    (void)ctx;\n    return ", function_name);
+    emitExpr(&gen, 0, 0);
+    fputs(";\n}\n", out);
+
+    free(gen.helper);
+    free(depth);
+    return !ferror(out);
+}
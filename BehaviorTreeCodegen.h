@@ -0,0 +1,27 @@
+#ifndef BEHAVIOR_TREE_CODEGEN_H
+#define BEHAVIOR_TREE_CODEGEN_H
+
+#include <stdio.h>
+#include "BehaviorTreeFlat.h"
+#include "BehaviorTreeRegistry.h"
+
+/*
+ * Ahead-of-time compilation of a tree into plain C.
+ *
+ * The generated function has the semantics of executeFlat: sequences become
+ * && chains, selectors || chains, invert a '!', and loops and parallel nodes
+ * small static inline helpers, so the C compiler sees the whole tree and can
+ * inline it. Actions are called by the names they are registered under.
+ *
+ * Typical build step: a small generator program registers the same actions
+ * as the application, loads the tree and calls btGenerateC; the output is
+ * compiled into the application (see bench/codegen_gen.c).
+ *
+ * Delay, timeout, cooldown and cache decorators keep state or sleep and are
+ * not supported; trees using them must stay interpreted.
+ */
+
+int btGenerateC(const BtFlatTree *tree, const BtRegistry *registry,
+                const char *function_name, const char *include, FILE *out);
+
+#endif // BEHAVIOR_TREE_CODEGEN_H
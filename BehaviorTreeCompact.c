@@ -0,0 +1,496 @@
+#include "BehaviorTreeCompact.h"
+#include "BehaviorTreeAsync.h"
+#include "BehaviorTreeInternal.h"
+#include "BehaviorTreeUtility.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define COMPACT_INITIAL_CAPACITY 256u
+
+_Static_assert(sizeof(BtCompactNode) == 16, "BtCompactNode must stay 16 bytes");
+_Static_assert(NODE_TYPE_UTILITY <= 0xF && DECORATOR_TYPE_CACHE <= 0xF, "node and decorator types need 4 bits");
+
+// 可达的不同节点, 按广度优先编号, 同一节点的子节点编号通常相邻
+typedef struct
+{
+    BtPtrMap table; // 节点 -> 下标 (index) 与父节点个数 (extra)
+    BehaviorNode **order;
+    uint32_t count;
+    uint32_t edges;
+    uint32_t utilities;
+    BtActionMap actions;
+} Collect;
+
+// executeCompact 中加权随机选择的状态, 见 btUtilityChoose
+static _Thread_local uint32_t executeRandom;
+
+static int runCompact(const BtCompactTree *tree, BtContext *ctx, uint32_t index);
+
+static void collectFree(Collect *collect)
+{
+    btPtrMapFree(&collect->table);
+    free(collect->order);
+    btActionMapFree(&collect->actions);
+}
+
+// 记录节点的下标, 它的第一个父节点已经找到
+static int addNode(BtPtrMap *table, const BehaviorNode *node, uint32_t index)
+{
+    BtPtrSlot *slot = btPtrMapInsert(table, node);
+    if (!slot)
+        return 0;
+    slot->index = index;
+    slot->extra = 1;
+    return 1;
+}
+
+// 子节点的下标是否连续, 即可以直接用 nodes[first + i] 访问
+static int consecutive(const Collect *collect, const BehaviorNode *node)
+{
+    if (node->child_count == 0)
+        return 1;
+    uint32_t first = btPtrMapFind(&collect->table, node->children[0])->index;
+    for (int c = 1; c < node->child_count; c++)
+    {
+        if (btPtrMapFind(&collect->table, node->children[c])->index != first + (uint32_t)c)
+            return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Numbers the distinct nodes reachable from root and collects their
+ * actions.
+ *
+ * Nodes are numbered breadth first, so the children of one node get
+ * consecutive numbers unless one of them was reached earlier through another
+ * parent; such a node is numbered once and its parents are counted. edges
+ * counts the child slots of the nodes whose children are not consecutive.
+ *
+ * @return int 1 on success, 0 if the tree is invalid or memory ran out.
+ */
+static int collectTree(BehaviorNode *root, Collect *collect)
+{
+    uint32_t capacity = COMPACT_INITIAL_CAPACITY;
+    uint32_t unused;
+
+    memset(collect, 0, sizeof(*collect));
+    collect->order = malloc(capacity * sizeof(BehaviorNode *));
+    if (!collect->order || !btPtrMapInit(&collect->table) || !addNode(&collect->table, root, 0))
+        return 0;
+    collect->order[collect->count++] = root;
+
+    for (uint32_t i = 0; i < collect->count; i++)
+    {
+        BehaviorNode *node = collect->order[i];
+        if ((node->type == NODE_TYPE_DECORATOR && node->decorator == NULL) || node->child_count < 0 ||
+            (uint32_t)node->child_count > BT_COMPACT_MAX_CHILDREN)
+            return 0;
+        collect->utilities += node->type == NODE_TYPE_UTILITY;
+        if ((node->action || node->ctx_action || node->async) &&
+            !btActionMapInsert(&collect->actions, (BtAction){node->action, node->ctx_action, node->async, node->halt},
+                             &unused))
+            return 0;
+
+        for (int c = 0; c < node->child_count; c++)
+        {
+            BehaviorNode *child = node->children[c];
+            if (child == NULL)
+                return 0;
+            BtPtrSlot *slot = btPtrMapFind(&collect->table, child);
+            if (slot->key)
+            {
+                slot->extra++;
+                continue;
+            }
+            if (collect->count == capacity)
+            {
+                if (capacity > UINT32_MAX / 2)
+                    return 0;
+                BehaviorNode **grown = realloc(collect->order, (size_t)capacity * 2 * sizeof(BehaviorNode *));
+                if (!grown)
+                    return 0;
+                collect->order = grown;
+                capacity *= 2;
+            }
+            if (!addNode(&collect->table, child, collect->count))
+                return 0;
+            collect->order[collect->count++] = child;
+        }
+    }
+
+    // 只有子节点下标不连续的节点需要 children 中的下标
+    for (uint32_t i = 0; i < collect->count; i++)
+    {
+        uint32_t count = (uint32_t)collect->order[i]->child_count;
+        if (consecutive(collect, collect->order[i]))
+            continue;
+        if (collect->edges > UINT32_MAX - count)
+            return 0;
+        collect->edges += count;
+    }
+    return 1;
+}
+
+static void fillNode(BtCompactTree *tree, BtCompactNode *out, BehaviorNode *node, Collect *collect)
+{
+    uint32_t decorator = 0;
+    uint32_t flags = btPtrMapFind(&collect->table, node)->extra > 1 ? BT_COMPACT_SHARED : 0;
+
+    out->param = 0;
+    out->extra = 0;
+    if (node->action || node->ctx_action || node->async)
+        btActionMapInsert(&collect->actions, (BtAction){node->action, node->ctx_action, node->async, node->halt},
+                        &out->extra); // 第一遍已插入, 不会失败
+
+    if (node->type == NODE_TYPE_MEMORY)
+    {
+        out->param = node->params.memory.kind;
+    }
+    else if (node->type == NODE_TYPE_UTILITY)
+    {
+        out->param = node->params.utility.mode;
+        out->extra = tree->utility_count;
+        tree->utilities[tree->utility_count++] = node->params.utility.table;
+    }
+    else if (node->type == NODE_TYPE_PARALLEL)
+    {
+        uint32_t count = (uint32_t)node->child_count;
+        uint32_t success = node->params.parallel.success_threshold;
+        uint32_t failure = node->params.parallel.failure_threshold;
+        if (success == 0 || success > count)
+            success = count;
+        out->param = success;
+        out->extra = failure ? failure : count - success + 1;
+    }
+    else if (node->type == NODE_TYPE_DECORATOR)
+    {
+        decorator = (uint32_t)node->decorator->type;
+        if (node->decorator->type == DECORATOR_TYPE_DELAY ||
+            node->decorator->type == DECORATOR_TYPE_TIMEOUT ||
+            node->decorator->type == DECORATOR_TYPE_COOLDOWN)
+            out->param = btDecoratorDurationMs(node->decorator); // 统一为毫秒
+        else
+            out->param = node->decorator->params.repeat;
+    }
+
+    if (consecutive(collect, node))
+    {
+        out->first = node->child_count ? btPtrMapFind(&collect->table, node->children[0])->index : 0;
+    }
+    else
+    {
+        flags |= BT_COMPACT_INDIRECT;
+        out->first = tree->edge_count;
+        for (int c = 0; c < node->child_count; c++)
+            tree->children[tree->edge_count++] = btPtrMapFind(&collect->table, node->children[c])->index;
+    }
+    out->bits = ((uint32_t)node->type & 0xFu) | (decorator << 4) | (flags << 8) | ((uint32_t)node->child_count << 12);
+}
+
+/**
+ * @brief Builds the compact form of a pointer-based behavior tree.
+ *
+ * Shared subtrees stay shared: every distinct node is stored once. The whole
+ * result lives in a single allocation; the source tree is not modified and
+ * can be freed independently.
+ *
+ * @param root Pointer to the root BehaviorNode of the tree.
+ * @return BtCompactTree* The compact tree, or NULL if the tree is invalid
+ *                        (NULL child, decorator node without a decorator,
+ *                        more than BT_COMPACT_MAX_CHILDREN children) or
+ *                        memory could not be allocated.
+ */
+BtCompactTree *btCompactTree(BehaviorNode *root)
+{
+    Collect collect;
+
+    if (!root)
+        return NULL;
+    if (!collectTree(root, &collect))
+    {
+        collectFree(&collect);
+        return NULL;
+    }
+
+    // 单块分配: 结构体 | action 表 | 得分表指针 | 节点 | 子节点下标
+    size_t actionCount = collect.actions.count ? collect.actions.count : 1;
+    size_t size = sizeof(BtCompactTree) +
+                  actionCount * sizeof(BtAction) +
+                  collect.utilities * sizeof(const BtUtility *) +
+                  (size_t)collect.count * sizeof(BtCompactNode) +
+                  (size_t)collect.edges * sizeof(uint32_t);
+    BtCompactTree *tree = malloc(size);
+    if (!tree)
+    {
+        collectFree(&collect);
+        return NULL;
+    }
+
+    tree->node_count = collect.count;
+    tree->edge_count = 0;    // 由 fillNode 填写
+    tree->action_count = collect.actions.count;
+    tree->utility_count = 0; // 由 fillNode 填写
+    tree->actions = (BtAction *)(tree + 1);
+    tree->utilities = (const BtUtility **)(tree->actions + actionCount);
+    tree->nodes = (BtCompactNode *)(tree->utilities + collect.utilities);
+    tree->children = (uint32_t *)(tree->nodes + collect.count);
+
+    for (uint32_t i = 0; i < collect.actions.capacity; i++)
+    {
+        if (!btActionIsEmpty(collect.actions.keys[i]))
+            tree->actions[collect.actions.values[i]] = collect.actions.keys[i];
+    }
+    for (uint32_t i = 0; i < collect.count; i++)
+        fillNode(tree, &tree->nodes[i], collect.order[i], &collect);
+
+    collectFree(&collect);
+    return tree;
+}
+
+/**
+ * @brief Returns the size of the single allocation behind a compact tree.
+ */
+size_t btCompactBytes(const BtCompactTree *tree)
+{
+    if (!tree)
+        return 0;
+    return sizeof(BtCompactTree) +
+           (tree->action_count ? tree->action_count : 1) * sizeof(BtAction) +
+           tree->utility_count * sizeof(const BtUtility *) +
+           (size_t)tree->node_count * sizeof(BtCompactNode) +
+           (size_t)tree->edge_count * sizeof(uint32_t);
+}
+
+/**
+ * @brief Frees a tree returned by btCompactTree.
+ */
+void btFreeCompactTree(BtCompactTree *tree)
+{
+    free(tree);
+}
+
+/**
+ * @brief Executes a compact tree.
+ *
+ * Same semantics as executeFlat: cooldown and cache decorators keep no state
+ * between calls and simply run their child.
+ *
+ * @param tree Pointer to a tree returned by btCompactTree.
+ * @param ctx  Agent context passed to context actions, may be NULL.
+ * @return int Returns 1 if the tree succeeds, 0 if it fails.
+ */
+int executeCompact(const BtCompactTree *tree, BtContext *ctx)
+{
+    if (tree == NULL || tree->node_count == 0)
+        return 0;
+    return runCompact(tree, ctx, 0);
+}
+
+static inline int callCompactAction(const BtCompactTree *tree, BtContext *ctx, const BtCompactNode *node)
+{
+    const BtAction *action = &tree->actions[node->extra];
+    if (action->ctx_action)
+        return action->ctx_action(ctx);
+    if (action->action)
+        return action->action();
+    return btAsyncRun(action->async, ctx);
+}
+
+// 叶子节点直接调用, 省去一次递归
+static inline int runCompactChild(const BtCompactTree *tree, BtContext *ctx, uint32_t index)
+{
+    const BtCompactNode *node = &tree->nodes[index];
+    if (btCompactType(node) <= NODE_TYPE_CONDITION)
+        return callCompactAction(tree, ctx, node);
+    return runCompact(tree, ctx, index);
+}
+
+// btRunDecorator 的回调
+static int runCompactAt(const void *tree, BtContext *ctx, uint32_t index)
+{
+    return runCompactChild((const BtCompactTree *)tree, ctx, index);
+}
+
+static int runCompactDecorator(const BtCompactTree *tree, BtContext *ctx, const BtCompactNode *node)
+{
+    uint32_t count = btCompactChildCount(node);
+    uint32_t children[3];
+
+    if (count > 3)
+        count = 3;
+    for (uint32_t i = 0; i < count; i++)
+        children[i] = btCompactChild(tree, node, i);
+    return btRunDecorator(tree, ctx, btCompactDecorator(node), node->param, children, count, runCompactAt);
+}
+
+static int runCompact(const BtCompactTree *tree, BtContext *ctx, uint32_t index)
+{
+    const BtCompactNode *node = &tree->nodes[index];
+    uint32_t count = btCompactChildCount(node);
+
+    switch (btCompactType(node))
+    {
+    case NODE_TYPE_ACTION:
+    case NODE_TYPE_CONDITION:
+        return callCompactAction(tree, ctx, node);
+    case NODE_TYPE_SELECTOR:
+        for (uint32_t i = 0; i < count; i++)
+        {
+            if (runCompactChild(tree, ctx, btCompactChild(tree, node, i)))
+                return 1;
+        }
+        return 0;
+    case NODE_TYPE_MEMORY:
+        // 一次执行完所有子节点, 与普通 sequence/selector 相同
+        if (node->param == MEMORY_SELECTOR)
+        {
+            for (uint32_t i = 0; i < count; i++)
+            {
+                if (runCompactChild(tree, ctx, btCompactChild(tree, node, i)))
+                    return 1;
+            }
+            return 0;
+        }
+        for (uint32_t i = 0; i < count; i++)
+        {
+            if (!runCompactChild(tree, ctx, btCompactChild(tree, node, i)))
+                return 0;
+        }
+        return 1;
+    case NODE_TYPE_SEQUENCE:
+        for (uint32_t i = 0; i < count; i++)
+        {
+            if (!runCompactChild(tree, ctx, btCompactChild(tree, node, i)))
+                return 0;
+        }
+        return 1;
+    case NODE_TYPE_PARALLEL:
+    {
+        // 按子节点顺序执行, 第一个达到的阈值决定结果, 与 executeNode 一致
+        uint32_t successCount = 0, failureCount = 0;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            if (runCompactChild(tree, ctx, btCompactChild(tree, node, i)))
+            {
+                if (++successCount >= node->param)
+                    return 1;
+            }
+            else if (++failureCount >= node->extra)
+            {
+                return 0;
+            }
+        }
+        return 0;
+    }
+    case NODE_TYPE_DECORATOR:
+        return runCompactDecorator(tree, ctx, node);
+    case NODE_TYPE_UTILITY:
+    {
+        // 选中的选项直接定位, 不必沿兄弟链查找
+        const BtUtility *table = tree->utilities[node->extra];
+        uint32_t option = btUtilityChoose(table, ctx, (BtUtilityMode)node->param, &executeRandom);
+        return option < count ? runCompactChild(tree, ctx, btCompactChild(tree, node, option)) : 0;
+    }
+    default:
+        return 0;
+    }
+}
+
+// 典型 64 位 malloc 的块大小: 8 字节块头, 按 16 字节取整, 最小 32 字节
+static size_t heapChunk(size_t size)
+{
+    size_t chunk = (size + 8 + 15) & ~(size_t)15;
+    return chunk < 32 ? 32 : chunk;
+}
+
+/**
+ * @brief Measures the memory of a tree as pointer nodes, as a BtFlatTree
+ * and as a BtCompactTree.
+ *
+ * The pointer layout is counted as createBehaviorNode and createDecorator
+ * allocate it: one block per node, one per non-empty child array and one per
+ * decorator. Nodes and decorators shared by several parents are counted once.
+ *
+ * @return int 1 on success, 0 if the tree is invalid or memory ran out.
+ */
+int btMeasureFootprint(BehaviorNode *root, BtFootprint *out)
+{
+    Collect collect;
+    BtPtrMap decorators = {0};
+    BtFlatTree *flat = NULL;
+    BtCompactTree *compact = NULL;
+    int ok = 0;
+
+    memset(out, 0, sizeof(*out));
+    if (!root)
+        return 0;
+    if (!collectTree(root, &collect) || !btPtrMapInit(&decorators))
+        goto done;
+
+    for (uint32_t i = 0; i < collect.count; i++)
+    {
+        const BehaviorNode *node = collect.order[i];
+        out->pointer_bytes += sizeof(BehaviorNode);
+        out->pointer_heap += heapChunk(sizeof(BehaviorNode));
+        out->blocks++;
+        if (node->child_count > 0)
+        {
+            size_t bytes = (size_t)node->child_count * sizeof(BehaviorNode *);
+            out->pointer_bytes += bytes;
+            out->pointer_heap += heapChunk(bytes);
+            out->blocks++;
+        }
+        if (node->decorator && !btPtrMapFind(&decorators, node->decorator)->key)
+        {
+            if (!btPtrMapInsert(&decorators, node->decorator))
+                goto done;
+            out->pointer_bytes += sizeof(Decorator);
+            out->pointer_heap += heapChunk(sizeof(Decorator));
+            out->blocks++;
+        }
+    }
+    out->nodes = collect.count;
+    out->decorators = decorators.count;
+
+    flat = btCompileTree(root);
+    compact = btCompactTree(root);
+    if (!flat || !compact)
+        goto done;
+    // 与 btCompileTree 的单块分配相同: 每个节点 3 个 uint32 和 2 个 uint8
+    out->flat_nodes = flat->node_count;
+    out->flat_bytes = sizeof(BtFlatTree) +
+                      (flat->action_count ? flat->action_count : 1) * sizeof(BtAction) +
+                      flat->utility_count * sizeof(const BtUtility *) +
+                      (size_t)flat->node_count * (3 * sizeof(uint32_t) + 2);
+    out->compact_bytes = btCompactBytes(compact);
+    ok = 1;
+
+done:
+    btFreeFlatTree(flat);
+    btFreeCompactTree(compact);
+    btPtrMapFree(&decorators);
+    collectFree(&collect);
+    if (!ok)
+        memset(out, 0, sizeof(*out));
+    return ok;
+}
+
+/**
+ * @brief Prints a footprint report, one line per layout with bytes per node.
+ */
+void btPrintFootprint(const BtFootprint *footprint, FILE *out)
+{
+    double nodes = footprint->nodes ? (double)footprint->nodes : 1.0;
+    double flatNodes = footprint->flat_nodes ? (double)footprint->flat_nodes : 1.0;
+
+    fprintf(out, "%u nodes, %u decorators, %u expanded nodes\n", footprint->nodes, footprint->decorators,
+            footprint->flat_nodes);
+    fprintf(out, "pointer  %10zu bytes %6.1f B/node (%zu with malloc overhead, %u blocks, %.1f B/node)\n",
+            footprint->pointer_bytes, (double)footprint->pointer_bytes / nodes, footprint->pointer_heap,
+            footprint->blocks, (double)footprint->pointer_heap / nodes);
+    fprintf(out, "flat     %10zu bytes %6.1f B/node (%.1f B per expanded node)\n", footprint->flat_bytes,
+            (double)footprint->flat_bytes / nodes, (double)footprint->flat_bytes / flatNodes);
+    fprintf(out, "compact  %10zu bytes %6.1f B/node\n", footprint->compact_bytes,
+            (double)footprint->compact_bytes / nodes);
+}
@@ -0,0 +1,109 @@
+#ifndef BEHAVIOR_TREE_COMPACT_H
+#define BEHAVIOR_TREE_COMPACT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "BehaviorTree.h"
+#include "BehaviorTreeFlat.h"
+
+/*
+ * A behavior tree in 16 bytes per node.
+ *
+ * A BehaviorNode is over a hundred bytes, plus a heap block for its child
+ * array and one for its decorator. BtCompactTree keeps one 16-byte record per
+ * node: type, decorator type, flags and child count packed into one word,
+ * the decorator parameter inline, and the children as a 32-bit index range.
+ * Nodes are numbered breadth first, so the children of a node are normally
+ * the consecutive records nodes[first .. first + count). Unlike
+ * btCompileTree, which expands shared subtrees into copies, a node shared by
+ * several parents (btDedupTree) is stored once; a parent whose children are
+ * not consecutive because of that is flagged BT_COMPACT_INDIRECT and its
+ * range is children[first .. first + count), an array of node indices.
+ *
+ * The compact tree is read-only: executeCompact runs it with the semantics
+ * of executeFlat and any number of threads may run it at once. Trees that
+ * are ticked are compiled with btCompileTree instead.
+ *
+ * btMeasureFootprint reports the memory of a pointer tree in all three
+ * layouts.
+ */
+typedef struct BtCompactNode
+{
+    uint32_t bits;  // 0-3 位 NodeType, 4-7 位 DecoratorType, 8-11 位标志, 12-31 位子节点个数
+    uint32_t first; // 第一个子节点的下标, BT_COMPACT_INDIRECT 时为在 children 中的位置
+    uint32_t param; // 装饰器参数 (时长统一为毫秒) / 并行成功阈值 / MemoryKind / BtUtilityMode
+    uint32_t extra; // action 表下标 / 并行失败阈值 / 得分表下标
+} BtCompactNode;
+
+#define BT_COMPACT_SHARED 0x1u          // 节点有多个父节点
+#define BT_COMPACT_INDIRECT 0x2u        // 子节点下标不连续, 经 children 查找
+#define BT_COMPACT_MAX_CHILDREN 0xFFFFFu
+
+static inline uint32_t btCompactType(const BtCompactNode *node)
+{
+    return node->bits & 0xFu;
+}
+
+static inline uint32_t btCompactDecorator(const BtCompactNode *node)
+{
+    return (node->bits >> 4) & 0xFu;
+}
+
+static inline uint32_t btCompactFlags(const BtCompactNode *node)
+{
+    return (node->bits >> 8) & 0xFu;
+}
+
+static inline uint32_t btCompactChildCount(const BtCompactNode *node)
+{
+    return node->bits >> 12;
+}
+
+typedef struct BtCompactTree
+{
+    uint32_t node_count;
+    uint32_t edge_count;    // children 的长度, 只有 BT_COMPACT_INDIRECT 的节点占用
+    uint32_t action_count;
+    uint32_t utility_count;
+    BtCompactNode *nodes;   // nodes[0] 是根节点
+    uint32_t *children;
+    BtAction *actions;
+    const struct BtUtility **utilities;
+} BtCompactTree;
+
+static inline uint32_t btCompactChild(const BtCompactTree *tree, const BtCompactNode *node, uint32_t i)
+{
+    if (btCompactFlags(node) & BT_COMPACT_INDIRECT)
+        return tree->children[node->first + i];
+    return node->first + i;
+}
+
+/**
+ * @brief Memory of one tree in the three layouts, in bytes.
+ *
+ * The pointer sizes count the node objects, child arrays and decorators
+ * that are reachable, each once; *_heap adds the malloc chunk header and
+ * rounding of a typical 64-bit allocator (8 + round up to 16) per block.
+ */
+typedef struct BtFootprint
+{
+    uint32_t nodes;        // 不同节点对象
+    uint32_t decorators;   // 不同装饰器对象
+    uint32_t blocks;       // 指针树的堆块个数
+    uint32_t flat_nodes;   // btCompileTree 展开后的节点数
+    size_t pointer_bytes;
+    size_t pointer_heap;
+    size_t flat_bytes;
+    size_t compact_bytes;
+} BtFootprint;
+
+BtCompactTree *btCompactTree(BehaviorNode *root);
+int executeCompact(const BtCompactTree *tree, BtContext *ctx);
+void btFreeCompactTree(BtCompactTree *tree);
+size_t btCompactBytes(const BtCompactTree *tree);
+
+int btMeasureFootprint(BehaviorNode *root, BtFootprint *out);
+void btPrintFootprint(const BtFootprint *footprint, FILE *out);
+
+#endif // BEHAVIOR_TREE_COMPACT_H
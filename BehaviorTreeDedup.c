@@ -0,0 +1,199 @@
+#include "BehaviorTreeDedup.h"
+#include "BehaviorTreeInternal.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct
+{
+    BehaviorNode *node;
+    int next; // 下一个要处理的子节点
+} Visit;
+
+static inline uint64_t mix(uint64_t hash, uint64_t value)
+{
+    hash ^= value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    return hash ^ (hash >> 33);
+}
+
+// 子节点已经是规范节点, 按指针参与哈希
+static uint64_t hashShape(const BehaviorNode *node)
+{
+    uint64_t hash = mix(node->type, (uint64_t)node->child_count);
+    hash = mix(hash, (uint64_t)(uintptr_t)node->action);
+    hash = mix(hash, (uint64_t)(uintptr_t)node->ctx_action);
+    hash = mix(hash, (uint64_t)(uintptr_t)node->async);
+    hash = mix(hash, (uint64_t)(uintptr_t)node->halt);
+    if (node->decorator)
+    {
+        hash = mix(hash, node->decorator->type);
+        hash = mix(hash, node->decorator->params.repeat);
+        hash = mix(hash, node->decorator->flags);
+    }
+    hash = mix(hash, node->params.parallel.success_threshold);
+    hash = mix(hash, node->params.parallel.failure_threshold);
+    for (int i = 0; i < node->child_count; i++)
+        hash = mix(hash, (uint64_t)(uintptr_t)node->children[i]);
+    return hash;
+}
+
+static int sameShape(const void *left, const void *right)
+{
+    const BehaviorNode *a = left, *b = right;
+
+    if (a->type != b->type || a->child_count != b->child_count || a->action != b->action ||
+        a->ctx_action != b->ctx_action || a->async != b->async || a->halt != b->halt ||
+        memcmp(&a->params, &b->params, sizeof(a->params)) != 0)
+    {
+        return 0;
+    }
+    if (a->decorator != b->decorator)
+    {
+        if (!a->decorator || !b->decorator || a->decorator->type != b->decorator->type ||
+            a->decorator->params.repeat != b->decorator->params.repeat ||
+            a->decorator->flags != b->decorator->flags)
+        {
+            return 0;
+        }
+    }
+    for (int i = 0; i < a->child_count; i++)
+    {
+        if (a->children[i] != b->children[i])
+            return 0;
+    }
+    return 1;
+}
+
+static int stateful(const BehaviorNode *node)
+{
+    // 加权随机的 utility 节点在 executeNode 之间保留随机状态
+    if (node->type == NODE_TYPE_UTILITY)
+        return node->params.utility.mode == BT_UTILITY_WEIGHTED_RANDOM;
+    return node->type == NODE_TYPE_DECORATOR && node->decorator &&
+           (node->decorator->type == DECORATOR_TYPE_COOLDOWN || node->decorator->type == DECORATOR_TYPE_CACHE);
+}
+
+// 按结构查找时用 hashShape 和 sameShape, 节点 -> 规范节点 (value)
+static int tableInsert(BtPtrMap *table, const BehaviorNode *key, BehaviorNode *value, uint64_t hash, BtPtrSame same)
+{
+    BtPtrSlot *slot = btPtrMapInsertHashed(table, key, hash, same);
+    if (!slot)
+        return 0;
+    slot->value = value;
+    return 1;
+}
+
+/**
+ * @brief Points node->children[i] at its canonical node and releases the duplicate.
+ */
+static void replaceChild(BehaviorNode *node, int i, BehaviorNode *canonical, BtDedupStats *stats)
+{
+    BehaviorNode *duplicate = node->children[i];
+
+    node->children[i] = canonical;
+    atomic_fetch_add_explicit(&canonical->reference_count, 1, memory_order_relaxed);
+    if (atomic_fetch_sub_explicit(&duplicate->reference_count, 1, memory_order_acq_rel) > 1)
+        return; // 还有其他父节点, 它们稍后也会替换
+
+    // 重复节点的子节点就是规范节点的子节点, 不会随它一起释放
+    stats->bytes_saved += sizeof(BehaviorNode) + sizeof(BehaviorNode *) * (size_t)duplicate->child_count;
+    if (duplicate->decorator && atomic_load_explicit(&duplicate->decorator->reference_count, memory_order_relaxed) <= 1)
+        stats->bytes_saved += sizeof(Decorator);
+    stats->nodes_after--;
+    freeBehaviorTree(duplicate);
+}
+
+/**
+ * @brief Merges identical subtrees of a tree built with createBehaviorNode.
+ *
+ * Nodes are visited children first, so when a node is looked up its
+ * children are already canonical and comparing them by pointer compares
+ * whole subtrees. Trees that already share nodes are handled; every node
+ * object is visited once.
+ *
+ * @param root  Root of the tree, never merged away.
+ * @param flags 0 or BT_DEDUP_STATEFUL.
+ * @param stats Receives the node counts and the bytes freed, may be NULL.
+ * @return int 1 on success, 0 if memory runs out; the tree is then valid
+ *             but only partly deduplicated.
+ */
+int btDedupTree(BehaviorNode *root, uint32_t flags, BtDedupStats *stats)
+{
+    BtDedupStats local = {0, 0, 0};
+    BtPtrMap memo, shapes;
+    Visit *stack;
+    int capacity = 64, top = 0, ok = 0;
+
+    if (!stats)
+        stats = &local;
+    memset(stats, 0, sizeof(*stats));
+    if (!root)
+        return 1;
+
+    memo.slots = shapes.slots = NULL;
+    stack = malloc(sizeof(Visit) * (size_t)capacity);
+    if (!stack || !btPtrMapInit(&memo) || !btPtrMapInit(&shapes))
+        goto done;
+    stack[0].node = root;
+    stack[0].next = 0;
+
+    while (top >= 0)
+    {
+        Visit *visit = &stack[top];
+        BehaviorNode *node = visit->node;
+
+        // 先处理所有子节点; 已经访问过的共享子节点跳过
+        if (visit->next < node->child_count)
+        {
+            BehaviorNode *child = node->children[visit->next++];
+            if (!child || btPtrMapFind(&memo, child)->key)
+                continue;
+            if (top + 1 == capacity)
+            {
+                Visit *grown = realloc(stack, sizeof(Visit) * (size_t)capacity * 2);
+                if (!grown)
+                    goto done;
+                stack = grown;
+                capacity *= 2;
+            }
+            top++;
+            stack[top].node = child;
+            stack[top].next = 0;
+            continue;
+        }
+        top--;
+
+        for (int i = 0; i < node->child_count; i++)
+        {
+            BehaviorNode *child = node->children[i];
+            if (!child)
+                continue;
+            BehaviorNode *canonical = btPtrMapFind(&memo, child)->value;
+            if (canonical != child)
+                replaceChild(node, i, canonical, stats);
+        }
+
+        BehaviorNode *canonical = node;
+        if (!stateful(node) || (flags & BT_DEDUP_STATEFUL))
+        {
+            uint64_t hash = hashShape(node);
+            BtPtrSlot *slot = btPtrMapFindHashed(&shapes, node, hash, sameShape);
+            if (slot->key)
+                canonical = slot->value;
+            else if (!tableInsert(&shapes, node, node, hash, sameShape))
+                goto done;
+        }
+        if (!tableInsert(&memo, node, canonical, btHashPointer(node), NULL))
+            goto done;
+        stats->nodes_before++;
+        stats->nodes_after++;
+    }
+    ok = 1;
+
+done:
+    free(stack);
+    btPtrMapFree(&memo);
+    btPtrMapFree(&shapes);
+    return ok;
+}
@@ -0,0 +1,33 @@
+#ifndef BEHAVIOR_TREE_DEDUP_H
+#define BEHAVIOR_TREE_DEDUP_H
+
+#include <stddef.h>
+#include "BehaviorTree.h"
+
+/*
+ * Hash-consing of heap-allocated trees: structurally identical subtrees
+ * (same type, callbacks, decorator type/params/flags, node params and
+ * identical children) are merged into one node shared by all parents.
+ * reference_count keeps counting the parents, so freeBehaviorTree frees the
+ * resulting DAG correctly.
+ *
+ * Shared nodes also share their NodeState. Cooldown and cache decorators
+ * keep results in it even under executeNode, so they are only merged with
+ * BT_DEDUP_STATEFUL. tickTree keeps the progress of every node in its
+ * state; run a deduplicated tree with executeNode, or compile it with
+ * btCompileTree, which gives every position its own state again.
+ *
+ * Not for arena trees: duplicates are released with free().
+ */
+#define BT_DEDUP_STATEFUL 0x1u // 也合并 cooldown / cache 装饰器
+
+typedef struct BtDedupStats
+{
+    uint32_t nodes_before; // 不同节点对象的个数
+    uint32_t nodes_after;
+    size_t bytes_saved;    // 释放的节点、子节点数组和装饰器
+} BtDedupStats;
+
+int btDedupTree(BehaviorNode *root, uint32_t flags, BtDedupStats *stats);
+
+#endif // BEHAVIOR_TREE_DEDUP_H
@@ -0,0 +1,966 @@
+#include "BehaviorTreeFlat.h"
+#include "BehaviorTreeAsync.h"
+#include "BehaviorTreeCache.h"
+#include "BehaviorTreeInternal.h"
+#include "BehaviorTreeReactive.h"
+#include "BehaviorTreeTrace.h"
+#include "BehaviorTreeUtility.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct
+{
+    BehaviorNode *node;
+    uint32_t index;
+    int next; // 下一个要访问的子节点
+} CompileFrame;
+
+static int runFlat(const BtFlatTree *tree, BtContext *ctx, uint32_t index);
+
+// executeFlat 中加权随机选择的状态, 见 btUtilityChoose
+static _Thread_local uint32_t executeRandom;
+
+// 适配器: 旧的 int (*)(void) 动作、上下文动作和异步动作共用 action 表
+static inline int callFlatAction(const BtFlatTree *tree, BtContext *ctx, uint32_t index)
+{
+    const BtAction *action = &tree->actions[tree->action[index]];
+    if (action->ctx_action)
+        return action->ctx_action(ctx);
+    if (action->action)
+        return action->action();
+    return btAsyncRun(action->async, ctx);
+}
+static inline int runFlatChild(const BtFlatTree *tree, BtContext *ctx, uint32_t index);
+static int runFlatDecorator(const BtFlatTree *tree, BtContext *ctx, uint32_t index);
+static NodeStatus tickFlat(const BtFlatTree *tree, BtInstance *instance, uint32_t index, uint64_t now);
+static void haltFlat(const BtFlatTree *tree, BtInstance *instance, uint32_t index);
+static void wakeInstance(BtTimer *timer, void *user);
+static void cancelWake(BtInstance *instance);
+
+// btCreateInstances 在实例数组之前保存实例个数, 供 btFreeInstances 取消定时器
+#define INSTANCE_PREFIX ((sizeof(size_t) + _Alignof(BtInstance) - 1) & ~(size_t)(_Alignof(BtInstance) - 1))
+
+// 记录一个缓存装饰器, 表在遇到第一个时才分配
+static int addCache(BtPtrMap *caches, const BehaviorNode *node)
+{
+    if (!caches->slots && !btPtrMapInit(caches))
+        return 0;
+    if (btPtrMapFind(caches, node)->key)
+        return 1;
+    BtPtrSlot *slot = btPtrMapInsert(caches, node);
+    if (!slot)
+        return 0;
+    slot->index = UINT32_MAX; // fillNode 填写第一个副本的下标
+    return 1;
+}
+
+/**
+ * @brief Counts the nodes reachable from root and collects its actions.
+ *
+ * Shared subtrees are counted once per parent, because the flat layout
+ * expands a DAG into a plain tree. Cache decorators are collected in caches
+ * so that every copy of a shared one can use the state of the first copy.
+ *
+ * @return int 1 on success, 0 if the tree is invalid or memory ran out.
+ */
+static int countTree(BehaviorNode *root, uint32_t *nodeCount, uint32_t *utilityCount, BtActionMap *map,
+                     BtPtrMap *caches)
+{
+    size_t capacity = 64, top = 0;
+    BehaviorNode **stack = malloc(capacity * sizeof(*stack));
+    uint32_t count = 0, utilities = 0;
+    uint32_t unused;
+
+    if (!stack)
+        return 0;
+    stack[top++] = root;
+
+    while (top > 0)
+    {
+        BehaviorNode *node = stack[--top];
+        if (node == NULL || (node->type == NODE_TYPE_DECORATOR && node->decorator == NULL))
+        {
+            free(stack);
+            return 0;
+        }
+        count++;
+        utilities += node->type == NODE_TYPE_UTILITY;
+        if ((node->action || node->ctx_action || node->async) &&
+            !btActionMapInsert(map, (BtAction){node->action, node->ctx_action, node->async, node->halt}, &unused))
+        {
+            free(stack);
+            return 0;
+        }
+        if (node->type == NODE_TYPE_DECORATOR && node->decorator->type == DECORATOR_TYPE_CACHE &&
+            !addCache(caches, node))
+        {
+            free(stack);
+            return 0;
+        }
+        if (top + (size_t)node->child_count > capacity)
+        {
+            while (top + (size_t)node->child_count > capacity)
+                capacity *= 2;
+            BehaviorNode **grown = realloc(stack, capacity * sizeof(*stack));
+            if (!grown)
+            {
+                free(stack);
+                return 0;
+            }
+            stack = grown;
+        }
+        for (int i = 0; i < node->child_count; i++)
+            stack[top++] = node->children[i];
+    }
+
+    free(stack);
+    *nodeCount = count;
+    *utilityCount = utilities;
+    return 1;
+}
+
+static void fillNode(BtFlatTree *tree, uint32_t index, BehaviorNode *node, BtActionMap *map, BtPtrMap *caches)
+{
+    uint32_t action = 0;
+
+    tree->kind[index] = (uint8_t)node->type;
+    tree->dec_type[index] = 0;
+    tree->dec_param[index] = 0;
+    if (node->action || node->ctx_action || node->async)
+        btActionMapInsert(map, (BtAction){node->action, node->ctx_action, node->async, node->halt}, &action); // 第一遍已插入, 不会失败
+    tree->action[index] = action;
+
+    if (node->type == NODE_TYPE_MEMORY)
+    {
+        tree->dec_param[index] = node->params.memory.kind;
+    }
+    else if (node->type == NODE_TYPE_UTILITY)
+    {
+        // 得分表按出现顺序编号, 共享的子树各占一项
+        tree->dec_param[index] = node->params.utility.mode;
+        tree->action[index] = tree->utility_count;
+        tree->utilities[tree->utility_count++] = node->params.utility.table;
+    }
+    else if (node->type == NODE_TYPE_PARALLEL)
+    {
+        uint32_t count = (uint32_t)node->child_count;
+        uint32_t success = node->params.parallel.success_threshold;
+        uint32_t failure = node->params.parallel.failure_threshold;
+        if (success == 0 || success > count)
+            success = count;
+        tree->dec_param[index] = success;
+        tree->action[index] = failure ? failure : count - success + 1;
+    }
+    else if (node->type == NODE_TYPE_DECORATOR)
+    {
+        Decorator *decorator = node->decorator;
+        tree->dec_type[index] = (uint8_t)decorator->type;
+        if (decorator->type == DECORATOR_TYPE_DELAY ||
+            decorator->type == DECORATOR_TYPE_TIMEOUT ||
+            decorator->type == DECORATOR_TYPE_COOLDOWN)
+            tree->dec_param[index] = btDecoratorDurationMs(decorator); // 统一为毫秒
+        else
+            tree->dec_param[index] = decorator->params.repeat;
+        if (decorator->type == DECORATOR_TYPE_CACHE)
+        {
+            // 共享的缓存装饰器的所有副本使用第一个副本的缓存条目
+            BtPtrSlot *slot = btPtrMapFind(caches, node);
+            if (slot->index == UINT32_MAX)
+                slot->index = index;
+            tree->action[index] = slot->index;
+        }
+    }
+}
+
+/**
+ * @brief Compiles a pointer-based behavior tree into a flat execution array.
+ *
+ * The whole result lives in a single allocation. The source tree is not
+ * modified and can be freed independently.
+ *
+ * @param root Pointer to the root BehaviorNode of the tree to compile.
+ * @return BtFlatTree* The compiled tree, or NULL if the tree is invalid
+ *                     (NULL child, decorator node without a decorator) or
+ *                     memory could not be allocated.
+ */
+BtFlatTree *btCompileTree(BehaviorNode *root)
+{
+    BtActionMap map = {0};
+    BtPtrMap caches = {0};
+    uint32_t nodeCount, utilityCount;
+
+    if (!root || !countTree(root, &nodeCount, &utilityCount, &map, &caches))
+    {
+        btActionMapFree(&map);
+        btPtrMapFree(&caches);
+        return NULL;
+    }
+
+    // 单块分配: 结构体 | action 表 | 得分表指针 | uint32 数组 | uint8 数组
+    size_t actionCount = map.count ? map.count : 1;
+    size_t size = sizeof(BtFlatTree) +
+                  3 * (size_t)nodeCount * sizeof(uint32_t) +
+                  actionCount * sizeof(BtAction) +
+                  utilityCount * sizeof(const BtUtility *) +
+                  2 * (size_t)nodeCount;
+    BtFlatTree *tree = malloc(size);
+    CompileFrame *frames = malloc(64 * sizeof(CompileFrame));
+    size_t frameCapacity = 64, depth = 0;
+    if (!tree || !frames)
+    {
+        free(tree);
+        free(frames);
+        btActionMapFree(&map);
+        btPtrMapFree(&caches);
+        return NULL;
+    }
+
+    tree->node_count = nodeCount;
+    tree->action_count = map.count;
+    tree->utility_count = 0; // 由 fillNode 填写
+    tree->actions = (BtAction *)(tree + 1);
+    tree->utilities = (const BtUtility **)(tree->actions + actionCount);
+    tree->subtree_end = (uint32_t *)(tree->utilities + utilityCount);
+    tree->dec_param = tree->subtree_end + nodeCount;
+    tree->action = tree->dec_param + nodeCount;
+    tree->kind = (uint8_t *)(tree->action + nodeCount);
+    tree->dec_type = tree->kind + nodeCount;
+
+    for (uint32_t i = 0; i < map.capacity; i++)
+    {
+        if (!btActionIsEmpty(map.keys[i]))
+            tree->actions[map.values[i]] = map.keys[i];
+    }
+
+    // 先序遍历, 子树全部写完后回填 subtree_end
+    uint32_t next = 0;
+    fillNode(tree, next, root, &map, &caches);
+    frames[depth++] = (CompileFrame){root, next++, 0};
+    while (depth > 0)
+    {
+        CompileFrame *frame = &frames[depth - 1];
+        if (frame->next == frame->node->child_count)
+        {
+            tree->subtree_end[frame->index] = next;
+            depth--;
+            continue;
+        }
+
+        BehaviorNode *child = frame->node->children[frame->next++];
+        if (depth == frameCapacity)
+        {
+            CompileFrame *grown = realloc(frames, 2 * frameCapacity * sizeof(CompileFrame));
+            if (!grown)
+            {
+                free(frames);
+                free(tree);
+                btActionMapFree(&map);
+                btPtrMapFree(&caches);
+                return NULL;
+            }
+            frames = grown;
+            frameCapacity *= 2;
+        }
+        fillNode(tree, next, child, &map, &caches);
+        frames[depth++] = (CompileFrame){child, next++, 0};
+    }
+
+    free(frames);
+    btActionMapFree(&map);
+    btPtrMapFree(&caches);
+    return tree;
+}
+
+/**
+ * @brief Executes a compiled tree.
+ *
+ * Same semantics as executeNodeWithContext on the source tree, except that
+ * the tree is read-only and keeps no state between calls: a cache decorator
+ * never reuses a result and a cooldown decorator never blocks, both simply
+ * run their child. Ticked instances (tickInstance) keep that state like
+ * executeNode.
+ *
+ * @param tree Pointer to a tree returned by btCompileTree.
+ * @param ctx  Agent context passed to context actions, may be NULL.
+ * @return int Returns 1 if the tree succeeds, 0 if it fails.
+ */
+int executeFlat(const BtFlatTree *tree, BtContext *ctx)
+{
+    if (tree == NULL || tree->node_count == 0)
+        return 0;
+    return runFlat(tree, ctx, 0);
+}
+
+/**
+ * @brief Scores the children of a utility node and returns the tree index
+ * of the chosen one.
+ */
+static uint32_t chooseFlat(const BtFlatTree *tree, BtContext *ctx, uint32_t index, uint32_t *rng)
+{
+    const BtUtility *table = tree->utilities[tree->action[index]];
+    uint32_t option = btUtilityChoose(table, ctx, (BtUtilityMode)tree->dec_param[index], rng);
+    uint32_t child = index + 1;
+
+    // 子节点都是单个节点时直接定位, 否则沿兄弟链查找
+    if (tree->subtree_end[index] - child == btUtilityOptionCount(table))
+        return child + option;
+    while (option-- > 0)
+        child = tree->subtree_end[child];
+    return child;
+}
+
+static int runFlatNode(const BtFlatTree *tree, BtContext *ctx, uint32_t index)
+{
+    const uint32_t *end = tree->subtree_end;
+    uint32_t child;
+
+    switch (tree->kind[index])
+    {
+    case NODE_TYPE_ACTION:
+    case NODE_TYPE_CONDITION:
+        return callFlatAction(tree, ctx, index);
+    case NODE_TYPE_SEQUENCE:
+        for (child = index + 1; child < end[index]; child = end[child])
+        {
+            if (!runFlatChild(tree, ctx, child))
+                return 0;
+        }
+        return 1;
+    case NODE_TYPE_SELECTOR:
+        for (child = index + 1; child < end[index]; child = end[child])
+        {
+            if (runFlatChild(tree, ctx, child))
+                return 1;
+        }
+        return 0;
+    case NODE_TYPE_MEMORY:
+        // 一次执行完所有子节点, 与普通 sequence/selector 相同
+        if (tree->dec_param[index] == MEMORY_SELECTOR)
+        {
+            for (child = index + 1; child < end[index]; child = end[child])
+            {
+                if (runFlatChild(tree, ctx, child))
+                    return 1;
+            }
+            return 0;
+        }
+        for (child = index + 1; child < end[index]; child = end[child])
+        {
+            if (!runFlatChild(tree, ctx, child))
+                return 0;
+        }
+        return 1;
+    case NODE_TYPE_PARALLEL:
+    {
+        // 按子节点顺序执行, 第一个达到的阈值决定结果, 与 executeNode 一致
+        uint32_t successCount = 0, failureCount = 0;
+        for (child = index + 1; child < end[index]; child = end[child])
+        {
+            if (runFlatChild(tree, ctx, child))
+            {
+                if (++successCount >= tree->dec_param[index])
+                    return 1;
+            }
+            else if (++failureCount >= tree->action[index])
+            {
+                return 0;
+            }
+        }
+        return 0;
+    }
+    case NODE_TYPE_DECORATOR:
+        return runFlatDecorator(tree, ctx, index);
+    case NODE_TYPE_UTILITY:
+        // executeFlat 不写树, 随机状态按线程保存
+        return runFlatChild(tree, ctx, chooseFlat(tree, ctx, index, &executeRandom));
+    default:
+        return 0;
+    }
+}
+
+static int runFlat(const BtFlatTree *tree, BtContext *ctx, uint32_t index)
+{
+    int result = runFlatNode(tree, ctx, index);
+    btTraceFlatResult(index, tree->kind[index], result ? BT_SUCCESS : BT_FAILURE);
+    return result;
+}
+
+// 叶子节点直接调用, 省去一次递归
+static inline int runFlatChild(const BtFlatTree *tree, BtContext *ctx, uint32_t index)
+{
+    if (tree->kind[index] <= NODE_TYPE_CONDITION)
+    {
+        int result = callFlatAction(tree, ctx, index);
+        btTraceFlatResult(index, tree->kind[index], result ? BT_SUCCESS : BT_FAILURE);
+        return result;
+    }
+    return runFlat(tree, ctx, index);
+}
+
+// btRunDecorator 的回调
+static int runFlatAt(const void *tree, BtContext *ctx, uint32_t index)
+{
+    return runFlat((const BtFlatTree *)tree, ctx, index);
+}
+
+static int runFlatDecorator(const BtFlatTree *tree, BtContext *ctx, uint32_t index)
+{
+    uint32_t children[3] = {index + 1};
+    uint32_t count = 1;
+
+    // 只有 conditional 用到后面的子节点
+    if (tree->dec_type[index] == DECORATOR_TYPE_CONDITIONAL)
+    {
+        while (count < 3 && tree->subtree_end[children[count - 1]] < tree->subtree_end[index])
+        {
+            children[count] = tree->subtree_end[children[count - 1]];
+            count++;
+        }
+    }
+    return btRunDecorator(tree, ctx, tree->dec_type[index], tree->dec_param[index], children, count, runFlatAt);
+}
+
+/**
+ * @brief Creates count instances of a compiled tree.
+ *
+ * The instances and all their node states are one allocation, so the memory
+ * per agent is node_count * sizeof(NodeState) regardless of how the tree was
+ * built.
+ *
+ * @return BtInstance* Array of count instances, or NULL if memory could not be allocated.
+ */
+BtInstance *btCreateInstances(const BtFlatTree *tree, int count)
+{
+    size_t headerSize = INSTANCE_PREFIX + sizeof(BtInstance) * (size_t)count;
+    size_t stateSize = sizeof(NodeState) * (size_t)tree->node_count;
+
+    // 个数 | 实例数组 | 状态数组
+    headerSize = (headerSize + _Alignof(NodeState) - 1) & ~(size_t)(_Alignof(NodeState) - 1);
+    unsigned char *block = malloc(headerSize + stateSize * (size_t)count);
+    if (!block)
+        return NULL;
+
+    *(size_t *)block = (size_t)count;
+    BtInstance *instances = (BtInstance *)(block + INSTANCE_PREFIX);
+    NodeState *states = (NodeState *)(block + headerSize);
+    for (int i = 0; i < count; i++)
+    {
+        instances[i].states = states + (size_t)i * tree->node_count;
+        instances[i].context.agent = NULL;
+        instances[i].context.blackboard = NULL;
+        instances[i].reactive = NULL;
+        instances[i].tick = 0;
+        instances[i].wake_at = BT_TIMER_NONE;
+        instances[i].busy = 0;
+        instances[i].polled = 0;
+        instances[i].sleeping = 0;
+        instances[i].wheel = NULL;
+        btTimerInit(&instances[i].timer, wakeInstance, &instances[i]);
+        btResetInstance(tree, &instances[i]);
+    }
+    return instances;
+}
+
+/**
+ * @brief Puts an instance back into its initial (idle) state.
+ *
+ * A pending tickBatchTimed wakeup is cancelled.
+ */
+void btResetInstance(const BtFlatTree *tree, BtInstance *instance)
+{
+    cancelWake(instance);
+    for (uint32_t i = 0; i < tree->node_count; i++)
+    {
+        instance->states[i].running_child = 0;
+        instance->states[i].counter = 0;
+        instance->states[i].status = BT_IDLE;
+    }
+    instance->status = BT_IDLE;
+}
+
+/**
+ * @brief Aborts an instance that tickInstance left running.
+ *
+ * Same as haltTree on the source tree: halt callbacks of running leaves are
+ * called with the instance's context, async handles are cancelled and the
+ * running nodes return to BT_IDLE. Call it before btResetInstance when the
+ * instance may still be running.
+ */
+void btHaltInstance(const BtFlatTree *tree, BtInstance *instance)
+{
+    cancelWake(instance);
+    if (tree->node_count > 0)
+        haltFlat(tree, instance, 0);
+    if (instance->status == BT_RUNNING)
+        instance->status = BT_IDLE;
+}
+
+/**
+ * @brief Frees an array returned by btCreateInstances.
+ *
+ * Instances still sleeping in a tickBatchTimed wheel are removed from it.
+ */
+void btFreeInstances(BtInstance *instances)
+{
+    if (instances == NULL)
+        return;
+    unsigned char *block = (unsigned char *)instances - INSTANCE_PREFIX;
+    size_t count = *(size_t *)block;
+    for (size_t i = 0; i < count; i++)
+        cancelWake(&instances[i]);
+    free(block);
+}
+
+/**
+ * @brief Ticks one instance of a compiled tree without blocking.
+ *
+ * Same semantics as tickTree on the source tree, with all runtime state
+ * read from and written to the instance.
+ *
+ * @param now_ms Current time as returned by btMonotonicMs().
+ * @return NodeStatus BT_SUCCESS, BT_FAILURE, or BT_RUNNING.
+ */
+NodeStatus tickInstance(const BtFlatTree *tree, BtInstance *instance, uint64_t now_ms)
+{
+    NodeStatus status = BT_FAILURE;
+    instance->tick++; // 供只在当前 tick 内有效的缓存使用
+    if (tree->node_count > 0)
+        status = tickFlat(tree, instance, 0, now_ms);
+    instance->status = (uint8_t)status;
+    return status;
+}
+
+/**
+ * @brief Ticks many instances of one tree in a single pass.
+ *
+ * The clock is read once for the whole batch and the tree arrays stay hot in
+ * cache while each instance only touches its own states.
+ *
+ * @return int Number of instances that are still running.
+ */
+int tickBatch(const BtFlatTree *tree, BtInstance *instances, int count)
+{
+    uint64_t now = btMonotonicMs();
+    int running = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        if (tickInstance(tree, &instances[i], now) == BT_RUNNING)
+            running++;
+    }
+    return running;
+}
+
+static void wakeInstance(BtTimer *timer, void *user)
+{
+    (void)timer;
+    ((BtInstance *)user)->sleeping = 0;
+}
+
+// 从时间轮中摘下等待唤醒的实例, 之后 tickBatchTimed 会重新 tick 它
+static void cancelWake(BtInstance *instance)
+{
+    if (instance->wheel)
+        btTimerCancel(instance->wheel, &instance->timer);
+    instance->sleeping = 0;
+}
+
+/**
+ * @brief Ticks many instances, skipping those that only wait for a timer.
+ *
+ * When an instance is still running only because of delay, timeout or
+ * cooldown decorators, it is put to sleep on the wheel until the earliest of
+ * their deadlines and costs nothing on later ticks until its timer fires.
+ * Use btTimerWheelNextWakeup to find how long the tick loop may sleep.
+ *
+ * An instance only sleeps when its tick ran no action, condition or utility
+ * scorer: then every tick until the deadline would take the same path, and
+ * skipping them gives the same result as tickBatch. Guard conditions and
+ * selectors re-evaluated above a timer (a plain sequence or selector over
+ * it) keep the instance awake, so they still preempt it on every tick;
+ * memory nodes and decorators directly over the timer do not.
+ *
+ * @param wheel  Timer wheel whose clock uses btMonotonicMs() time.
+ * @param now_ms Current time as returned by btMonotonicMs().
+ * @return int Number of instances that are still running, sleeping ones included.
+ */
+int tickBatchTimed(const BtFlatTree *tree, BtInstance *instances, int count,
+                   BtTimerWheel *wheel, uint64_t now_ms)
+{
+    int running = 0;
+
+    btTimerWheelAdvance(wheel, now_ms); // 唤醒到期的实例
+    for (int i = 0; i < count; i++)
+    {
+        BtInstance *instance = &instances[i];
+        if (instance->sleeping)
+        {
+            running++;
+            continue;
+        }
+
+        instance->wake_at = BT_TIMER_NONE;
+        instance->busy = 0;
+        instance->polled = 0;
+        if (tickInstance(tree, instance, now_ms) != BT_RUNNING)
+            continue;
+        running++;
+        // 执行过叶子节点的实例下次 tick 可能走不同的路径, 不能跳过
+        if (!instance->busy && !instance->polled && instance->wake_at != BT_TIMER_NONE)
+        {
+            instance->sleeping = 1;
+            instance->wheel = wheel;
+            btTimerSchedule(wheel, &instance->timer, instance->wake_at);
+        }
+    }
+    return running;
+}
+
+// 记录计时类装饰器的截止时间, 供 tickBatchTimed 安排唤醒
+static inline void noteDeadline(BtInstance *instance, uint64_t now, uint32_t deadline)
+{
+    uint64_t wakeAt = now + (uint64_t)(int64_t)(int32_t)(deadline - (uint32_t)now);
+    if (wakeAt < instance->wake_at)
+        instance->wake_at = wakeAt;
+}
+
+static NodeStatus tickFlatDecorator(const BtFlatTree *tree, BtInstance *instance, uint32_t index, uint64_t now)
+{
+    NodeState *state = &instance->states[index];
+    uint32_t child = index + 1;
+    uint32_t param = tree->dec_param[index];
+    NodeStatus status;
+
+    switch (tree->dec_type[index])
+    {
+    case DECORATOR_TYPE_INVERT:
+        status = tickFlat(tree, instance, child, now);
+        if (status == BT_RUNNING)
+            return BT_RUNNING;
+        return status == BT_SUCCESS ? BT_FAILURE : BT_SUCCESS;
+
+    case DECORATOR_TYPE_REPEAT:
+        status = BT_FAILURE; // repeat 为 0 时失败
+        while (state->counter < param)
+        {
+            status = tickFlat(tree, instance, child, now);
+            if (status == BT_RUNNING)
+                return BT_RUNNING;
+            state->counter++;
+        }
+        state->counter = 0;
+        return status;
+
+    case DECORATOR_TYPE_REPEAT_UNTIL_SUCCESS:
+        status = tickFlat(tree, instance, child, now);
+        if (status == BT_SUCCESS)
+            return BT_SUCCESS;
+        instance->busy = 1; // 下个 tick 必须重试
+        return BT_RUNNING;
+
+    case DECORATOR_TYPE_CONDITIONAL:
+    {
+        uint32_t end = tree->subtree_end[index];
+        status = tickFlat(tree, instance, child, now);
+        child = tree->subtree_end[child];
+        if (child >= end)
+            return status;
+        uint32_t otherwise = tree->subtree_end[child];
+        // 条件改变时中止另一个分支, 与 tickTree 相同
+        if (status != BT_SUCCESS)
+            haltFlat(tree, instance, child);
+        if (status != BT_FAILURE && otherwise < end)
+            haltFlat(tree, instance, otherwise);
+        if (status == BT_RUNNING)
+            return status;
+        if (status == BT_SUCCESS)
+            return tickFlat(tree, instance, child, now);
+        return otherwise < end ? tickFlat(tree, instance, otherwise, now) : BT_FAILURE;
+    }
+
+    case DECORATOR_TYPE_DELAY:
+        if (state->running_child == 0)
+        {
+            status = tickFlat(tree, instance, child, now);
+            if (status != BT_SUCCESS)
+                return status;
+            state->counter = (uint32_t)(now + param);
+            state->running_child = 1; // 进入等待阶段
+        }
+        if ((int32_t)((uint32_t)now - state->counter) < 0)
+        {
+            noteDeadline(instance, now, state->counter);
+            return BT_RUNNING;
+        }
+        state->running_child = 0;
+        return BT_SUCCESS;
+
+    case DECORATOR_TYPE_TIMEOUT:
+        if (state->running_child == 0)
+        {
+            state->counter = (uint32_t)(now + param);
+            state->running_child = 1;
+        }
+        else if ((int32_t)((uint32_t)now - state->counter) >= 0)
+        {
+            state->running_child = 0;
+            haltFlat(tree, instance, child);
+            return BT_FAILURE; // 超时
+        }
+        status = tickFlat(tree, instance, child, now);
+        if (status != BT_RUNNING)
+            state->running_child = 0;
+        else
+            noteDeadline(instance, now, state->counter);
+        return status;
+
+    case DECORATOR_TYPE_COOLDOWN:
+        if (state->running_child == 1)
+        {
+            if ((int32_t)((uint32_t)now - state->counter) < 0)
+            {
+                noteDeadline(instance, now, state->counter);
+                return BT_FAILURE; // 冷却中
+            }
+            state->running_child = 0;
+        }
+        status = tickFlat(tree, instance, child, now);
+        if (status != BT_RUNNING)
+        {
+            state->counter = (uint32_t)(now + param);
+            state->running_child = 1;
+            noteDeadline(instance, now, state->counter);
+        }
+        return status;
+
+    case DECORATOR_TYPE_CACHE:
+    {
+        // 条目在共享节点第一个副本的状态中, 见 btCompileTree
+        NodeState *entry = &instance->states[tree->action[index]];
+        if (btCacheLookup(entry, param, (uint32_t)now, instance->tick, &status))
+            return status;
+        status = tickFlat(tree, instance, child, now);
+        btCacheStore(entry, param, (uint32_t)now, instance->tick, status);
+        return status;
+    }
+
+    default:
+        return BT_FAILURE;
+    }
+}
+
+static NodeStatus tickFlatParallel(const BtFlatTree *tree, BtInstance *instance, uint32_t index, uint64_t now)
+{
+    const uint32_t *end = tree->subtree_end;
+    NodeState *states = instance->states;
+    uint32_t successCount = 0, failureCount = 0, childCount = 0;
+    int fresh = states[index].status != BT_RUNNING;
+    NodeStatus result = BT_RUNNING;
+    uint32_t child;
+
+    for (child = index + 1; child < end[index] && result == BT_RUNNING; child = end[child])
+    {
+        NodeStatus status = (NodeStatus)states[child].status;
+        if (fresh || status == BT_RUNNING || status == BT_IDLE)
+            status = tickFlat(tree, instance, child, now);
+        if (status == BT_SUCCESS && ++successCount >= tree->dec_param[index])
+            result = BT_SUCCESS;
+        else if (status == BT_FAILURE && ++failureCount >= tree->action[index])
+            result = BT_FAILURE;
+        childCount++;
+    }
+    if (result == BT_RUNNING && successCount + failureCount == childCount)
+        result = BT_FAILURE;
+
+    if (result != BT_RUNNING)
+    {
+        // 结束本轮: 中止仍在运行的子节点, 清除子节点结果
+        for (child = index + 1; child < end[index]; child = end[child])
+        {
+            haltFlat(tree, instance, child);
+            states[child].status = BT_IDLE;
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Ticks a memory sequence or selector, resuming from the running child.
+ *
+ * running_child holds the tree index of that child, 0 when the node starts
+ * from its first child.
+ */
+static NodeStatus tickFlatMemory(const BtFlatTree *tree, BtInstance *instance, uint32_t index, uint64_t now)
+{
+    const uint32_t *end = tree->subtree_end;
+    NodeState *state = &instance->states[index];
+    NodeStatus next = tree->dec_param[index] == MEMORY_SELECTOR ? BT_FAILURE : BT_SUCCESS;
+    NodeStatus status = next;
+    uint32_t child;
+
+    for (child = state->running_child ? state->running_child : index + 1; child < end[index]; child = end[child])
+    {
+        status = tickFlat(tree, instance, child, now);
+        if (status != next)
+            break;
+    }
+    state->running_child = status == BT_RUNNING ? child : 0;
+    return status;
+}
+
+/**
+ * @brief Ticks a utility node, see tickUtility. running_child holds the tree
+ * index of the running child.
+ */
+static NodeStatus tickFlatUtility(const BtFlatTree *tree, BtInstance *instance, uint32_t index, uint64_t now)
+{
+    NodeState *state = &instance->states[index];
+    uint32_t previous = state->running_child;
+    uint32_t child;
+
+    if (previous && tree->dec_param[index] == BT_UTILITY_WEIGHTED_RANDOM)
+    {
+        child = previous;
+    }
+    else
+    {
+        child = chooseFlat(tree, &instance->context, index, &state->counter);
+        instance->polled = 1;
+        if (previous && previous != child)
+            haltFlat(tree, instance, previous);
+    }
+
+    NodeStatus status = tickFlat(tree, instance, child, now);
+    state->running_child = status == BT_RUNNING ? child : 0;
+    return status;
+}
+
+/**
+ * @brief Halts a running subtree of an instance, see haltTree.
+ */
+static void haltFlat(const BtFlatTree *tree, BtInstance *instance, uint32_t index)
+{
+    NodeState *state = &instance->states[index];
+    const uint32_t *end = tree->subtree_end;
+
+    if (state->status != BT_RUNNING)
+        return;
+    if (tree->kind[index] <= NODE_TYPE_CONDITION)
+    {
+        const BtAction *action = &tree->actions[tree->action[index]];
+        if (action->async)
+            btAsyncHalt(action->async, state);
+        if (action->halt)
+            action->halt(&instance->context);
+    }
+    else
+    {
+        for (uint32_t child = index + 1; child < end[index]; child = end[child])
+            haltFlat(tree, instance, child);
+    }
+    state->running_child = 0;
+    state->counter = 0;
+    state->status = BT_IDLE;
+}
+
+/**
+ * @brief Remembers the running child of a sequence or selector (its tree
+ * index in running_child) and halts the one that was running on the
+ * previous tick if a child before it decided this time.
+ */
+static inline void preemptFlat(const BtFlatTree *tree, BtInstance *instance, uint32_t index,
+                               uint32_t decided, NodeStatus status)
+{
+    NodeState *state = &instance->states[index];
+
+    if (state->running_child > decided)
+        haltFlat(tree, instance, state->running_child);
+    state->running_child = status == BT_RUNNING ? decided : 0;
+}
+
+static NodeStatus tickFlat(const BtFlatTree *tree, BtInstance *instance, uint32_t index, uint64_t now)
+{
+    const uint32_t *end = tree->subtree_end;
+    NodeStatus status = BT_FAILURE;
+    uint32_t child;
+
+    if (instance->reactive && btReactiveLookup(instance->reactive, index, &status))
+    {
+        instance->states[index].status = (uint8_t)status;
+        btTraceFlatResult(index, tree->kind[index], status);
+        return status;
+    }
+
+    switch (tree->kind[index])
+    {
+    case NODE_TYPE_ACTION:
+    case NODE_TYPE_CONDITION:
+    {
+        const BtAction *action = &tree->actions[tree->action[index]];
+        instance->polled = 1;
+        if (action->async)
+        {
+            status = btAsyncTick(action->async, &instance->states[index], &instance->context);
+            instance->busy |= status == BT_RUNNING;
+            break;
+        }
+        int result = callFlatAction(tree, &instance->context, index);
+        if (result == BT_RUNNING)
+        {
+            status = BT_RUNNING;
+            instance->busy = 1;
+        }
+        else
+            status = result ? BT_SUCCESS : BT_FAILURE;
+        break;
+    }
+    case NODE_TYPE_SEQUENCE:
+        status = BT_SUCCESS;
+        for (child = index + 1; child < end[index]; child = end[child])
+        {
+            status = tickFlat(tree, instance, child, now);
+            if (status != BT_SUCCESS)
+                break;
+        }
+        preemptFlat(tree, instance, index, child, status);
+        break;
+    case NODE_TYPE_SELECTOR:
+        status = BT_FAILURE;
+        for (child = index + 1; child < end[index]; child = end[child])
+        {
+            status = tickFlat(tree, instance, child, now);
+            if (status != BT_FAILURE)
+                break;
+        }
+        preemptFlat(tree, instance, index, child, status);
+        break;
+    case NODE_TYPE_PARALLEL:
+        status = tickFlatParallel(tree, instance, index, now);
+        break;
+    case NODE_TYPE_MEMORY:
+        status = tickFlatMemory(tree, instance, index, now);
+        break;
+    case NODE_TYPE_UTILITY:
+        status = tickFlatUtility(tree, instance, index, now);
+        break;
+    case NODE_TYPE_DECORATOR:
+        status = tickFlatDecorator(tree, instance, index, now);
+        break;
+    default:
+        break;
+    }
+
+    if (instance->reactive)
+        btReactiveStore(instance->reactive, index, status);
+    instance->states[index].status = (uint8_t)status;
+    btTraceFlatResult(index, tree->kind[index], status);
+    return status;
+}
+
+/**
+ * @brief Frees a tree returned by btCompileTree.
+ */
+void btFreeFlatTree(BtFlatTree *tree)
+{
+    free(tree);
+}
@@ -0,0 +1,83 @@
+#ifndef BEHAVIOR_TREE_FLAT_H
+#define BEHAVIOR_TREE_FLAT_H
+
+#include "BehaviorTree.h"
+#include "BehaviorTreeTimer.h"
+
+/**
+ * @brief Entry of the action table: exactly one of the three callbacks is
+ * set, plus the optional halt callback of the leaf.
+ */
+typedef struct BtAction
+{
+    int (*action)(void);
+    int (*ctx_action)(BtContext *ctx);
+    const struct BtAsyncAction *async; // 见 BehaviorTreeAsync.h
+    void (*halt)(BtContext *ctx);      // 见 haltTree
+} BtAction;
+
+/**
+ * @brief A behavior tree compiled into one contiguous block.
+ *
+ * Nodes are stored in pre-order, struct-of-arrays style: node i's first child
+ * is i + 1 and the next sibling of a child c is subtree_end[c], so the
+ * children of i are walked without following any pointer. Actions are
+ * replaced by an index into a deduplicated action table. Parallel nodes keep
+ * their resolved success/failure thresholds in dec_param and action, memory
+ * nodes their MemoryKind in dec_param, utility nodes their BtUtilityMode in
+ * dec_param and the index of their scoring table in action. A cache
+ * decorator keeps in action the index of the node whose state holds its
+ * cache entry: copies of a shared decorator all point to the first copy, so
+ * an instance caches it once, as tickTree does.
+ */
+typedef struct BtFlatTree
+{
+    uint32_t node_count;
+    uint32_t action_count;
+    uint32_t utility_count;
+    uint8_t *kind;          // NodeType
+    uint8_t *dec_type;      // DecoratorType, 仅装饰器节点有效
+    uint32_t *subtree_end;  // 子树结束位置 (不含)
+    uint32_t *dec_param;    // repeat 次数 / delay、timeout、cooldown、cache 毫秒 / 并行成功阈值 / MemoryKind / BtUtilityMode
+    uint32_t *action;       // action 表下标 / 并行失败阈值 / 得分表下标 / 缓存条目所在节点
+    BtAction *actions;      // action 表
+    const struct BtUtility **utilities; // utility 节点的得分表
+} BtFlatTree;
+
+/**
+ * @brief Per-agent runtime state for a shared BtFlatTree.
+ *
+ * The compiled tree is never written while ticking, so any number of
+ * instances can run the same tree. An instance only holds one NodeState per
+ * node (running child, decorator counter, last status) and the context its
+ * actions receive.
+ */
+typedef struct BtInstance
+{
+    NodeState *states;  // node_count 个
+    BtContext context;  // 传给上下文动作的 agent 和黑板
+    struct BtReactiveState *reactive; // 非 NULL 时复用未失效的结果
+    uint32_t tick;      // tickInstance 的调用次数
+    uint64_t wake_at;   // 本次 tick 中最早的计时截止时间
+    BtTimer timer;      // tickBatchTimed 用于唤醒
+    BtTimerWheel *wheel; // timer 所在的时间轮, 未调度过时为 NULL
+    uint8_t status;     // 上一次 tick 的结果 (NodeStatus)
+    uint8_t busy;       // 本次 tick 中有 action 或重试返回 RUNNING
+    uint8_t polled;     // 本次 tick 中执行过 action、条件或评分, 下次 tick 结果可能不同
+    uint8_t sleeping;   // 等待定时器, tickBatchTimed 跳过
+} BtInstance;
+
+BtFlatTree *btCompileTree(BehaviorNode *root);
+int executeFlat(const BtFlatTree *tree, BtContext *ctx); // 不保存状态: 冷却和缓存装饰器只执行子节点
+void btFreeFlatTree(BtFlatTree *tree);
+
+BtInstance *btCreateInstances(const BtFlatTree *tree, int count);
+void btResetInstance(const BtFlatTree *tree, BtInstance *instance);
+void btHaltInstance(const BtFlatTree *tree, BtInstance *instance);
+void btFreeInstances(BtInstance *instances);
+NodeStatus tickInstance(const BtFlatTree *tree, BtInstance *instance, uint64_t now_ms);
+int tickBatch(const BtFlatTree *tree, BtInstance *instances, int count);
+int tickBatchTimed(const BtFlatTree *tree, BtInstance *instances, int count,
+                   BtTimerWheel *wheel, uint64_t now_ms);
+
+#endif // BEHAVIOR_TREE_FLAT_H
@@ -0,0 +1,168 @@
+#include "BehaviorTreeInternal.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define PTR_MAP_INITIAL_CAPACITY 256u
+
+uint64_t btHashPointer(const void *pointer)
+{
+    uint64_t hash = (uint64_t)(uintptr_t)pointer;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    return hash ^ (hash >> 33);
+}
+
+/**
+ * @brief Allocates an empty map.
+ *
+ * @return int 1 on success, 0 if memory could not be allocated.
+ */
+int btPtrMapInit(BtPtrMap *map)
+{
+    map->capacity = PTR_MAP_INITIAL_CAPACITY;
+    map->count = 0;
+    map->slots = calloc(map->capacity, sizeof(BtPtrSlot));
+    return map->slots != NULL;
+}
+
+// 清空所有键, 保留已分配的容量
+void btPtrMapClear(BtPtrMap *map)
+{
+    for (uint32_t i = 0; i < map->capacity; i++)
+        map->slots[i] = (BtPtrSlot){0};
+    map->count = 0;
+}
+
+void btPtrMapFree(BtPtrMap *map)
+{
+    free(map->slots);
+    map->slots = NULL;
+    map->capacity = 0;
+    map->count = 0;
+}
+
+/**
+ * @brief Inserts a key that is not in the map yet; grows at half load.
+ *
+ * @return BtPtrSlot* The slot of key with value, index and extra cleared,
+ *                    or NULL if the map could not grow.
+ */
+BtPtrSlot *btPtrMapInsertHashed(BtPtrMap *map, const void *key, uint64_t hash, BtPtrSame same)
+{
+    if ((map->count + 1) * 2 > map->capacity)
+    {
+        uint32_t capacity = map->capacity * 2;
+        BtPtrSlot *slots = calloc(capacity, sizeof(BtPtrSlot));
+        if (!slots)
+            return NULL;
+        // 键互不相同, 按保存的哈希放进第一个空槽即可
+        for (uint32_t i = 0; i < map->capacity; i++)
+        {
+            if (!map->slots[i].key)
+                continue;
+            uint32_t j = (uint32_t)map->slots[i].hash & (capacity - 1);
+            while (slots[j].key)
+                j = (j + 1) & (capacity - 1);
+            slots[j] = map->slots[i];
+        }
+        free(map->slots);
+        map->slots = slots;
+        map->capacity = capacity;
+    }
+    BtPtrSlot *slot = btPtrMapFindHashed(map, key, hash, same);
+    *slot = (BtPtrSlot){key, NULL, hash, 0, 0};
+    map->count++;
+    return slot;
+}
+
+static uint32_t hashAction(BtAction action)
+{
+    uintptr_t value = (uintptr_t)action.action ^ ((uintptr_t)action.ctx_action * 31u) ^
+                      ((uintptr_t)action.async * 131u) ^ ((uintptr_t)action.halt * 257u);
+    value ^= value >> 17;
+    value *= 0x9E3779B1u;
+    return (uint32_t)(value ^ (value >> 15));
+}
+
+static int sameAction(BtAction a, BtAction b)
+{
+    return a.action == b.action && a.ctx_action == b.ctx_action && a.async == b.async && a.halt == b.halt;
+}
+
+static int actionMapGrow(BtActionMap *map)
+{
+    uint32_t capacity = map->capacity ? map->capacity * 2 : 16;
+    BtAction *keys = calloc(capacity, sizeof(*keys));
+    uint32_t *values = malloc(capacity * sizeof(*values));
+    if (!keys || !values)
+    {
+        free(keys);
+        free(values);
+        return 0;
+    }
+    for (uint32_t i = 0; i < map->capacity; i++)
+    {
+        if (btActionIsEmpty(map->keys[i]))
+            continue;
+        uint32_t slot = hashAction(map->keys[i]) & (capacity - 1);
+        while (!btActionIsEmpty(keys[slot]))
+            slot = (slot + 1) & (capacity - 1);
+        keys[slot] = map->keys[i];
+        values[slot] = map->values[i];
+    }
+    free(map->keys);
+    free(map->values);
+    map->keys = keys;
+    map->values = values;
+    map->capacity = capacity;
+    return 1;
+}
+
+/**
+ * @brief Looks up an action in the map, adding it if it is new.
+ *
+ * Actions are numbered in the order they are first inserted.
+ *
+ * @return int 1 on success, 0 if the map could not grow.
+ */
+int btActionMapInsert(BtActionMap *map, BtAction action, uint32_t *index)
+{
+    if ((map->count + 1) * 2 > map->capacity && !actionMapGrow(map))
+        return 0;
+
+    uint32_t slot = hashAction(action) & (map->capacity - 1);
+    while (!btActionIsEmpty(map->keys[slot]))
+    {
+        if (sameAction(map->keys[slot], action))
+        {
+            *index = map->values[slot];
+            return 1;
+        }
+        slot = (slot + 1) & (map->capacity - 1);
+    }
+    map->keys[slot] = action;
+    map->values[slot] = map->count;
+    *index = map->count++;
+    return 1;
+}
+
+void btActionMapFree(BtActionMap *map)
+{
+    free(map->keys);
+    free(map->values);
+    map->keys = NULL;
+    map->values = NULL;
+}
+
+/**
+ * @brief Sleeps for ms milliseconds, resuming after signals.
+ *
+ * Used by the blocking delay decorator of the execute engines.
+ */
+void btSleepMs(uint32_t ms)
+{
+    struct timespec ts = {ms / 1000u, (long)(ms % 1000u) * 1000000L};
+    while (nanosleep(&ts, &ts) == -1 && errno == EINTR)
+        ;
+}
@@ -0,0 +1,151 @@
+#ifndef BEHAVIOR_TREE_INTERNAL_H
+#define BEHAVIOR_TREE_INTERNAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "BehaviorTree.h"
+#include "BehaviorTreeFlat.h"
+
+/*
+ * Helpers shared by the tree passes and the read-only engines. Not part of
+ * the public API.
+ */
+
+/**
+ * @brief Open-addressing hash table keyed by pointer.
+ *
+ * Linear probing over a power-of-two array that doubles at half load. A slot
+ * is empty while its key is NULL. Besides the key a slot holds a value
+ * pointer and two words whose meaning is up to the caller (a node index,
+ * a parent count, NEVER_* flags...). Keys can also be looked up by
+ * structure: btPtrMapFindHashed takes the caller's hash and equality.
+ */
+typedef struct BtPtrSlot
+{
+    const void *key; // NULL 表示空槽
+    void *value;
+    uint64_t hash;
+    uint32_t index;
+    uint32_t extra;
+} BtPtrSlot;
+
+typedef struct BtPtrMap
+{
+    BtPtrSlot *slots;
+    uint32_t capacity; // 2 的幂
+    uint32_t count;
+} BtPtrMap;
+
+typedef int (*BtPtrSame)(const void *a, const void *b);
+
+uint64_t btHashPointer(const void *pointer);
+int btPtrMapInit(BtPtrMap *map);
+void btPtrMapClear(BtPtrMap *map);
+void btPtrMapFree(BtPtrMap *map);
+BtPtrSlot *btPtrMapInsertHashed(BtPtrMap *map, const void *key, uint64_t hash, BtPtrSame same);
+
+/**
+ * @brief Returns the slot of key, or the empty slot where it would go.
+ *
+ * same is NULL to compare keys by pointer, otherwise keys with equal hashes
+ * are compared with it.
+ */
+static inline BtPtrSlot *btPtrMapFindHashed(const BtPtrMap *map, const void *key, uint64_t hash, BtPtrSame same)
+{
+    uint32_t mask = map->capacity - 1;
+    for (uint32_t i = (uint32_t)hash & mask;; i = (i + 1) & mask)
+    {
+        BtPtrSlot *slot = &map->slots[i];
+        if (!slot->key || slot->key == key || (same && slot->hash == hash && same(slot->key, key)))
+            return slot;
+    }
+}
+
+static inline BtPtrSlot *btPtrMapFind(const BtPtrMap *map, const void *key)
+{
+    return btPtrMapFindHashed(map, key, btHashPointer(key), NULL);
+}
+
+// 插入新键, 返回其余字段已清零的槽; 内存不足时返回 NULL
+static inline BtPtrSlot *btPtrMapInsert(BtPtrMap *map, const void *key)
+{
+    return btPtrMapInsertHashed(map, key, btHashPointer(key), NULL);
+}
+
+/**
+ * @brief Deduplicated action table of btCompileTree and btCompactTree.
+ */
+typedef struct BtActionMap
+{
+    BtAction *keys;
+    uint32_t *values;
+    uint32_t capacity; // 2 的幂
+    uint32_t count;
+} BtActionMap;
+
+int btActionMapInsert(BtActionMap *map, BtAction action, uint32_t *index);
+void btActionMapFree(BtActionMap *map);
+
+static inline int btActionIsEmpty(BtAction action)
+{
+    return action.action == NULL && action.ctx_action == NULL && action.async == NULL;
+}
+
+void btSleepMs(uint32_t ms);
+
+/**
+ * @brief Executes a decorator of a read-only tree (executeFlat, executeCompact).
+ *
+ * The engines only differ in how they locate and run children, so they
+ * share the decorator semantics here: children[0] is the decorated child,
+ * children[1] and children[2] the branches of a conditional decorator, count
+ * how many of them exist. run executes the node at an index of tree. param
+ * is the repeat count or the duration in milliseconds. Cooldown and cache
+ * decorators keep no state between calls and simply run their child.
+ */
+static inline int btRunDecorator(const void *tree, BtContext *ctx, uint32_t type, uint32_t param,
+                                 const uint32_t *children, uint32_t count,
+                                 int (*run)(const void *tree, BtContext *ctx, uint32_t index))
+{
+    int result = 0;
+
+    switch (type)
+    {
+    case DECORATOR_TYPE_INVERT:
+        return !run(tree, ctx, children[0]);
+    case DECORATOR_TYPE_REPEAT:
+        while (param--) // repeat 为 0 时失败
+            result = run(tree, ctx, children[0]);
+        return result;
+    case DECORATOR_TYPE_REPEAT_UNTIL_SUCCESS:
+        while (!(result = run(tree, ctx, children[0])))
+            ;
+        return result;
+    case DECORATOR_TYPE_CONDITIONAL:
+        result = run(tree, ctx, children[0]);
+        if (count == 1)
+            return result; // 只有条件子节点
+        if (result)
+            return run(tree, ctx, children[1]);
+        return count > 2 ? run(tree, ctx, children[2]) : 0;
+    case DECORATOR_TYPE_DELAY:
+        result = run(tree, ctx, children[0]);
+        if (result)
+            btSleepMs(param);
+        return result;
+    case DECORATOR_TYPE_TIMEOUT:
+    {
+        uint64_t start = btMonotonicMs();
+        result = run(tree, ctx, children[0]);
+        return btMonotonicMs() - start > param ? 0 : result;
+    }
+    case DECORATOR_TYPE_COOLDOWN:
+    case DECORATOR_TYPE_CACHE:
+        // 冷却和缓存需要跨调用的状态, 只在 tick 模式 (tickInstance) 中生效
+        return run(tree, ctx, children[0]);
+    default:
+        return 0;
+    }
+}
+
+#endif // BEHAVIOR_TREE_INTERNAL_H
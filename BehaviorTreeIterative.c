@@ -0,0 +1,521 @@
+#include "BehaviorTreeIterative.h"
+#include "BehaviorTreeAsync.h"
+#include "BehaviorTreeCache.h"
+#include "BehaviorTreeInternal.h"
+#include "BehaviorTreeProfile.h"
+#include "BehaviorTreeTrace.h"
+#include "BehaviorTreeUtility.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// GCC/Clang: 用标签地址表分派 (computed goto), 其他编译器退回 switch
+#if defined(__GNUC__) && !defined(BT_NO_COMPUTED_GOTO)
+#define BT_COMPUTED_GOTO
+#endif
+
+// 有栈帧的节点在子节点返回后从哪里继续
+enum
+{
+    OP_SEQUENCE,
+    OP_SELECTOR,
+    OP_PARALLEL,
+    OP_INVERT,
+    OP_REPEAT,
+    OP_REPEAT_UNTIL_SUCCESS,
+    OP_CONDITIONAL,
+    OP_DELAY,
+    OP_TIMEOUT,
+    OP_COOLDOWN,
+    OP_CACHE,
+    OP_UTILITY
+};
+
+// 分派表: (值, 标签)
+#define ENTER_NODE(X)                        \
+    X(NODE_TYPE_ACTION, enter_leaf)          \
+    X(NODE_TYPE_CONDITION, enter_leaf)       \
+    X(NODE_TYPE_SEQUENCE, enter_sequence)    \
+    X(NODE_TYPE_SELECTOR, enter_selector)    \
+    X(NODE_TYPE_PARALLEL, enter_parallel)    \
+    X(NODE_TYPE_DECORATOR, enter_decorator)  \
+    X(NODE_TYPE_MEMORY, enter_memory)        \
+    X(NODE_TYPE_UTILITY, enter_utility)
+
+#define ENTER_DECORATOR(X)                                          \
+    X(DECORATOR_TYPE_INVERT, enter_invert)                          \
+    X(DECORATOR_TYPE_REPEAT, enter_repeat)                          \
+    X(DECORATOR_TYPE_REPEAT_UNTIL_SUCCESS, enter_repeat_until_success) \
+    X(DECORATOR_TYPE_CONDITIONAL, enter_conditional)                \
+    X(DECORATOR_TYPE_DELAY, enter_delay)                            \
+    X(DECORATOR_TYPE_TIMEOUT, enter_timeout)                        \
+    X(DECORATOR_TYPE_COOLDOWN, enter_cooldown)                      \
+    X(DECORATOR_TYPE_CACHE, enter_cache)
+
+#define RESUME(X)                                             \
+    X(OP_SEQUENCE, resume_sequence)                           \
+    X(OP_SELECTOR, resume_selector)                           \
+    X(OP_PARALLEL, resume_parallel)                           \
+    X(OP_INVERT, resume_invert)                               \
+    X(OP_REPEAT, resume_repeat)                               \
+    X(OP_REPEAT_UNTIL_SUCCESS, resume_repeat_until_success)   \
+    X(OP_CONDITIONAL, resume_conditional)                     \
+    X(OP_DELAY, resume_delay)                                 \
+    X(OP_TIMEOUT, resume_timeout)                             \
+    X(OP_COOLDOWN, resume_cooldown)                           \
+    X(OP_CACHE, resume_cache)                                 \
+    X(OP_UTILITY, resume_utility)
+
+#ifdef BT_COMPUTED_GOTO
+#define LABEL_ADDRESS(value, label) [value] = &&label,
+#define DISPATCH(list, table, value)                                              \
+    do                                                                            \
+    {                                                                             \
+        unsigned dispatch_ = (unsigned)(value);                                   \
+        if (dispatch_ < sizeof(table) / sizeof(table[0]))                         \
+            goto *table[dispatch_];                                               \
+        goto unknown;                                                             \
+    } while (0)
+#else
+#define LABEL_CASE(value, label) \
+    case value:                  \
+        goto label;
+#define DISPATCH(list, table, value) \
+    do                               \
+    {                                \
+        switch (value)               \
+        {                            \
+            list(LABEL_CASE)         \
+        default:                     \
+            goto unknown;            \
+        }                            \
+    } while (0)
+#endif
+
+// 节点结束: 性能统计 (仅 BT_ENABLE_PROFILING) 和追踪
+#ifdef BT_ENABLE_PROFILING
+#define NODE_END(node, result, start)                                       \
+    do                                                                      \
+    {                                                                       \
+        btProfileEnd(node, (result) ? BT_SUCCESS : BT_FAILURE, start);      \
+        btTraceResult(node, (result) ? BT_SUCCESS : BT_FAILURE);            \
+    } while (0)
+#else
+#define NODE_END(node, result, start) btTraceResult(node, (result) ? BT_SUCCESS : BT_FAILURE)
+#endif
+
+typedef struct Frame
+{
+    BehaviorNode *node;
+    uint32_t index;   // 下一个子节点 / 剩余次数 / conditional 阶段
+    uint32_t a;       // parallel 还需的成功数 / timeout 开始时间 / cache 时间
+    uint32_t b;       // parallel 还需的失败数
+    uint8_t op;
+#ifdef BT_ENABLE_PROFILING
+    uint64_t start;
+#endif
+} Frame;
+
+static _Thread_local Frame frames[BT_ITERATIVE_MAX_DEPTH];
+static _Thread_local int framesInUse; // action 中再次执行树时另外分配栈帧
+
+static void nullNode(void)
+{
+    fprintf(stderr, "NULL node in behavior tree\n");
+    exit(EXIT_FAILURE);
+}
+
+// 与 callAction 相同的回退顺序
+static inline int callLeaf(BehaviorNode *node, BtContext *ctx)
+{
+    if (node->ctx_action)
+        return node->ctx_action(ctx);
+    if (node->action)
+        return node->action();
+    return btAsyncRun(node->async, ctx);
+}
+
+static inline int runLeaf(BehaviorNode *node, BtContext *ctx)
+{
+#ifdef BT_ENABLE_PROFILING
+    uint64_t start = btProfileBegin(node);
+#endif
+    int result = callLeaf(node, ctx);
+    NODE_END(node, result, start);
+    return result;
+}
+
+/**
+ * @brief Runs a tree with an explicit stack instead of recursion.
+ *
+ * Every composite or decorator node that has to wait for a child pushes one
+ * frame; leaves and nodes that finish without running a child (empty
+ * composites, cooldown and cache hits) push none. Leaf children are called
+ * in place, other children are entered through the node type table. When a
+ * child is done its result is handed to the resume label of the frame on top.
+ */
+static int runFrames(Frame *base, BehaviorNode *root, BtContext *ctx, uint32_t tick)
+{
+#ifdef BT_COMPUTED_GOTO
+    static void *const nodeTable[] = {ENTER_NODE(LABEL_ADDRESS)};
+    static void *const decoratorTable[] = {ENTER_DECORATOR(LABEL_ADDRESS)};
+    static void *const resumeTable[] = {RESUME(LABEL_ADDRESS)};
+#endif
+    Frame *const limit = base + BT_ITERATIVE_MAX_DEPTH;
+    Frame *frame = base - 1; // 栈顶, base - 1 表示空栈
+    BehaviorNode *node = root;
+    uint32_t now, count;
+    int result = 0;
+#ifdef BT_ENABLE_PROFILING
+    uint64_t start = 0;
+#endif
+
+#ifdef BT_ENABLE_PROFILING
+#define PUSH(opcode)                     \
+    do                                   \
+    {                                    \
+        if (frame + 1 == limit)          \
+            goto overflow;               \
+        frame++;                         \
+        frame->node = node;              \
+        frame->op = opcode;              \
+        frame->index = 0;                \
+        frame->start = start;            \
+    } while (0)
+#else
+#define PUSH(opcode)                     \
+    do                                   \
+    {                                    \
+        if (frame + 1 == limit)          \
+            goto overflow;               \
+        frame++;                         \
+        frame->node = node;              \
+        frame->op = opcode;              \
+        frame->index = 0;                \
+    } while (0)
+#endif
+
+// 叶子直接调用, 不经过分派也不压栈; 其他节点从 enter 开始
+#define DESCEND(child, resume)                             \
+    do                                                     \
+    {                                                      \
+        BehaviorNode *child_ = (child);                    \
+        if (child_ && child_->type <= NODE_TYPE_CONDITION) \
+        {                                                  \
+            result = runLeaf(child_, ctx);                 \
+            goto resume;                                   \
+        }                                                  \
+        node = child_;                                     \
+        goto enter;                                        \
+    } while (0)
+
+enter:
+    if (node == NULL)
+        nullNode();
+#ifdef BT_ENABLE_PROFILING
+    start = btProfileBegin(node);
+#endif
+    DISPATCH(ENTER_NODE, nodeTable, node->type);
+
+enter_leaf:
+    result = callLeaf(node, ctx);
+    goto finish;
+
+enter_memory:
+    // 一次执行完所有子节点, 与递归引擎相同
+    if (node->params.memory.kind == MEMORY_SELECTOR)
+        goto enter_selector;
+    goto enter_sequence;
+
+enter_sequence:
+    if (node->child_count == 0)
+    {
+        result = 1;
+        goto finish;
+    }
+    PUSH(OP_SEQUENCE);
+    DESCEND(node->children[0], resume_sequence);
+
+resume_sequence:
+    if (!result)
+        goto pop;
+    if (++frame->index == (uint32_t)node->child_count)
+    {
+        result = 1;
+        goto pop;
+    }
+    DESCEND(node->children[frame->index], resume_sequence);
+
+enter_selector:
+    if (node->child_count == 0)
+    {
+        result = 0;
+        goto finish;
+    }
+    PUSH(OP_SELECTOR);
+    DESCEND(node->children[0], resume_selector);
+
+resume_selector:
+    if (result)
+    {
+        result = 1;
+        goto pop;
+    }
+    if (++frame->index == (uint32_t)node->child_count)
+        goto pop;
+    DESCEND(node->children[frame->index], resume_selector);
+
+enter_utility:
+    count = btUtilityChoose(node->params.utility.table, ctx, (BtUtilityMode)node->params.utility.mode,
+                            &node->state.counter);
+    PUSH(OP_UTILITY);
+    DESCEND(node->children[count], resume_utility);
+
+resume_utility:
+    goto pop; // 结果就是被选中的子节点的结果
+
+enter_parallel:
+    if (node->child_count == 0)
+    {
+        result = 0;
+        goto finish;
+    }
+    PUSH(OP_PARALLEL);
+    // 阈值的解析与 parallelThresholds 相同, 这里记录的是剩余数量
+    count = (uint32_t)node->child_count;
+    frame->a = node->params.parallel.success_threshold;
+    if (frame->a == 0 || frame->a > count)
+        frame->a = count;
+    frame->b = node->params.parallel.failure_threshold;
+    if (frame->b == 0)
+        frame->b = count - frame->a + 1;
+    DESCEND(node->children[0], resume_parallel);
+
+resume_parallel:
+    // 按子节点顺序第一个达到的阈值决定结果, 之后的子节点不再执行
+    if (result)
+    {
+        if (--frame->a == 0)
+        {
+            result = 1;
+            goto pop;
+        }
+    }
+    else if (--frame->b == 0)
+    {
+        goto pop;
+    }
+    if (++frame->index == (uint32_t)node->child_count)
+    {
+        result = 0;
+        goto pop;
+    }
+    DESCEND(node->children[frame->index], resume_parallel);
+
+enter_decorator:
+    if (node->child_count == 0)
+        nullNode();
+    DISPATCH(ENTER_DECORATOR, decoratorTable, node->decorator->type);
+
+enter_invert:
+    PUSH(OP_INVERT);
+    DESCEND(node->children[0], resume_invert);
+
+resume_invert:
+    result = result == 0 ? 1 : 0;
+    goto pop;
+
+enter_repeat:
+    if (node->decorator->params.repeat == 0)
+    {
+        result = 0;
+        goto finish;
+    }
+    PUSH(OP_REPEAT);
+    frame->index = node->decorator->params.repeat;
+    DESCEND(node->children[0], resume_repeat);
+
+resume_repeat:
+    if (--frame->index == 0)
+        goto pop;
+    DESCEND(node->children[0], resume_repeat);
+
+enter_repeat_until_success:
+    PUSH(OP_REPEAT_UNTIL_SUCCESS);
+    DESCEND(node->children[0], resume_repeat_until_success);
+
+resume_repeat_until_success:
+    if (result)
+        goto pop;
+    DESCEND(node->children[0], resume_repeat_until_success);
+
+enter_conditional:
+    PUSH(OP_CONDITIONAL);
+    DESCEND(node->children[0], resume_conditional);
+
+resume_conditional:
+    // index 0: 刚执行完条件; 1: 刚执行完分支
+    if (frame->index == 1 || node->child_count == 1)
+        goto pop;
+    if (!result && node->child_count < 3)
+        goto pop;
+    frame->index = 1;
+    DESCEND(node->children[result ? 1 : 2], resume_conditional);
+
+enter_delay:
+    PUSH(OP_DELAY);
+    DESCEND(node->children[0], resume_delay);
+
+resume_delay:
+    if (result == 1)
+        btSleepMs(btDecoratorDurationMs(node->decorator));
+    goto pop;
+
+enter_timeout:
+    PUSH(OP_TIMEOUT);
+    frame->a = (uint32_t)btMonotonicMs();
+    DESCEND(node->children[0], resume_timeout);
+
+resume_timeout:
+    if ((uint32_t)btMonotonicMs() - frame->a > node->decorator->params.timeout)
+        result = 0;
+    goto pop;
+
+enter_cooldown:
+    now = (uint32_t)btMonotonicMs();
+    if (node->state.running_child == 1 && (int32_t)(now - node->state.counter) < 0)
+    {
+        result = 0;
+        goto finish;
+    }
+    PUSH(OP_COOLDOWN);
+    DESCEND(node->children[0], resume_cooldown);
+
+resume_cooldown:
+    node->state.counter = (uint32_t)btMonotonicMs() + node->decorator->params.cooldown;
+    node->state.running_child = 1;
+    goto pop;
+
+enter_cache:
+    {
+        uint32_t ttl = node->decorator->params.ttl;
+        NodeStatus status;
+
+        now = ttl == BT_CACHE_PER_TICK ? 0 : (uint32_t)btMonotonicMs();
+        if (btCacheLookupShared(&node->state, ttl, now, tick, &status))
+        {
+            result = status;
+            goto finish;
+        }
+    }
+    PUSH(OP_CACHE);
+    frame->a = now;
+    DESCEND(node->children[0], resume_cache);
+
+resume_cache:
+    btCacheStoreShared(&node->state, node->decorator->params.ttl, frame->a, tick, result ? BT_SUCCESS : BT_FAILURE);
+    goto pop;
+
+unknown:
+    result = 0; // 未知的节点或装饰器类型
+    goto finish;
+
+pop:
+    NODE_END(frame->node, result, frame->start);
+    frame--;
+    goto leave;
+
+finish:
+    NODE_END(node, result, start);
+
+leave:
+    if (frame < base)
+        return result;
+    node = frame->node;
+    DISPATCH(RESUME, resumeTable, frame->op);
+
+overflow:
+    return 0;
+#undef PUSH
+#undef DESCEND
+}
+
+/**
+ * @brief Executes a tree with the iterative engine.
+ *
+ * @return int Same as the recursive executeNode. Trees with btTreeDepth(root)
+ *             <= BT_ITERATIVE_MAX_DEPTH always run, deeper ones may fail.
+ */
+int btExecuteIterative(BehaviorNode *root, BtContext *ctx, uint32_t tick)
+{
+    if (framesInUse)
+    {
+        // action 中再次执行树: 线程的栈帧正被外层使用
+        Frame *own = (Frame *)malloc(sizeof(Frame) * BT_ITERATIVE_MAX_DEPTH);
+        if (!own)
+            return 0;
+        int result = runFrames(own, root, ctx, tick);
+        free(own);
+        return result;
+    }
+    framesInUse = 1;
+    int result = runFrames(frames, root, ctx, tick);
+    framesInUse = 0;
+    return result;
+}
+
+/**
+ * @brief Returns the depth of a tree, 1 for a single node.
+ *
+ * Walks the tree with a heap-allocated stack, so it works for trees too deep
+ * for recursion. Shared subtrees are visited once per parent.
+ *
+ * @return int The depth, 0 for NULL, -1 if memory runs out.
+ */
+int btTreeDepth(const BehaviorNode *root)
+{
+    typedef struct
+    {
+        const BehaviorNode *node;
+        int next;
+    } Visit;
+    Visit *stack;
+    int capacity = 64, top = 0, depth = 0;
+
+    if (!root)
+        return 0;
+    stack = malloc(sizeof(Visit) * (size_t)capacity);
+    if (!stack)
+        return -1;
+    stack[0].node = root;
+    stack[0].next = 0;
+    while (top >= 0)
+    {
+        Visit *visit = &stack[top];
+        if (top + 1 > depth)
+            depth = top + 1;
+        if (visit->next == visit->node->child_count || !visit->node->children)
+        {
+            top--;
+            continue;
+        }
+        const BehaviorNode *child = visit->node->children[visit->next++];
+        if (!child)
+            continue;
+        if (top + 1 == capacity)
+        {
+            Visit *grown = realloc(stack, sizeof(Visit) * (size_t)capacity * 2);
+            if (!grown)
+            {
+                free(stack);
+                return -1;
+            }
+            stack = grown;
+            capacity *= 2;
+        }
+        top++;
+        stack[top].node = child;
+        stack[top].next = 0;
+    }
+    free(stack);
+    return depth;
+}
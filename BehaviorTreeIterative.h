@@ -0,0 +1,29 @@
+#ifndef BEHAVIOR_TREE_ITERATIVE_H
+#define BEHAVIOR_TREE_ITERATIVE_H
+
+#include "BehaviorTree.h"
+
+/*
+ * Non-recursive executeNode, selected with btSetEngine(BT_ENGINE_ITERATIVE).
+ *
+ * Nodes are walked with an explicit stack of BT_ITERATIVE_MAX_DEPTH frames
+ * preallocated per thread, and dispatched through a table of labels
+ * (computed goto) where the compiler supports it. Results are the same as
+ * with the recursive engine, but the C stack no longer grows with the depth
+ * of the tree: a node deeper than BT_ITERATIVE_MAX_DEPTH fails instead. Use
+ * btTreeDepth to reject such trees when they are loaded.
+ *
+ * Parallel children always run one after another here; under
+ * executeNodeParallel the recursive engine is used so they can be spread
+ * over the executor's threads.
+ */
+#ifndef BT_ITERATIVE_MAX_DEPTH
+#define BT_ITERATIVE_MAX_DEPTH 1024
+#endif
+
+int btTreeDepth(const BehaviorNode *root);
+
+// 供 executeNodeWithContext 使用, tick 为本次执行的序号 (缓存装饰器)
+int btExecuteIterative(BehaviorNode *root, BtContext *ctx, uint32_t tick);
+
+#endif // BEHAVIOR_TREE_ITERATIVE_H
@@ -0,0 +1,350 @@
+#include "BehaviorTreeOptimize.h"
+#include "BehaviorTreeInternal.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define NEVER_FAILS 0x1u     // 只会返回 SUCCESS 或 RUNNING
+#define NEVER_SUCCEEDS 0x2u  // 只会返回 FAILURE 或 RUNNING
+
+typedef struct
+{
+    BehaviorNode *node;
+    int next; // 下一个要处理的子节点
+} Visit;
+
+// 已处理的节点 -> 代替它的节点 (value) 及其结果性质 (index 中的 NEVER_*)
+static int tableInsert(BtPtrMap *table, const BehaviorNode *key, BehaviorNode *value, uint32_t never)
+{
+    BtPtrSlot *slot = btPtrMapInsert(table, key);
+    if (!slot)
+        return 0;
+    slot->value = value;
+    slot->index = never;
+    return 1;
+}
+
+// 放开一个父节点对 node 的引用, 最后一个引用消失时释放整棵子树
+static void release(BehaviorNode *node)
+{
+    if (node && atomic_fetch_sub_explicit(&node->reference_count, 1, memory_order_acq_rel) <= 1)
+    {
+        atomic_store_explicit(&node->reference_count, 0, memory_order_relaxed);
+        freeBehaviorTree(node);
+    }
+}
+
+static uint32_t neverOf(const BtPtrMap *memo, const BehaviorNode *node)
+{
+    return node ? btPtrMapFind(memo, node)->index : 0;
+}
+
+static int isComposite(const BehaviorNode *node)
+{
+    return node->type == NODE_TYPE_SEQUENCE || node->type == NODE_TYPE_SELECTOR || node->type == NODE_TYPE_MEMORY;
+}
+
+static int isSelector(const BehaviorNode *node)
+{
+    return node->type == NODE_TYPE_SELECTOR ||
+           (node->type == NODE_TYPE_MEMORY && node->params.memory.kind == MEMORY_SELECTOR);
+}
+
+// child 的子节点可以直接并入 node: 同类型, 记忆节点还要求同种类
+static int mergeable(const BehaviorNode *node, const BehaviorNode *child)
+{
+    if (!child || child->type != node->type || child->child_count == 0)
+        return 0;
+    return node->type != NODE_TYPE_MEMORY || child->params.memory.kind == node->params.memory.kind;
+}
+
+/**
+ * @brief Flattens nested composites of node and drops its unreachable children.
+ *
+ * A sequence stops at the first child that fails or runs, so the children
+ * after one that never succeeds are never ticked; the same holds for a
+ * selector after a child that never fails.
+ *
+ * @return int 1 on success, 0 if memory runs out; node is then unchanged.
+ */
+static int rewriteComposite(BehaviorNode *node, const BtPtrMap *memo, BtOptimizeStats *stats)
+{
+    uint32_t decides = isSelector(node) ? NEVER_FAILS : NEVER_SUCCEEDS;
+    int bound = 0, count = 0, changed = 0;
+
+    if (node->child_count == 0)
+        return 1;
+    for (int i = 0; i < node->child_count; i++)
+        bound += mergeable(node, node->children[i]) ? node->children[i]->child_count : 1;
+
+    BehaviorNode **children = malloc(sizeof(BehaviorNode *) * (size_t)bound);
+    if (!children)
+        return 0;
+
+    int i, stop = 0;
+    for (i = 0; i < node->child_count && !stop; i++)
+    {
+        BehaviorNode *child = node->children[i];
+        if (!mergeable(node, child))
+        {
+            children[count++] = child;
+            stop = (neverOf(memo, child) & decides) != 0;
+            continue;
+        }
+        // 已处理过的子节点内部不会再有可并入的节点, 不可达的部分也已删除
+        for (int j = 0; j < child->child_count && !stop; j++)
+        {
+            children[count++] = child->children[j];
+            stop = (neverOf(memo, child->children[j]) & decides) != 0;
+            if (stop)
+                stats->pruned += (uint32_t)(child->child_count - j - 1);
+        }
+        stats->flattened++;
+        changed = 1;
+    }
+    stats->pruned += (uint32_t)(node->child_count - i);
+    if (!changed && i == node->child_count)
+    {
+        free(children);
+        return 1;
+    }
+
+    // 先为新数组中的子节点加引用, 再放开旧数组, 被并入的节点的子节点不会被提前释放
+    for (int k = 0; k < count; k++)
+    {
+        if (children[k])
+            atomic_fetch_add_explicit(&children[k]->reference_count, 1, memory_order_relaxed);
+    }
+    for (int k = 0; k < node->child_count; k++)
+        release(node->children[k]);
+    free(node->children);
+    node->children = children;
+    node->child_count = count;
+    return 1;
+}
+
+static uint32_t compositeNever(const BehaviorNode *node, const BtPtrMap *memo)
+{
+    uint32_t all = NEVER_FAILS | NEVER_SUCCEEDS, any = 0;
+
+    for (int i = 0; i < node->child_count; i++)
+    {
+        uint32_t never = neverOf(memo, node->children[i]);
+        all &= never;
+        any |= never;
+    }
+    // 序列: 所有子节点都不会失败才不会失败, 任一子节点不会成功就不会成功; 选择器相反
+    if (isSelector(node))
+        return (any & NEVER_FAILS) | (all & NEVER_SUCCEEDS);
+    return (all & NEVER_FAILS) | (any & NEVER_SUCCEEDS);
+}
+
+static uint32_t swapNever(uint32_t never)
+{
+    return ((never & NEVER_FAILS) ? NEVER_SUCCEEDS : 0) | ((never & NEVER_SUCCEEDS) ? NEVER_FAILS : 0);
+}
+
+/**
+ * @brief Rewrites one node whose children have all been processed.
+ *
+ * @param replacement Receives the node that takes the place of node in its
+ *                    parents: node itself or one of its descendants.
+ * @param never       Receives the NEVER_* flags of the result.
+ */
+static int optimizeNode(BehaviorNode *node, const BtPtrMap *memo, BtOptimizeStats *stats,
+                        BehaviorNode **replacement, uint32_t *never)
+{
+    *replacement = node;
+    *never = 0;
+
+    // 子节点换成代替它们的节点
+    for (int i = 0; i < node->child_count; i++)
+    {
+        BehaviorNode *child = node->children[i];
+        if (!child)
+            continue;
+        BehaviorNode *substitute = btPtrMapFind(memo, child)->value;
+        if (substitute != child)
+        {
+            atomic_fetch_add_explicit(&substitute->reference_count, 1, memory_order_relaxed);
+            node->children[i] = substitute;
+            release(child);
+        }
+    }
+
+    if (isComposite(node))
+    {
+        if (!rewriteComposite(node, memo, stats))
+            return 0;
+        *never = compositeNever(node, memo);
+        if (node->child_count == 1 && node->children[0])
+        {
+            *replacement = node->children[0];
+            stats->collapsed++;
+        }
+        return 1;
+    }
+
+    if (node->type != NODE_TYPE_DECORATOR || !node->decorator || node->child_count != 1 || !node->children[0])
+        return 1;
+
+    BehaviorNode *child = node->children[0];
+    switch (node->decorator->type)
+    {
+    case DECORATOR_TYPE_INVERT:
+        *never = swapNever(neverOf(memo, child));
+        // 两次反转: 子节点的子节点直接代替这两个节点
+        if (child->type == NODE_TYPE_DECORATOR && child->decorator &&
+            child->decorator->type == DECORATOR_TYPE_INVERT && child->child_count == 1 && child->children[0])
+        {
+            *replacement = child->children[0];
+            stats->folded++;
+        }
+        break;
+
+    case DECORATOR_TYPE_REPEAT:
+        if (node->decorator->params.repeat == 0)
+        {
+            *never = NEVER_SUCCEEDS; // 子节点不会运行, 所有引擎都失败
+            break;
+        }
+        *never = neverOf(memo, child);
+        if (node->decorator->params.repeat == 1)
+        {
+            *replacement = child;
+            stats->folded++;
+        }
+        break;
+
+    case DECORATOR_TYPE_REPEAT_UNTIL_SUCCESS:
+        *never = NEVER_FAILS;
+        break;
+
+    default:
+        break;
+    }
+    return 1;
+}
+
+// 统计可以从 root 到达的不同节点
+static int countNodes(BehaviorNode *root, BtPtrMap *seen, Visit **stack, int *capacity, uint32_t *count)
+{
+    int top = 0;
+
+    (*stack)[0].node = root;
+    if (!tableInsert(seen, root, root, 0))
+        return 0;
+    *count = 1;
+    while (top >= 0)
+    {
+        BehaviorNode *node = (*stack)[top--].node;
+        for (int i = 0; i < node->child_count; i++)
+        {
+            BehaviorNode *child = node->children[i];
+            if (!child || btPtrMapFind(seen, child)->key)
+                continue;
+            if (!tableInsert(seen, child, child, 0))
+                return 0;
+            if (top + 1 == *capacity)
+            {
+                Visit *grown = realloc(*stack, sizeof(Visit) * (size_t)*capacity * 2);
+                if (!grown)
+                    return 0;
+                *stack = grown;
+                *capacity *= 2;
+            }
+            (*stack)[++top].node = child;
+            (*count)++;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Optimizes a tree built with createBehaviorNode in place.
+ *
+ * Nodes are visited children first, so every rewrite sees children that are
+ * already optimized and the pass reaches a fixed point in one walk; every
+ * node object is visited once even if it is shared. The root itself can be
+ * replaced (e.g. a sequence with one child), so it is passed by reference.
+ * A root that other nodes still point to (reference_count > 0) is kept.
+ *
+ * @param root  Root of the tree, updated to the new root.
+ * @param stats Receives the node counts and what was rewritten, may be NULL.
+ *              The number of nodes removed is nodes_before - nodes_after.
+ * @return int 1 on success, 0 if memory runs out; the tree is then valid
+ *             but only partly optimized.
+ */
+int btOptimizeTree(BehaviorNode **root, BtOptimizeStats *stats)
+{
+    BtOptimizeStats local;
+    BtPtrMap memo;
+    Visit *stack;
+    int capacity = 64, top = 0, ok = 0;
+
+    if (!stats)
+        stats = &local;
+    memset(stats, 0, sizeof(*stats));
+    if (!root || !*root)
+        return 1;
+
+    memo.slots = NULL;
+    stack = malloc(sizeof(Visit) * (size_t)capacity);
+    if (!stack || !btPtrMapInit(&memo))
+        goto done;
+    stack[0].node = *root;
+    stack[0].next = 0;
+
+    while (top >= 0)
+    {
+        Visit *visit = &stack[top];
+        BehaviorNode *node = visit->node;
+
+        // 先处理所有子节点; 已经处理过的共享子节点跳过
+        if (visit->next < node->child_count)
+        {
+            BehaviorNode *child = node->children[visit->next++];
+            if (!child || btPtrMapFind(&memo, child)->key)
+                continue;
+            if (top + 1 == capacity)
+            {
+                Visit *grown = realloc(stack, sizeof(Visit) * (size_t)capacity * 2);
+                if (!grown)
+                    goto done;
+                stack = grown;
+                capacity *= 2;
+            }
+            top++;
+            stack[top].node = child;
+            stack[top].next = 0;
+            continue;
+        }
+        top--;
+
+        BehaviorNode *replacement;
+        uint32_t never;
+        if (!optimizeNode(node, &memo, stats, &replacement, &never) ||
+            !tableInsert(&memo, node, replacement, never))
+        {
+            goto done;
+        }
+        stats->nodes_before++;
+    }
+
+    // 根节点被替换时, 先持有新根再释放旧根与中间节点
+    BehaviorNode *replacement = btPtrMapFind(&memo, *root)->value;
+    if (replacement != *root && atomic_load_explicit(&(*root)->reference_count, memory_order_relaxed) <= 0)
+    {
+        atomic_fetch_add_explicit(&replacement->reference_count, 1, memory_order_relaxed);
+        freeBehaviorTree(*root);
+        atomic_fetch_sub_explicit(&replacement->reference_count, 1, memory_order_relaxed);
+        *root = replacement;
+    }
+
+    btPtrMapClear(&memo);
+    ok = countNodes(*root, &memo, &stack, &capacity, &stats->nodes_after);
+
+done:
+    free(stack);
+    btPtrMapFree(&memo);
+    return ok;
+}
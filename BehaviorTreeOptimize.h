@@ -0,0 +1,43 @@
+#ifndef BEHAVIOR_TREE_OPTIMIZE_H
+#define BEHAVIOR_TREE_OPTIMIZE_H
+
+#include <stdint.h>
+#include "BehaviorTree.h"
+
+/*
+ * Rewrites a heap-allocated tree into a smaller tree with the same results
+ * under executeNode, tickTree and btCompileTree:
+ *
+ *   - a sequence directly under a sequence (selector under selector, memory
+ *     node under a memory node of the same kind) is replaced by its children;
+ *   - two nested invert decorators and repeat decorators with a count of 1
+ *     are replaced by their child;
+ *   - sequences, selectors and memory nodes with one child are replaced by
+ *     that child;
+ *   - children that can never be reached are removed: those of a selector
+ *     after a child that never fails (repeat-until-success, or a composite
+ *     made of such children) and those of a sequence after a child that
+ *     never succeeds.
+ *
+ * Intermediate nodes disappear, so they no longer show up in profiles and
+ * traces, and the tick state of removed nodes is lost: optimize a tree
+ * before it is first ticked. reference_count stays exact, removed nodes are
+ * freed once their last parent lets go of them, and trees that share nodes
+ * (btDedupTree) are handled.
+ *
+ * Not for arena trees: child arrays are reallocated and nodes released with
+ * free().
+ */
+typedef struct BtOptimizeStats
+{
+    uint32_t nodes_before; // 不同节点对象的个数
+    uint32_t nodes_after;
+    uint32_t flattened; // 并入父节点的嵌套组合节点
+    uint32_t folded;    // 去掉的双重反转和 repeat(1)
+    uint32_t collapsed; // 被唯一子节点替代的组合节点
+    uint32_t pruned;    // 删除的不可达子节点 (按子树计)
+} BtOptimizeStats;
+
+int btOptimizeTree(BehaviorNode **root, BtOptimizeStats *stats);
+
+#endif // BEHAVIOR_TREE_OPTIMIZE_H
@@ -0,0 +1,463 @@
+#include "BehaviorTreeParallel.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/**
+ * @brief Children of one parallel node.
+ *
+ * Results are aggregated in child order as they arrive: once the finished
+ * prefix of the children reaches a threshold the result is decided, exactly
+ * as if the children had run one after another, and children that have not
+ * started yet are skipped.
+ */
+typedef struct
+{
+    pthread_mutex_t lock;
+    int *results;        // -1 表示尚未完成
+    int count;
+    int prefix;          // 之前的子节点都已完成并计入
+    uint32_t successes;  // 还需的成功数
+    uint32_t failures;   // 还需的失败数
+    atomic_int decided;  // -1 表示尚未决定, 否则为结果
+    atomic_int pending;  // 尚未完成的排队子任务数
+} TaskGroup;
+
+typedef struct
+{
+    BehaviorNode *node;
+    BtContext *ctx;
+    TaskGroup *group;
+    int index;
+    uint32_t tick; // 父节点所在 tick 的序号
+} BtTask;
+
+// 环形双端队列: 所有者在 bottom 端压入/弹出, 窃取者从 top 端取
+typedef struct
+{
+    pthread_mutex_t lock;
+    BtTask *items;
+    size_t top;
+    size_t bottom;
+    size_t capacity; // 2 的幂
+} TaskDeque;
+
+struct BtExecutor
+{
+    int worker_count;
+    int deque_count;
+    pthread_t *threads;
+    TaskDeque *deques; // worker_count 个工作线程队列 + 1 个外部线程共享的注入队列
+    pthread_mutex_t idle_lock;
+    pthread_cond_t idle_cond;
+    atomic_int queued;
+    atomic_int stop;
+};
+
+typedef struct
+{
+    BtExecutor *executor;
+    int index;
+} WorkerStart;
+
+static _Thread_local BtExecutor *currentExecutor = NULL;
+static _Thread_local int currentDeque = 0;
+
+static int dequeInit(TaskDeque *deque)
+{
+    deque->capacity = 64;
+    deque->top = 0;
+    deque->bottom = 0;
+    deque->items = malloc(deque->capacity * sizeof(BtTask));
+    if (!deque->items)
+        return 0;
+    pthread_mutex_init(&deque->lock, NULL);
+    return 1;
+}
+
+static void dequeDestroy(TaskDeque *deque)
+{
+    pthread_mutex_destroy(&deque->lock);
+    free(deque->items);
+}
+
+static int dequePushBottom(TaskDeque *deque, const BtTask *tasks, int count)
+{
+    pthread_mutex_lock(&deque->lock);
+    size_t size = deque->bottom - deque->top;
+    if (size + (size_t)count > deque->capacity)
+    {
+        size_t capacity = deque->capacity;
+        while (size + (size_t)count > capacity)
+            capacity *= 2;
+        BtTask *items = malloc(capacity * sizeof(BtTask));
+        if (!items)
+        {
+            pthread_mutex_unlock(&deque->lock);
+            return 0;
+        }
+        for (size_t i = 0; i < size; i++)
+            items[i] = deque->items[(deque->top + i) & (deque->capacity - 1)];
+        free(deque->items);
+        deque->items = items;
+        deque->capacity = capacity;
+        deque->top = 0;
+        deque->bottom = size;
+    }
+    // 逆序压入, 使所有者先弹出第一个任务, 窃取者先拿到最后一个
+    for (int i = count - 1; i >= 0; i--)
+    {
+        deque->items[deque->bottom++ & (deque->capacity - 1)] = tasks[i];
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return 1;
+}
+
+static int dequePopBottom(TaskDeque *deque, BtTask *task)
+{
+    int found = 0;
+    pthread_mutex_lock(&deque->lock);
+    if (deque->bottom != deque->top)
+    {
+        *task = deque->items[--deque->bottom & (deque->capacity - 1)];
+        found = 1;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return found;
+}
+
+static int dequeStealTop(TaskDeque *deque, BtTask *task)
+{
+    int found = 0;
+    // 窃取不等待锁, 队列忙时换下一个
+    if (pthread_mutex_trylock(&deque->lock) != 0)
+        return 0;
+    if (deque->bottom != deque->top)
+    {
+        *task = deque->items[deque->top++ & (deque->capacity - 1)];
+        found = 1;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return found;
+}
+
+/**
+ * @brief Takes one task: first from the caller's own deque, then by stealing.
+ */
+static int takeTask(BtExecutor *executor, int self, BtTask *task)
+{
+    int dequeCount = executor->deque_count;
+
+    if (atomic_load_explicit(&executor->queued, memory_order_acquire) == 0)
+        return 0;
+    if (dequePopBottom(&executor->deques[self], task))
+        goto taken;
+    for (int i = 1; i < dequeCount; i++)
+    {
+        if (dequeStealTop(&executor->deques[(self + i) % dequeCount], task))
+            goto taken;
+    }
+    return 0;
+
+taken:
+    atomic_fetch_sub_explicit(&executor->queued, 1, memory_order_relaxed);
+    return 1;
+}
+
+// 记录子节点 index 的结果, 并沿子节点顺序推进聚合
+static void groupFinish(TaskGroup *group, int index, int result)
+{
+    pthread_mutex_lock(&group->lock);
+    group->results[index] = result;
+    while (group->prefix < group->count && group->results[group->prefix] >= 0)
+    {
+        if (atomic_load_explicit(&group->decided, memory_order_relaxed) < 0)
+        {
+            if (group->results[group->prefix] ? --group->successes == 0 : --group->failures == 0)
+                atomic_store_explicit(&group->decided, group->results[group->prefix], memory_order_relaxed);
+        }
+        group->prefix++;
+    }
+    pthread_mutex_unlock(&group->lock);
+}
+
+static void runTask(const BtTask *task)
+{
+    TaskGroup *group = task->group;
+    // 结果已经决定时跳过尚未开始的子节点
+    int result = atomic_load_explicit(&group->decided, memory_order_relaxed) < 0
+                     ? btExecuteInTick(task->node, task->ctx, task->tick)
+                     : 0;
+    groupFinish(group, task->index, result);
+    atomic_fetch_sub_explicit(&group->pending, 1, memory_order_release);
+}
+
+static void *workerMain(void *arg)
+{
+    WorkerStart start = *(WorkerStart *)arg;
+    BtExecutor *executor = start.executor;
+    BtTask task;
+
+    free(arg);
+    currentExecutor = executor;
+    currentDeque = start.index;
+
+    while (!atomic_load(&executor->stop))
+    {
+        if (takeTask(executor, start.index, &task))
+        {
+            runTask(&task);
+            continue;
+        }
+
+        pthread_mutex_lock(&executor->idle_lock);
+        while (atomic_load(&executor->queued) == 0 && !atomic_load(&executor->stop))
+        {
+            pthread_cond_wait(&executor->idle_cond, &executor->idle_lock);
+        }
+        pthread_mutex_unlock(&executor->idle_lock);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Creates a work-stealing executor.
+ *
+ * @param thread_count Number of worker threads, 0 for one per online CPU.
+ *                     The thread calling executeNodeParallel also works.
+ * @return BtExecutor* The executor, or NULL if it could not be created.
+ */
+BtExecutor *btExecutorCreate(int thread_count)
+{
+    if (thread_count <= 0)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        thread_count = cpus > 1 ? (int)cpus - 1 : 1;
+    }
+
+    BtExecutor *executor = calloc(1, sizeof(BtExecutor));
+    if (!executor)
+        return NULL;
+    executor->worker_count = thread_count;
+    executor->deque_count = thread_count + 1;
+    executor->threads = calloc((size_t)thread_count, sizeof(pthread_t));
+    executor->deques = calloc((size_t)thread_count + 1, sizeof(TaskDeque));
+    if (!executor->threads || !executor->deques)
+    {
+        free(executor->threads);
+        free(executor->deques);
+        free(executor);
+        return NULL;
+    }
+    for (int i = 0; i <= thread_count; i++)
+    {
+        if (!dequeInit(&executor->deques[i]))
+        {
+            while (i-- > 0)
+                dequeDestroy(&executor->deques[i]);
+            free(executor->threads);
+            free(executor->deques);
+            free(executor);
+            return NULL;
+        }
+    }
+    pthread_mutex_init(&executor->idle_lock, NULL);
+    pthread_cond_init(&executor->idle_cond, NULL);
+    atomic_init(&executor->queued, 0);
+    atomic_init(&executor->stop, 0);
+
+    for (int i = 0; i < thread_count; i++)
+    {
+        WorkerStart *start = malloc(sizeof(WorkerStart));
+        if (start)
+        {
+            start->executor = executor;
+            start->index = i;
+        }
+        if (!start || pthread_create(&executor->threads[i], NULL, workerMain, start) != 0)
+        {
+            free(start);
+            executor->worker_count = i; // 已启动的线程照常回收
+            btExecutorDestroy(executor);
+            return NULL;
+        }
+    }
+    return executor;
+}
+
+/**
+ * @brief Stops the workers and frees the executor.
+ *
+ * Must not be called while executeNodeParallel is running on it.
+ */
+void btExecutorDestroy(BtExecutor *executor)
+{
+    if (!executor)
+        return;
+
+    pthread_mutex_lock(&executor->idle_lock);
+    atomic_store(&executor->stop, 1);
+    pthread_cond_broadcast(&executor->idle_cond);
+    pthread_mutex_unlock(&executor->idle_lock);
+
+    for (int i = 0; i < executor->worker_count; i++)
+    {
+        pthread_join(executor->threads[i], NULL);
+    }
+    for (int i = 0; i < executor->deque_count; i++)
+    {
+        dequeDestroy(&executor->deques[i]);
+    }
+    pthread_mutex_destroy(&executor->idle_lock);
+    pthread_cond_destroy(&executor->idle_cond);
+    free(executor->threads);
+    free(executor->deques);
+    free(executor);
+}
+
+/**
+ * @brief Executes a tree, running the children of parallel nodes on the executor.
+ *
+ * Results are the same as executeNode: parallel results are aggregated in
+ * child order, and children after the point where the result is decided
+ * are skipped unless they already started.
+ *
+ * @param executor Executor returned by btExecutorCreate.
+ * @param node     Root of the tree to execute.
+ * @param ctx      Agent context passed to context actions, may be NULL.
+ * @return int Returns 1 if the tree succeeds, 0 if it fails.
+ */
+int executeNodeParallel(BtExecutor *executor, BehaviorNode *node, BtContext *ctx)
+{
+    BtExecutor *previousExecutor = currentExecutor;
+    int previousDeque = currentDeque;
+    int result;
+
+    if (previousExecutor != executor)
+    {
+        currentExecutor = executor;
+        currentDeque = executor->deque_count - 1; // 外部线程使用注入队列
+    }
+    result = executeNodeWithContext(node, ctx);
+    currentExecutor = previousExecutor;
+    currentDeque = previousDeque;
+    return result;
+}
+
+/**
+ * @brief Returns the executor the calling thread is running on, or NULL.
+ */
+BtExecutor *btCurrentExecutor(void)
+{
+    return currentExecutor;
+}
+
+/**
+ * @brief Runs the children of a parallel node and returns its result.
+ *
+ * Child 0 runs on the calling thread, the others are queued for stealing.
+ * All of them run as part of tick, the tick of the parallel node.
+ * While waiting, the caller executes queued tasks itself. Queued children
+ * that have not started when the result is decided are skipped; children
+ * already running finish normally.
+ *
+ * @return int 1 if success_threshold children succeeded first (in child order), 0 otherwise.
+ */
+int btExecutorRunChildren(BtExecutor *executor,
+                          BehaviorNode **children,
+                          int child_count,
+                          uint32_t success_threshold,
+                          uint32_t failure_threshold,
+                          BtContext *ctx,
+                          uint32_t tick)
+{
+    BtTask stackTasks[16];
+    int stackResults[17];
+    BtTask *tasks = stackTasks;
+    int *results = stackResults;
+    TaskGroup group;
+    int self = currentDeque;
+    int queued = child_count - 1;
+
+    if (queued > 16)
+    {
+        tasks = malloc(sizeof(BtTask) * (size_t)queued);
+        results = malloc(sizeof(int) * (size_t)child_count);
+    }
+    if (!tasks || !results)
+    {
+        if (tasks != stackTasks)
+            free(tasks);
+        if (results != stackResults)
+            free(results);
+        tasks = NULL;
+    }
+    else
+    {
+        for (int i = 0; i < child_count; i++)
+            results[i] = -1;
+        pthread_mutex_init(&group.lock, NULL);
+        group.results = results;
+        group.count = child_count;
+        group.prefix = 0;
+        group.successes = success_threshold;
+        group.failures = failure_threshold;
+        atomic_init(&group.decided, -1);
+        atomic_init(&group.pending, queued);
+        for (int i = 0; i < queued; i++)
+            tasks[i] = (BtTask){children[i + 1], ctx, &group, i + 1, tick};
+    }
+    if (!tasks || !dequePushBottom(&executor->deques[self], tasks, queued))
+    {
+        // 内存不足时退化为顺序执行
+        if (tasks)
+        {
+            pthread_mutex_destroy(&group.lock);
+            if (tasks != stackTasks)
+                free(tasks);
+            if (results != stackResults)
+                free(results);
+        }
+        for (int i = 0; i < child_count; i++)
+        {
+            if (btExecuteInTick(children[i], ctx, tick))
+            {
+                if (--success_threshold == 0)
+                    return 1;
+            }
+            else if (--failure_threshold == 0)
+            {
+                return 0;
+            }
+        }
+        return 0;
+    }
+
+    atomic_fetch_add_explicit(&executor->queued, queued, memory_order_release);
+    pthread_mutex_lock(&executor->idle_lock);
+    pthread_cond_broadcast(&executor->idle_cond);
+    pthread_mutex_unlock(&executor->idle_lock);
+
+    groupFinish(&group, 0, btExecuteInTick(children[0], ctx, tick));
+
+    // 等待期间帮助执行其它任务
+    while (atomic_load_explicit(&group.pending, memory_order_acquire) > 0)
+    {
+        BtTask task;
+        if (takeTask(executor, self, &task))
+            runTask(&task);
+        else
+            sched_yield();
+    }
+
+    int result = atomic_load_explicit(&group.decided, memory_order_relaxed) == 1;
+    pthread_mutex_destroy(&group.lock);
+    if (tasks != stackTasks)
+        free(tasks);
+    if (results != stackResults)
+        free(results);
+    return result;
+}
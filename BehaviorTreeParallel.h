@@ -0,0 +1,33 @@
+#ifndef BEHAVIOR_TREE_PARALLEL_H
+#define BEHAVIOR_TREE_PARALLEL_H
+
+#include "BehaviorTree.h"
+
+/**
+ * @brief Work-stealing thread pool that runs NODE_TYPE_PARALLEL children concurrently.
+ *
+ * Each worker owns a deque: it pushes and pops tasks at the bottom, idle
+ * workers steal from the top of the others. A thread waiting for its
+ * children keeps executing queued tasks, so nested parallel nodes never
+ * deadlock. Actions reached through a parallel node must be thread-safe.
+ */
+typedef struct BtExecutor BtExecutor;
+
+BtExecutor *btExecutorCreate(int thread_count);
+void btExecutorDestroy(BtExecutor *executor);
+int executeNodeParallel(BtExecutor *executor, BehaviorNode *node, BtContext *ctx);
+
+// 供 parallelNode 使用
+BtExecutor *btCurrentExecutor(void);
+int btExecutorRunChildren(BtExecutor *executor,
+                          BehaviorNode **children,
+                          int child_count,
+                          uint32_t success_threshold,
+                          uint32_t failure_threshold,
+                          BtContext *ctx,
+                          uint32_t tick);
+
+// 由 BehaviorTree.c 实现: 在已开始的 tick 中执行子树, 不取新的 tick 序号
+int btExecuteInTick(BehaviorNode *node, BtContext *ctx, uint32_t tick);
+
+#endif // BEHAVIOR_TREE_PARALLEL_H
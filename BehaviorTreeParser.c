@@ -0,0 +1,439 @@
+#include "BehaviorTreeParser.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PARSER_MAX_ARGS 2
+#define PARSER_MAX_NAME 128
+
+typedef enum
+{
+    KIND_SEQUENCE,
+    KIND_SELECTOR,
+    KIND_PARALLEL,
+    KIND_MEMORY_SEQUENCE,
+    KIND_MEMORY_SELECTOR,
+    KIND_INVERT,
+    KIND_REPEAT,
+    KIND_REPEAT_UNTIL_SUCCESS,
+    KIND_CONDITIONAL,
+    KIND_DELAY,
+    KIND_DELAY_MS,
+    KIND_TIMEOUT,
+    KIND_COOLDOWN,
+    KIND_CACHE,
+    KIND_ACTION,
+    KIND_CONDITION
+} Kind;
+
+typedef struct
+{
+    const char *keyword;
+    Kind kind;
+    int min_args;
+    int max_args;
+} KindInfo;
+
+static const KindInfo kinds[] = {
+    {"sequence", KIND_SEQUENCE, 0, 0},
+    {"selector", KIND_SELECTOR, 0, 0},
+    {"parallel", KIND_PARALLEL, 0, 2},
+    {"memory_sequence", KIND_MEMORY_SEQUENCE, 0, 0},
+    {"memory_selector", KIND_MEMORY_SELECTOR, 0, 0},
+    {"invert", KIND_INVERT, 0, 0},
+    {"repeat", KIND_REPEAT, 1, 1},
+    {"repeat_until_success", KIND_REPEAT_UNTIL_SUCCESS, 0, 0},
+    {"conditional", KIND_CONDITIONAL, 0, 0},
+    {"delay", KIND_DELAY, 1, 1},
+    {"delay_ms", KIND_DELAY_MS, 1, 1},
+    {"timeout", KIND_TIMEOUT, 1, 1},
+    {"cooldown", KIND_COOLDOWN, 1, 1},
+    {"cache", KIND_CACHE, 1, 1},
+    {"action", KIND_ACTION, 0, 0},
+    {"condition", KIND_CONDITION, 0, 0},
+};
+
+// 尚未闭合的组合/装饰器节点, 其子节点暂存在 Parser.children 的 [first, top) 中
+typedef struct
+{
+    Kind kind;
+    int line;
+    uint32_t args[PARSER_MAX_ARGS];
+    size_t first;
+} Frame;
+
+typedef struct
+{
+    const char *pos;
+    const char *end;
+    int line;
+    const BtRegistry *registry;
+    BtArena *arena;
+    BtParseError *error;
+    Frame *frames;
+    size_t frame_count;
+    size_t frame_capacity;
+    BehaviorNode **children;
+    size_t child_count;
+    size_t child_capacity;
+} Parser;
+
+typedef struct
+{
+    const char *start;
+    size_t length;
+    int line;
+} Token;
+
+static int fail(Parser *parser, int line, const char *format, ...)
+{
+    if (parser->error)
+    {
+        va_list args;
+        va_start(args, format);
+        parser->error->line = line;
+        vsnprintf(parser->error->message, sizeof(parser->error->message), format, args);
+        va_end(args);
+    }
+    return 0;
+}
+
+// 读取下一个词: '{', '}' 或一串非空白字符; 返回 0 表示输入结束
+static int nextToken(Parser *parser, Token *token)
+{
+    const char *p = parser->pos;
+
+    for (;;)
+    {
+        while (p < parser->end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+        {
+            if (*p == '\n')
+                parser->line++;
+            p++;
+        }
+        if (p < parser->end && *p == '#')
+        {
+            while (p < parser->end && *p != '\n')
+                p++;
+            continue;
+        }
+        break;
+    }
+    if (p == parser->end)
+    {
+        parser->pos = p;
+        return 0;
+    }
+
+    token->start = p;
+    token->line = parser->line;
+    if (*p == '{' || *p == '}')
+        p++;
+    else
+    {
+        while (p < parser->end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n' &&
+               *p != '{' && *p != '}' && *p != '#')
+            p++;
+    }
+    token->length = (size_t)(p - token->start);
+    parser->pos = p;
+    return 1;
+}
+
+static int isSymbol(const Token *token, char symbol)
+{
+    return token->length == 1 && token->start[0] == symbol;
+}
+
+static const KindInfo *findKind(const Token *token)
+{
+    for (size_t i = 0; i < sizeof(kinds) / sizeof(kinds[0]); i++)
+    {
+        if (strlen(kinds[i].keyword) == token->length &&
+            memcmp(kinds[i].keyword, token->start, token->length) == 0)
+            return &kinds[i];
+    }
+    return NULL;
+}
+
+static int parseNumber(const Token *token, uint32_t *value)
+{
+    uint64_t result = 0;
+
+    if (token->length == 0 || token->length > 10)
+        return 0;
+    for (size_t i = 0; i < token->length; i++)
+    {
+        if (token->start[i] < '0' || token->start[i] > '9')
+            return 0;
+        result = result * 10 + (uint64_t)(token->start[i] - '0');
+    }
+    if (result > UINT32_MAX)
+        return 0;
+    *value = (uint32_t)result;
+    return 1;
+}
+
+static int pushChild(Parser *parser, BehaviorNode *node)
+{
+    if (parser->child_count == parser->child_capacity)
+    {
+        size_t capacity = parser->child_capacity ? parser->child_capacity * 2 : 64;
+        BehaviorNode **grown = realloc(parser->children, capacity * sizeof(BehaviorNode *));
+        if (!grown)
+            return 0;
+        parser->children = grown;
+        parser->child_capacity = capacity;
+    }
+    parser->children[parser->child_count++] = node;
+    return 1;
+}
+
+static int pushFrame(Parser *parser, const Frame *frame)
+{
+    if (parser->frame_count == parser->frame_capacity)
+    {
+        size_t capacity = parser->frame_capacity ? parser->frame_capacity * 2 : 32;
+        Frame *grown = realloc(parser->frames, capacity * sizeof(Frame));
+        if (!grown)
+            return 0;
+        parser->frames = grown;
+        parser->frame_capacity = capacity;
+    }
+    parser->frames[parser->frame_count++] = *frame;
+    return 1;
+}
+
+static int parseLeaf(Parser *parser, const KindInfo *info, int line)
+{
+    Token name;
+    char buffer[PARSER_MAX_NAME];
+
+    if (!nextToken(parser, &name) || isSymbol(&name, '{') || isSymbol(&name, '}'))
+        return fail(parser, line, "%s needs a name", info->keyword);
+    if (name.length >= sizeof(buffer))
+        return fail(parser, line, "name is longer than %d characters", PARSER_MAX_NAME - 1);
+    memcpy(buffer, name.start, name.length);
+    buffer[name.length] = '\0';
+
+    const BtAction *action = btRegistryFind(parser->registry, buffer);
+    if (!action)
+        return fail(parser, line, "unknown action '%s'", buffer);
+
+    NodeType type = info->kind == KIND_ACTION ? NODE_TYPE_ACTION : NODE_TYPE_CONDITION;
+    BehaviorNode *node;
+    if (action->ctx_action)
+        node = btArenaCreateContextNode(parser->arena, type, action->ctx_action);
+    else if (action->async)
+        node = btArenaCreateAsyncNode(parser->arena, type, action->async);
+    else
+        node = btArenaCreateBehaviorNode(parser->arena, NULL, 0, type, action->action);
+    if (!node)
+        return fail(parser, line, "invalid %s node", info->keyword);
+    node->halt = action->halt;
+    if (!pushChild(parser, node))
+        return fail(parser, line, "out of memory");
+    return 1;
+}
+
+// 读取参数直到 '{'
+static int parseOpen(Parser *parser, const KindInfo *info, int line)
+{
+    Frame frame = {info->kind, line, {0, 0}, parser->child_count};
+    Token token;
+    int argc = 0;
+
+    for (;;)
+    {
+        if (!nextToken(parser, &token))
+            return fail(parser, line, "expected '{' after %s", info->keyword);
+        if (isSymbol(&token, '{'))
+            break;
+        if (argc == info->max_args || !parseNumber(&token, &frame.args[argc]))
+            return fail(parser, token.line, "unexpected '%.*s' in %s", (int)token.length, token.start, info->keyword);
+        argc++;
+    }
+    if (argc < info->min_args)
+        return fail(parser, line, "%s needs %d argument(s)", info->keyword, info->min_args);
+    if (!pushFrame(parser, &frame))
+        return fail(parser, line, "out of memory");
+    return 1;
+}
+
+static Decorator *createFrameDecorator(Parser *parser, const Frame *frame)
+{
+    uint32_t param = frame->args[0];
+    Decorator *decorator;
+
+    switch (frame->kind)
+    {
+    case KIND_INVERT:
+        return btArenaCreateDecorator(parser->arena, DECORATOR_TYPE_INVERT, NULL);
+    case KIND_REPEAT:
+        return btArenaCreateDecorator(parser->arena, DECORATOR_TYPE_REPEAT, &param);
+    case KIND_REPEAT_UNTIL_SUCCESS:
+        return btArenaCreateDecorator(parser->arena, DECORATOR_TYPE_REPEAT_UNTIL_SUCCESS, &param);
+    case KIND_CONDITIONAL:
+        return btArenaCreateDecorator(parser->arena, DECORATOR_TYPE_CONDITIONAL, NULL);
+    case KIND_DELAY:
+        return btArenaCreateDecorator(parser->arena, DECORATOR_TYPE_DELAY, &param);
+    case KIND_DELAY_MS:
+        decorator = btArenaCreateDecorator(parser->arena, DECORATOR_TYPE_DELAY, &param);
+        if (decorator)
+            decorator->flags |= DECORATOR_FLAG_MILLISECONDS;
+        return decorator;
+    case KIND_TIMEOUT:
+        return btArenaCreateDecorator(parser->arena, DECORATOR_TYPE_TIMEOUT, &param);
+    case KIND_COOLDOWN:
+        return btArenaCreateDecorator(parser->arena, DECORATOR_TYPE_COOLDOWN, &param);
+    default:
+        return btArenaCreateDecorator(parser->arena, DECORATOR_TYPE_CACHE, &param);
+    }
+}
+
+// '}': 用暂存的子节点创建节点, 校验交给 BehaviorNodeCheck
+static int parseClose(Parser *parser, int line)
+{
+    if (parser->frame_count == 0)
+        return fail(parser, line, "unmatched '}'");
+
+    Frame frame = parser->frames[--parser->frame_count];
+    BehaviorNode **children = parser->children + frame.first;
+    int count = (int)(parser->child_count - frame.first);
+    BehaviorNode *node;
+
+    if (frame.kind <= KIND_MEMORY_SELECTOR)
+    {
+        static const NodeType types[] = {NODE_TYPE_SEQUENCE, NODE_TYPE_SELECTOR, NODE_TYPE_PARALLEL,
+                                         NODE_TYPE_MEMORY, NODE_TYPE_MEMORY};
+        node = btArenaCreateBehaviorNode(parser->arena, children, count, types[frame.kind], NULL);
+        if (node && frame.kind == KIND_PARALLEL)
+        {
+            node->params.parallel.success_threshold = frame.args[0];
+            node->params.parallel.failure_threshold = frame.args[1];
+        }
+        if (node && frame.kind == KIND_MEMORY_SELECTOR)
+            node->params.memory.kind = MEMORY_SELECTOR;
+    }
+    else
+    {
+        if (frame.kind != KIND_CONDITIONAL && count > 1)
+            return fail(parser, frame.line, "decorator takes one child, got %d", count);
+        node = btArenaCreateBehaviorNode(parser->arena, children, count, NODE_TYPE_DECORATOR, NULL);
+        if (node)
+        {
+            node->decorator = createFrameDecorator(parser, &frame);
+            if (!node->decorator)
+                return fail(parser, frame.line, "out of memory");
+        }
+    }
+    if (!node)
+        return fail(parser, frame.line, "invalid %s node with %d children", kinds[frame.kind].keyword, count);
+
+    parser->child_count = frame.first;
+    return pushChild(parser, node) ? 1 : fail(parser, line, "out of memory");
+}
+
+/**
+ * @brief Builds a tree from a text definition in a single pass.
+ *
+ * Nodes are created in the arena as soon as their closing brace is read, so
+ * no intermediate document is kept; only the children of the currently open
+ * nodes are buffered. Every node goes through the same validation as
+ * createBehaviorNode.
+ *
+ * @param text     Definition, need not be NUL-terminated.
+ * @param registry Names of the actions and conditions used by the tree.
+ * @param arena    Arena that receives the nodes. On failure it may contain
+ *                 unused nodes; reset or destroy it to reclaim them.
+ * @param error    Filled with the line and reason on failure, may be NULL.
+ * @return BehaviorNode* The root node, or NULL on error.
+ */
+BehaviorNode *btParseTree(const char *text, size_t length, const BtRegistry *registry,
+                          BtArena *arena, BtParseError *error)
+{
+    Parser parser = {0};
+    Token token;
+    int ok = 1;
+
+    parser.pos = text;
+    parser.end = text + length;
+    parser.line = 1;
+    parser.registry = registry;
+    parser.arena = arena;
+    parser.error = error;
+
+    while (ok && nextToken(&parser, &token))
+    {
+        const KindInfo *info;
+
+        if (isSymbol(&token, '}'))
+        {
+            ok = parseClose(&parser, token.line);
+            continue;
+        }
+        if (parser.frame_count == 0 && parser.child_count > 0)
+        {
+            ok = fail(&parser, token.line, "only one root node is allowed");
+            break;
+        }
+
+        info = findKind(&token);
+        if (!info)
+            ok = fail(&parser, token.line, "unknown node type '%.*s'", (int)token.length, token.start);
+        else if (info->kind == KIND_ACTION || info->kind == KIND_CONDITION)
+            ok = parseLeaf(&parser, info, token.line);
+        else
+            ok = parseOpen(&parser, info, token.line);
+    }
+
+    if (ok && parser.frame_count > 0)
+        ok = fail(&parser, parser.frames[parser.frame_count - 1].line, "missing '}'");
+    if (ok && parser.child_count == 0)
+        ok = fail(&parser, parser.line, "empty tree");
+
+    BehaviorNode *root = ok ? parser.children[0] : NULL;
+    free(parser.frames);
+    free(parser.children);
+    return root;
+}
+
+/**
+ * @brief Reads a file and parses it with btParseTree.
+ */
+BehaviorNode *btParseTreeFile(const char *path, const BtRegistry *registry,
+                              BtArena *arena, BtParseError *error)
+{
+    FILE *file = fopen(path, "rb");
+    char *text = NULL;
+    long size;
+
+    if (!file)
+    {
+        if (error)
+        {
+            error->line = 0;
+            snprintf(error->message, sizeof(error->message), "cannot open %s", path);
+        }
+        return NULL;
+    }
+    if (fseek(file, 0, SEEK_END) == 0 && (size = ftell(file)) >= 0 &&
+        fseek(file, 0, SEEK_SET) == 0 && (text = malloc((size_t)size + 1)) != NULL &&
+        fread(text, 1, (size_t)size, file) == (size_t)size)
+    {
+        fclose(file);
+        BehaviorNode *root = btParseTree(text, (size_t)size, registry, arena, error);
+        free(text);
+        return root;
+    }
+
+    fclose(file);
+    free(text);
+    if (error)
+    {
+        error->line = 0;
+        snprintf(error->message, sizeof(error->message), "cannot read %s", path);
+    }
+    return NULL;
+}
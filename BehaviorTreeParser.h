@@ -0,0 +1,43 @@
+#ifndef BEHAVIOR_TREE_PARSER_H
+#define BEHAVIOR_TREE_PARSER_H
+
+#include <stddef.h>
+#include "BehaviorTree.h"
+#include "BehaviorTreeArena.h"
+#include "BehaviorTreeRegistry.h"
+
+/*
+ * Text tree definitions. One node per keyword, children in braces, '#'
+ * starts a comment that runs to the end of the line:
+ *
+ *     sequence {
+ *         condition isHungry
+ *         selector {
+ *             action eat
+ *             delay_ms 500 { action wait }
+ *         }
+ *     }
+ *
+ * Leaves:      action <name>, condition <name>
+ * Composites:  sequence, selector, parallel [success [failure]],
+ *              memory_sequence, memory_selector
+ * Decorators:  invert, repeat <n>, repeat_until_success, conditional,
+ *              delay <s>, delay_ms <ms>, timeout <ms>, cooldown <ms>,
+ *              cache <ttl ms> (0: only within one tick)
+ *
+ * Names are resolved through a BtRegistry. Only conditional takes up to
+ * three children (condition, then, else); the other decorators take one.
+ */
+
+typedef struct BtParseError
+{
+    int line;          // 出错的行号, 从 1 开始
+    char message[96];
+} BtParseError;
+
+BehaviorNode *btParseTree(const char *text, size_t length, const BtRegistry *registry,
+                          BtArena *arena, BtParseError *error);
+BehaviorNode *btParseTreeFile(const char *path, const BtRegistry *registry,
+                              BtArena *arena, BtParseError *error);
+
+#endif // BEHAVIOR_TREE_PARSER_H
@@ -0,0 +1,340 @@
+#include "BehaviorTreeProfile.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef BT_ENABLE_PROFILING
+
+#include <stdatomic.h>
+#include <time.h>
+
+#define PROFILE_INITIAL_CAPACITY 256u
+
+/*
+ * 每个线程一张以节点指针为键的开放寻址表, 并行执行器的线程互不阻塞.
+ * 表的锁只在读取 (btProfileGet, btProfileTopN) 和清空时才有竞争.
+ */
+typedef struct ProfileTable
+{
+    atomic_flag lock;
+    BtNodeProfile *slots;
+    uint32_t capacity;
+    uint32_t count;
+    struct ProfileTable *next;
+} ProfileTable;
+
+// 表在进程内一直保留, 线程退出后其统计仍会被合并
+static _Atomic(ProfileTable *) tables;
+static _Thread_local ProfileTable *localTable;
+
+static BtProfileBeforeHook beforeHook;
+static BtProfileAfterHook afterHook;
+static void *hookUser;
+
+static inline uint64_t nowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static inline void lockTable(ProfileTable *table)
+{
+    while (atomic_flag_test_and_set_explicit(&table->lock, memory_order_acquire))
+        ;
+}
+
+static inline void unlockTable(ProfileTable *table)
+{
+    atomic_flag_clear_explicit(&table->lock, memory_order_release);
+}
+
+static ProfileTable *createTable(void)
+{
+    ProfileTable *table = calloc(1, sizeof(ProfileTable));
+    if (!table)
+        return NULL;
+    atomic_flag_clear(&table->lock);
+
+    ProfileTable *first = atomic_load_explicit(&tables, memory_order_relaxed);
+    do
+    {
+        table->next = first;
+    } while (!atomic_compare_exchange_weak_explicit(&tables, &first, table, memory_order_release, memory_order_relaxed));
+    return table;
+}
+
+static inline uint32_t hashNode(const BehaviorNode *node)
+{
+    uint64_t key = (uint64_t)(uintptr_t)node;
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return (uint32_t)key;
+}
+
+static BtNodeProfile *findSlot(BtNodeProfile *slots, uint32_t capacity, const BehaviorNode *node)
+{
+    uint32_t mask = capacity - 1;
+    uint32_t i = hashNode(node) & mask;
+
+    while (slots[i].node && slots[i].node != node)
+        i = (i + 1) & mask;
+    return &slots[i];
+}
+
+static int grow(ProfileTable *table)
+{
+    uint32_t capacity = table->capacity ? table->capacity * 2 : PROFILE_INITIAL_CAPACITY;
+    BtNodeProfile *slots = calloc(capacity, sizeof(BtNodeProfile));
+    if (!slots)
+        return 0;
+
+    for (uint32_t i = 0; i < table->capacity; i++)
+    {
+        if (table->slots[i].node)
+            *findSlot(slots, capacity, table->slots[i].node) = table->slots[i];
+    }
+    free(table->slots);
+    table->slots = slots;
+    table->capacity = capacity;
+    return 1;
+}
+
+// 调用者持有 table 的锁 (或 table 只属于自己)
+static BtNodeProfile *lookup(ProfileTable *table, const BehaviorNode *node, int create)
+{
+    if (table->capacity == 0)
+    {
+        if (!create || !grow(table))
+            return NULL;
+    }
+
+    BtNodeProfile *slot = findSlot(table->slots, table->capacity, node);
+    if (slot->node || !create)
+        return slot->node ? slot : NULL;
+
+    if ((table->count + 1) * 4 > table->capacity * 3) // 负载因子 0.75
+    {
+        if (!grow(table))
+            return NULL;
+        slot = findSlot(table->slots, table->capacity, node);
+    }
+    slot->node = node;
+    table->count++;
+    return slot;
+}
+
+// 把一个线程的统计加到 into 上
+static void mergeProfile(BtNodeProfile *into, const BtNodeProfile *from)
+{
+    into->ticks += from->ticks;
+    into->successes += from->successes;
+    into->failures += from->failures;
+    into->running += from->running;
+    into->total_ns += from->total_ns;
+    if (from->max_ns > into->max_ns)
+        into->max_ns = from->max_ns;
+}
+
+uint64_t btProfileBegin(const BehaviorNode *node)
+{
+    if (beforeHook)
+        beforeHook(node, hookUser);
+    return nowNs();
+}
+
+void btProfileEnd(const BehaviorNode *node, NodeStatus status, uint64_t start_ns)
+{
+    uint64_t elapsed = nowNs() - start_ns;
+    ProfileTable *table = localTable;
+
+    if (!table)
+        table = localTable = createTable();
+    if (table)
+    {
+        lockTable(table);
+        BtNodeProfile *profile = lookup(table, node, 1);
+        if (profile)
+        {
+            profile->ticks++;
+            if (status == BT_SUCCESS)
+                profile->successes++;
+            else if (status == BT_RUNNING)
+                profile->running++;
+            else
+                profile->failures++;
+            profile->total_ns += elapsed;
+            if (elapsed > profile->max_ns)
+                profile->max_ns = elapsed;
+        }
+        unlockTable(table);
+    }
+
+    if (afterHook)
+        afterHook(node, status, elapsed, hookUser);
+}
+
+/**
+ * @brief Installs hooks called around every node execution.
+ *
+ * The after hook receives the node's result and its inclusive time. Either
+ * hook may be NULL. Hooks run on the executor threads when parallel nodes
+ * are executed concurrently.
+ */
+void btProfileSetHooks(BtProfileBeforeHook before, BtProfileAfterHook after, void *user)
+{
+    beforeHook = before;
+    afterHook = after;
+    hookUser = user;
+}
+
+/**
+ * @brief Clears all counters.
+ *
+ * Must be called before freeing profiled nodes if their addresses may be
+ * reused by new nodes.
+ */
+void btProfileReset(void)
+{
+    for (ProfileTable *table = atomic_load_explicit(&tables, memory_order_acquire); table; table = table->next)
+    {
+        lockTable(table);
+        free(table->slots);
+        table->slots = NULL;
+        table->capacity = 0;
+        table->count = 0;
+        unlockTable(table);
+    }
+}
+
+/**
+ * @brief Copies the counters of one node, summed over all threads.
+ *
+ * @return int 1 if the node has been executed since the last reset, 0 otherwise.
+ */
+int btProfileGet(const BehaviorNode *node, BtNodeProfile *out)
+{
+    int found = 0;
+
+    memset(out, 0, sizeof(*out));
+    out->node = node;
+    for (ProfileTable *table = atomic_load_explicit(&tables, memory_order_acquire); table; table = table->next)
+    {
+        lockTable(table);
+        BtNodeProfile *profile = lookup(table, node, 0);
+        if (profile)
+        {
+            mergeProfile(out, profile);
+            found = 1;
+        }
+        unlockTable(table);
+    }
+    return found;
+}
+
+static int compareTotal(const void *a, const void *b)
+{
+    uint64_t x = ((const BtNodeProfile *)a)->total_ns;
+    uint64_t y = ((const BtNodeProfile *)b)->total_ns;
+    return x < y ? 1 : x > y ? -1 : 0;
+}
+
+/**
+ * @brief Copies the n nodes with the highest cumulative time.
+ *
+ * The counters of all threads are merged first.
+ *
+ * @param out Array of at least n entries, filled in descending order.
+ * @return int Number of entries written, 0 if memory runs out.
+ */
+int btProfileTopN(BtNodeProfile *out, int n)
+{
+    ProfileTable merged = {ATOMIC_FLAG_INIT, NULL, 0, 0, NULL}; // 只属于本次调用, 不用加锁
+    int count = 0, ok = 1;
+
+    for (ProfileTable *table = atomic_load_explicit(&tables, memory_order_acquire); table && ok; table = table->next)
+    {
+        lockTable(table);
+        for (uint32_t i = 0; i < table->capacity && ok; i++)
+        {
+            if (!table->slots[i].node)
+                continue;
+            BtNodeProfile *into = lookup(&merged, table->slots[i].node, 1);
+            if (into)
+                mergeProfile(into, &table->slots[i]);
+            else
+                ok = 0;
+        }
+        unlockTable(table);
+    }
+
+    // 合并表的槽数组原地压紧后排序
+    for (uint32_t i = 0; ok && i < merged.capacity; i++)
+    {
+        if (merged.slots[i].node)
+            merged.slots[count++] = merged.slots[i];
+    }
+    if (ok && count > 0)
+    {
+        qsort(merged.slots, (size_t)count, sizeof(BtNodeProfile), compareTotal);
+        if (count > n)
+            count = n;
+        memcpy(out, merged.slots, sizeof(BtNodeProfile) * (size_t)count);
+    }
+    free(merged.slots);
+    return ok ? count : 0;
+}
+
+#else // !BT_ENABLE_PROFILING
+
+void btProfileSetHooks(BtProfileBeforeHook before, BtProfileAfterHook after, void *user)
+{
+    (void)before;
+    (void)after;
+    (void)user;
+}
+
+void btProfileReset(void)
+{
+}
+
+int btProfileGet(const BehaviorNode *node, BtNodeProfile *out)
+{
+    (void)node;
+    (void)out;
+    return 0;
+}
+
+int btProfileTopN(BtNodeProfile *out, int n)
+{
+    (void)out;
+    (void)n;
+    return 0;
+}
+
+#endif // BT_ENABLE_PROFILING
+
+/**
+ * @brief Prints the n hottest nodes as a table.
+ */
+void btProfileDump(FILE *out, int n)
+{
+    BtNodeProfile *top = n > 0 ? malloc(sizeof(BtNodeProfile) * (size_t)n) : NULL;
+    int count = top ? btProfileTopN(top, n) : 0;
+
+    fprintf(out, "%-18s %4s %10s %10s %10s %10s %12s %10s %10s\n",
+            "node", "type", "ticks", "success", "failure", "running", "total us", "avg ns", "max ns");
+    for (int i = 0; i < count; i++)
+    {
+        const BtNodeProfile *p = &top[i];
+        fprintf(out, "%-18p %4d %10llu %10llu %10llu %10llu %12.1f %10llu %10llu\n",
+                (const void *)p->node, (int)p->node->type,
+                (unsigned long long)p->ticks, (unsigned long long)p->successes,
+                (unsigned long long)p->failures, (unsigned long long)p->running,
+                p->total_ns / 1000.0, (unsigned long long)(p->total_ns / p->ticks),
+                (unsigned long long)p->max_ns);
+    }
+    if (count == 0)
+        fprintf(out, "(no profile data, build with BT_ENABLE_PROFILING)\n");
+    free(top);
+}
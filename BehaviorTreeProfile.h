@@ -0,0 +1,43 @@
+#ifndef BEHAVIOR_TREE_PROFILE_H
+#define BEHAVIOR_TREE_PROFILE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "BehaviorTree.h"
+
+/*
+ * Per-node profiling of executeNode and tickTree.
+ *
+ * Only compiled in when BT_ENABLE_PROFILING is defined (cmake
+ * -DBT_ENABLE_PROFILING=ON). Without it the functions below are empty stubs
+ * and the engines contain no instrumentation at all.
+ */
+
+// 一个节点的统计, 存在以节点指针为键的旁路表中
+typedef struct
+{
+    const BehaviorNode *node;
+    uint64_t ticks;
+    uint64_t successes;
+    uint64_t failures;
+    uint64_t running;
+    uint64_t total_ns; // 包含子节点的耗时
+    uint64_t max_ns;
+} BtNodeProfile;
+
+typedef void (*BtProfileBeforeHook)(const BehaviorNode *node, void *user);
+typedef void (*BtProfileAfterHook)(const BehaviorNode *node, NodeStatus status, uint64_t elapsed_ns, void *user);
+
+void btProfileSetHooks(BtProfileBeforeHook before, BtProfileAfterHook after, void *user);
+void btProfileReset(void);
+int btProfileGet(const BehaviorNode *node, BtNodeProfile *out);
+int btProfileTopN(BtNodeProfile *out, int n);
+void btProfileDump(FILE *out, int n);
+
+#ifdef BT_ENABLE_PROFILING
+// 引擎内部使用
+uint64_t btProfileBegin(const BehaviorNode *node);
+void btProfileEnd(const BehaviorNode *node, NodeStatus status, uint64_t start_ns);
+#endif
+
+#endif // BEHAVIOR_TREE_PROFILE_H
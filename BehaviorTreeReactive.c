@@ -0,0 +1,272 @@
+#include "BehaviorTreeReactive.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct
+{
+    int (*condition)(BtContext *ctx);
+    BbKey key;
+} Declaration;
+
+struct BtReactiveTree
+{
+    const BtFlatTree *tree;
+    uint32_t *parent;   // 根节点为 UINT32_MAX
+    uint8_t *cacheable; // 子树只依赖声明过的键
+    Declaration *declarations;
+    uint32_t declaration_count;
+    uint32_t declaration_capacity;
+    // 键 -> 依赖节点, CSR 格式: key_nodes[key_start[k] .. key_start[k + 1])
+    uint32_t key_count;
+    uint32_t *key_start;
+    uint32_t *key_nodes;
+    int finalized;
+};
+
+/**
+ * @brief Creates the reactive dependency table for a compiled tree.
+ *
+ * @return BtReactiveTree* The table, or NULL if memory could not be allocated.
+ */
+BtReactiveTree *btReactiveCreate(const BtFlatTree *tree)
+{
+    BtReactiveTree *reactive = calloc(1, sizeof(BtReactiveTree));
+    if (!reactive)
+        return NULL;
+    reactive->tree = tree;
+    reactive->parent = malloc(sizeof(uint32_t) * tree->node_count);
+    reactive->cacheable = calloc(tree->node_count, 1);
+    if (!reactive->parent || !reactive->cacheable)
+    {
+        btReactiveDestroy(reactive);
+        return NULL;
+    }
+
+    // 先序布局: 子节点 c 的父节点是包含它的最近的前驱
+    for (uint32_t i = 0; i < tree->node_count; i++)
+        reactive->parent[i] = UINT32_MAX;
+    for (uint32_t i = 0; i < tree->node_count; i++)
+    {
+        for (uint32_t child = i + 1; child < tree->subtree_end[i]; child = tree->subtree_end[child])
+            reactive->parent[child] = i;
+    }
+    return reactive;
+}
+
+void btReactiveDestroy(BtReactiveTree *reactive)
+{
+    if (!reactive)
+        return;
+    free(reactive->parent);
+    free(reactive->cacheable);
+    free(reactive->declarations);
+    free(reactive->key_start);
+    free(reactive->key_nodes);
+    free(reactive);
+}
+
+/**
+ * @brief Declares that a context condition reads a blackboard key.
+ *
+ * Call once per key the condition reads, before the first btReactiveAttach.
+ * A condition without declarations is never cached.
+ *
+ * @return int 1 on success, 0 if declarations are closed or memory ran out.
+ */
+int btReactiveDeclare(BtReactiveTree *reactive, int (*condition)(BtContext *ctx), BbKey key)
+{
+    if (reactive->finalized || key == BB_INVALID_KEY)
+        return 0;
+    if (reactive->declaration_count == reactive->declaration_capacity)
+    {
+        uint32_t capacity = reactive->declaration_capacity ? reactive->declaration_capacity * 2 : 16;
+        Declaration *declarations = realloc(reactive->declarations, capacity * sizeof(Declaration));
+        if (!declarations)
+            return 0;
+        reactive->declarations = declarations;
+        reactive->declaration_capacity = capacity;
+    }
+    reactive->declarations[reactive->declaration_count++] = (Declaration){condition, key};
+    return 1;
+}
+
+static int declaredCondition(const BtReactiveTree *reactive, uint32_t index)
+{
+    const BtFlatTree *tree = reactive->tree;
+    if (tree->kind[index] != NODE_TYPE_CONDITION)
+        return 0;
+    int (*condition)(BtContext *) = tree->actions[tree->action[index]].ctx_action;
+    for (uint32_t i = 0; condition && i < reactive->declaration_count; i++)
+    {
+        if (reactive->declarations[i].condition == condition)
+            return 1;
+    }
+    return 0;
+}
+
+static int pureComposite(const BtFlatTree *tree, uint32_t index)
+{
+    switch (tree->kind[index])
+    {
+    case NODE_TYPE_SEQUENCE:
+    case NODE_TYPE_SELECTOR:
+    case NODE_TYPE_PARALLEL:
+        return 1;
+    case NODE_TYPE_DECORATOR:
+        // 延时和重试依赖时间或 tick 次数, 不能缓存
+        return tree->dec_type[index] == DECORATOR_TYPE_INVERT ||
+               tree->dec_type[index] == DECORATOR_TYPE_REPEAT ||
+               tree->dec_type[index] == DECORATOR_TYPE_CONDITIONAL;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * @brief Computes the cacheable subtrees and the key -> node index.
+ */
+static int finalize(BtReactiveTree *reactive)
+{
+    const BtFlatTree *tree = reactive->tree;
+    uint32_t keyCount = 0, pairCount = 0;
+
+    // 逆先序: 子节点总在父节点之前处理
+    for (uint32_t i = tree->node_count; i-- > 0;)
+    {
+        if (tree->kind[i] == NODE_TYPE_CONDITION)
+        {
+            reactive->cacheable[i] = (uint8_t)declaredCondition(reactive, i);
+            continue;
+        }
+        int cacheable = pureComposite(tree, i) && tree->subtree_end[i] > i + 1;
+        for (uint32_t child = i + 1; cacheable && child < tree->subtree_end[i]; child = tree->subtree_end[child])
+            cacheable = reactive->cacheable[child];
+        reactive->cacheable[i] = (uint8_t)cacheable;
+    }
+
+    for (uint32_t d = 0; d < reactive->declaration_count; d++)
+    {
+        if (reactive->declarations[d].key + 1 > keyCount)
+            keyCount = reactive->declarations[d].key + 1;
+    }
+    reactive->key_count = keyCount;
+    reactive->key_start = calloc((size_t)keyCount + 1, sizeof(uint32_t));
+    if (!reactive->key_start)
+        return 0;
+
+    // 两遍: 先计数再填充
+    for (int pass = 0; pass < 2; pass++)
+    {
+        uint32_t *fill = NULL;
+        if (pass == 1)
+        {
+            for (uint32_t k = 0; k < keyCount; k++)
+                reactive->key_start[k + 1] += reactive->key_start[k];
+            pairCount = reactive->key_start[keyCount];
+            reactive->key_nodes = malloc(sizeof(uint32_t) * (pairCount ? pairCount : 1));
+            fill = calloc(keyCount ? keyCount : 1, sizeof(uint32_t));
+            if (!reactive->key_nodes || !fill)
+            {
+                free(fill);
+                return 0;
+            }
+        }
+        for (uint32_t i = 0; i < tree->node_count; i++)
+        {
+            if (tree->kind[i] != NODE_TYPE_CONDITION)
+                continue;
+            int (*condition)(BtContext *) = tree->actions[tree->action[i]].ctx_action;
+            for (uint32_t d = 0; condition && d < reactive->declaration_count; d++)
+            {
+                if (reactive->declarations[d].condition != condition)
+                    continue;
+                BbKey key = reactive->declarations[d].key;
+                if (pass == 0)
+                    reactive->key_start[key + 1]++;
+                else
+                    reactive->key_nodes[reactive->key_start[key] + fill[key]++] = i;
+            }
+        }
+        free(fill);
+    }
+
+    reactive->finalized = 1;
+    return 1;
+}
+
+int btReactiveCacheable(const BtReactiveTree *reactive, uint32_t index)
+{
+    return reactive->cacheable[index];
+}
+
+/**
+ * @brief Marks every node that depends on key, and all their ancestors, dirty.
+ *
+ * Called automatically for writes to the instance's blackboard; call it
+ * directly after changing a value behind the blackboard's back.
+ */
+void btReactiveInvalidate(BtInstance *instance, BbKey key)
+{
+    BtReactiveState *state = instance->reactive;
+    const BtReactiveTree *reactive;
+
+    if (!state)
+        return;
+    reactive = state->tree;
+    if (key >= reactive->key_count)
+        return;
+
+    for (uint32_t n = reactive->key_start[key]; n < reactive->key_start[key + 1]; n++)
+    {
+        // 短路求值可能留下有效的祖先和无效的子孙, 所以总是走到根
+        for (uint32_t node = reactive->key_nodes[n]; node != UINT32_MAX; node = reactive->parent[node])
+            state->flags[node] &= (uint8_t)~BT_REACTIVE_VALID;
+    }
+}
+
+static void onBlackboardChange(void *user, BbKey key)
+{
+    btReactiveInvalidate((BtInstance *)user, key);
+}
+
+/**
+ * @brief Switches an instance to reactive ticking.
+ *
+ * The first attach closes the declarations. The instance's blackboard must
+ * already be set in instance->context; its listener is taken over.
+ *
+ * @return int 1 on success, 0 if memory could not be allocated.
+ */
+int btReactiveAttach(BtReactiveTree *reactive, BtInstance *instance)
+{
+    if (!reactive->finalized && !finalize(reactive))
+        return 0;
+
+    BtReactiveState *state = malloc(sizeof(BtReactiveState) + reactive->tree->node_count);
+    if (!state)
+        return 0;
+    state->tree = reactive;
+    state->flags = (uint8_t *)(state + 1);
+    state->hits = 0;
+    state->evaluations = 0;
+    memset(state->flags, 0, reactive->tree->node_count);
+
+    btReactiveDetach(instance);
+    instance->reactive = state;
+    if (instance->context.blackboard)
+        bbSetListener(instance->context.blackboard, onBlackboardChange, instance);
+    return 1;
+}
+
+/**
+ * @brief Returns an instance to normal ticking and frees its reactive state.
+ */
+void btReactiveDetach(BtInstance *instance)
+{
+    if (!instance->reactive)
+        return;
+    if (instance->context.blackboard)
+        bbSetListener(instance->context.blackboard, NULL, NULL);
+    free(instance->reactive);
+    instance->reactive = NULL;
+}
@@ -0,0 +1,58 @@
+#ifndef BEHAVIOR_TREE_REACTIVE_H
+#define BEHAVIOR_TREE_REACTIVE_H
+
+#include "BehaviorTreeFlat.h"
+#include "Blackboard.h"
+
+/**
+ * @brief Event-driven re-evaluation for instances of a compiled tree.
+ *
+ * Context conditions declare the blackboard keys they read. A subtree made
+ * only of such conditions (and of composites/decorators without time or
+ * retry state) is a pure function of those keys, so its last result is
+ * reused until a write to one of the keys marks it and its ancestors dirty.
+ * Actions and stateful decorators are evaluated on every tick as usual.
+ */
+typedef struct BtReactiveTree BtReactiveTree;
+
+// 每个 agent 一个, 每个节点 1 字节
+typedef struct BtReactiveState
+{
+    const BtReactiveTree *tree;
+    uint8_t *flags;
+    uint64_t hits;        // 复用缓存结果的次数
+    uint64_t evaluations; // 重新计算可缓存节点的次数
+} BtReactiveState;
+
+#define BT_REACTIVE_VALID 0x01u   // 缓存有效
+#define BT_REACTIVE_SUCCESS 0x02u // 缓存的结果
+
+BtReactiveTree *btReactiveCreate(const BtFlatTree *tree);
+void btReactiveDestroy(BtReactiveTree *reactive);
+int btReactiveDeclare(BtReactiveTree *reactive, int (*condition)(BtContext *ctx), BbKey key);
+int btReactiveAttach(BtReactiveTree *reactive, BtInstance *instance);
+void btReactiveDetach(BtInstance *instance);
+void btReactiveInvalidate(BtInstance *instance, BbKey key);
+
+// 供 tickFlat 使用
+int btReactiveCacheable(const BtReactiveTree *reactive, uint32_t index);
+
+static inline int btReactiveLookup(BtReactiveState *state, uint32_t index, NodeStatus *status)
+{
+    uint8_t flags = state->flags[index];
+    if (!(flags & BT_REACTIVE_VALID))
+        return 0;
+    state->hits++;
+    *status = (flags & BT_REACTIVE_SUCCESS) ? BT_SUCCESS : BT_FAILURE;
+    return 1;
+}
+
+static inline void btReactiveStore(BtReactiveState *state, uint32_t index, NodeStatus status)
+{
+    if (status == BT_RUNNING || !btReactiveCacheable(state->tree, index))
+        return;
+    state->evaluations++;
+    state->flags[index] = (uint8_t)(BT_REACTIVE_VALID | (status == BT_SUCCESS ? BT_REACTIVE_SUCCESS : 0));
+}
+
+#endif // BEHAVIOR_TREE_REACTIVE_H
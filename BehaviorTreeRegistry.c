@@ -0,0 +1,189 @@
+#include "BehaviorTreeRegistry.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct
+{
+    char *name;
+    BtAction action;
+} RegistryEntry;
+
+struct BtRegistry
+{
+    RegistryEntry *entries;
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t *index;          // 名字哈希 -> entries 下标 + 1, 0 表示空
+    uint32_t index_capacity;  // 2 的幂
+};
+
+static uint32_t hashName(const char *name)
+{
+    uint32_t hash = 2166136261u; // FNV-1a
+    while (*name)
+    {
+        hash ^= (uint8_t)*name++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+BtRegistry *btRegistryCreate(void)
+{
+    return calloc(1, sizeof(BtRegistry));
+}
+
+void btRegistryDestroy(BtRegistry *registry)
+{
+    if (!registry)
+        return;
+    for (uint32_t i = 0; i < registry->count; i++)
+        free(registry->entries[i].name);
+    free(registry->entries);
+    free(registry->index);
+    free(registry);
+}
+
+static int rebuildIndex(BtRegistry *registry, uint32_t capacity)
+{
+    uint32_t *index = calloc(capacity, sizeof(uint32_t));
+    if (!index)
+        return 0;
+    for (uint32_t i = 0; i < registry->count; i++)
+    {
+        uint32_t slot = hashName(registry->entries[i].name) & (capacity - 1);
+        while (index[slot])
+            slot = (slot + 1) & (capacity - 1);
+        index[slot] = i + 1;
+    }
+    free(registry->index);
+    registry->index = index;
+    registry->index_capacity = capacity;
+    return 1;
+}
+
+static int addEntry(BtRegistry *registry, const char *name, BtAction action)
+{
+    if (!registry || !name || btRegistryFind(registry, name))
+        return 0; // 名字重复
+
+    if (registry->count == registry->capacity)
+    {
+        uint32_t capacity = registry->capacity ? registry->capacity * 2 : 16;
+        RegistryEntry *grown = realloc(registry->entries, capacity * sizeof(RegistryEntry));
+        if (!grown)
+            return 0;
+        registry->entries = grown;
+        registry->capacity = capacity;
+    }
+
+    char *copy = malloc(strlen(name) + 1);
+    if (!copy)
+        return 0;
+    strcpy(copy, name);
+    registry->entries[registry->count++] = (RegistryEntry){copy, action};
+
+    if (registry->count * 2 > registry->index_capacity)
+    {
+        // 重建时已包含新条目
+        if (rebuildIndex(registry, registry->index_capacity ? registry->index_capacity * 2 : 32))
+            return 1;
+        free(registry->entries[--registry->count].name);
+        return 0;
+    }
+
+    uint32_t mask = registry->index_capacity - 1;
+    uint32_t slot = hashName(name) & mask;
+    while (registry->index[slot])
+        slot = (slot + 1) & mask;
+    registry->index[slot] = registry->count;
+    return 1;
+}
+
+/**
+ * @brief Registers a plain action under a name.
+ *
+ * @return int 1 on success, 0 if the name is already taken or memory ran out.
+ */
+int btRegistryAdd(BtRegistry *registry, const char *name, int (*action)(void))
+{
+    return addEntry(registry, name, (BtAction){.action = action});
+}
+
+/**
+ * @brief Registers a context action under a name.
+ *
+ * @return int 1 on success, 0 if the name is already taken or memory ran out.
+ */
+int btRegistryAddContext(BtRegistry *registry, const char *name, int (*ctx_action)(BtContext *ctx))
+{
+    return addEntry(registry, name, (BtAction){.ctx_action = ctx_action});
+}
+
+/**
+ * @brief Registers an async action under a name. The action must outlive the registry's trees.
+ *
+ * @return int 1 on success, 0 if the name is already taken or memory ran out.
+ */
+int btRegistryAddAsync(BtRegistry *registry, const char *name, const BtAsyncAction *async)
+{
+    return addEntry(registry, name, (BtAction){.async = async});
+}
+
+/**
+ * @brief Sets the halt callback of a registered action.
+ *
+ * Leaves created from the entry afterwards (parser, binary loader) call it
+ * when they are halted while running, see haltTree.
+ *
+ * @return int 1 on success, 0 if the name is unknown.
+ */
+int btRegistrySetHalt(BtRegistry *registry, const char *name, void (*halt)(BtContext *ctx))
+{
+    BtAction *action = (BtAction *)btRegistryFind(registry, name);
+    if (!action)
+        return 0;
+    action->halt = halt;
+    return 1;
+}
+
+/**
+ * @brief Looks up an action by name.
+ *
+ * @return const BtAction* The registered callbacks, or NULL if the name is
+ *                         unknown. Valid until the next registration.
+ */
+const BtAction *btRegistryFind(const BtRegistry *registry, const char *name)
+{
+    if (!registry || registry->index_capacity == 0)
+        return NULL;
+
+    uint32_t mask = registry->index_capacity - 1;
+    for (uint32_t slot = hashName(name) & mask; registry->index[slot]; slot = (slot + 1) & mask)
+    {
+        const RegistryEntry *entry = &registry->entries[registry->index[slot] - 1];
+        if (strcmp(entry->name, name) == 0)
+            return &entry->action;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Finds the name an action was registered under.
+ *
+ * Linear in the number of entries; meant for saving trees, not for ticking.
+ *
+ * @return const char* The name, or NULL if the action is not registered.
+ */
+const char *btRegistryNameOf(const BtRegistry *registry, BtAction action)
+{
+    if (!registry)
+        return NULL;
+    for (uint32_t i = 0; i < registry->count; i++)
+    {
+        const BtAction *entry = &registry->entries[i].action;
+        if (entry->action == action.action && entry->ctx_action == action.ctx_action && entry->async == action.async)
+            return registry->entries[i].name;
+    }
+    return NULL;
+}
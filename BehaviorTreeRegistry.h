@@ -0,0 +1,24 @@
+#ifndef BEHAVIOR_TREE_REGISTRY_H
+#define BEHAVIOR_TREE_REGISTRY_H
+
+#include "BehaviorTreeAsync.h"
+#include "BehaviorTreeFlat.h"
+
+/**
+ * @brief Maps stable action names to callbacks.
+ *
+ * Function pointers differ between builds and processes, so serialized trees
+ * refer to actions by name and are resolved through a registry when loaded.
+ */
+typedef struct BtRegistry BtRegistry;
+
+BtRegistry *btRegistryCreate(void);
+void btRegistryDestroy(BtRegistry *registry);
+int btRegistryAdd(BtRegistry *registry, const char *name, int (*action)(void));
+int btRegistryAddContext(BtRegistry *registry, const char *name, int (*ctx_action)(BtContext *ctx));
+int btRegistryAddAsync(BtRegistry *registry, const char *name, const BtAsyncAction *async);
+int btRegistrySetHalt(BtRegistry *registry, const char *name, void (*halt)(BtContext *ctx));
+const BtAction *btRegistryFind(const BtRegistry *registry, const char *name);
+const char *btRegistryNameOf(const BtRegistry *registry, BtAction action);
+
+#endif // BEHAVIOR_TREE_REGISTRY_H
@@ -0,0 +1,568 @@
+#include "BehaviorTreeScheduler.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SCHED_SUB_BITS 2u // 每个 2 的幂分成 4 个桶, 误差不超过 25%
+#define SCHED_MAX_EXPONENT 35u // 约 68 秒以上记入最后一个桶
+#define SCHED_BUCKETS (((SCHED_MAX_EXPONENT - SCHED_SUB_BITS + 2u) << SCHED_SUB_BITS))
+#define SCHED_INDEX_MASK 0xFFFFFFu // id 低 24 位: 下标 + 1, 高 8 位: 代数
+
+enum
+{
+    HEAP_NONE,
+    HEAP_WAITING, // 按到期时间排序, 尚未到期
+    HEAP_READY    // 已到期, 按调度策略排序
+};
+
+typedef struct
+{
+    uint64_t count;
+    uint64_t max;
+    uint32_t buckets[SCHED_BUCKETS];
+} Histogram;
+
+typedef struct
+{
+    BehaviorNode *root; // 指针树, 编译树时为 NULL
+    BtContext *ctx;
+    const BtFlatTree *tree;
+    BtInstance *instance;
+    int priority;
+    uint64_t period_ns;
+    uint64_t due_ns;
+    uint64_t estimate_ns; // tick 耗时的滑动平均, 用于判断是否还放得进本帧
+    uint32_t heap_index;
+    uint32_t next_free; // 空闲链表, 下标 + 1
+    uint8_t heap;       // HEAP_*
+    uint8_t generation;
+    uint8_t in_use;
+    uint8_t waited;     // 到期后至少推迟过一帧
+    uint8_t status;
+    uint64_t overruns;
+    uint64_t missed;
+    uint64_t deferred;
+    Histogram run;
+    Histogram wait;
+} SchedSlot;
+
+typedef struct
+{
+    uint32_t *items; // 槽位下标, 容量与槽位数相同
+    uint32_t count;
+} Heap;
+
+struct BtScheduler
+{
+    BtSchedPolicy policy;
+    SchedSlot *slots;
+    uint32_t capacity;
+    uint32_t count;
+    uint32_t free_head;
+    Heap waiting;
+    Heap ready;
+    uint64_t frames;
+    uint64_t overrun_frames;
+};
+
+static inline uint64_t nowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// 对数线性分桶: 小于 4 的值各占一个桶, 之后每个 2 的幂 4 个桶
+static uint32_t bucketOf(uint64_t value)
+{
+    if (value < (1u << SCHED_SUB_BITS))
+        return (uint32_t)value;
+    uint32_t exponent = 63u - (uint32_t)__builtin_clzll(value);
+    if (exponent > SCHED_MAX_EXPONENT)
+        return SCHED_BUCKETS - 1;
+    uint32_t sub = (uint32_t)(value >> (exponent - SCHED_SUB_BITS)) & ((1u << SCHED_SUB_BITS) - 1);
+    return ((exponent - SCHED_SUB_BITS + 1) << SCHED_SUB_BITS) + sub;
+}
+
+static uint64_t bucketUpper(uint32_t bucket)
+{
+    if (bucket < (1u << SCHED_SUB_BITS))
+        return bucket;
+    uint32_t exponent = (bucket >> SCHED_SUB_BITS) + SCHED_SUB_BITS - 1;
+    uint64_t sub = bucket & ((1u << SCHED_SUB_BITS) - 1);
+    uint64_t width = 1ull << (exponent - SCHED_SUB_BITS);
+    return (((1ull << SCHED_SUB_BITS) + sub) << (exponent - SCHED_SUB_BITS)) + width - 1;
+}
+
+static void record(Histogram *histogram, uint64_t value)
+{
+    histogram->count++;
+    histogram->buckets[bucketOf(value)]++;
+    if (value > histogram->max)
+        histogram->max = value;
+}
+
+// 返回桶的上界, 不超过观测到的最大值
+static uint64_t percentile(const Histogram *histogram, double q)
+{
+    uint64_t target = (uint64_t)(q * (double)histogram->count + 0.999999);
+    uint64_t seen = 0;
+
+    if (histogram->count == 0)
+        return 0;
+    if (target == 0)
+        target = 1;
+    for (uint32_t i = 0; i < SCHED_BUCKETS; i++)
+    {
+        seen += histogram->buckets[i];
+        if (seen >= target)
+        {
+            uint64_t upper = bucketUpper(i);
+            return upper < histogram->max ? upper : histogram->max;
+        }
+    }
+    return histogram->max;
+}
+
+// a 是否排在 b 之前
+static int before(const BtScheduler *scheduler, int ready, uint32_t a, uint32_t b)
+{
+    const SchedSlot *x = &scheduler->slots[a];
+    const SchedSlot *y = &scheduler->slots[b];
+
+    if (ready && scheduler->policy == BT_SCHED_PRIORITY)
+    {
+        if (x->priority != y->priority)
+            return x->priority > y->priority;
+        uint64_t dx = x->due_ns + x->period_ns, dy = y->due_ns + y->period_ns; // 截止时间
+        if (dx != dy)
+            return dx < dy;
+    }
+    else if (x->due_ns != y->due_ns)
+    {
+        return x->due_ns < y->due_ns;
+    }
+    return a < b;
+}
+
+static void heapPlace(BtScheduler *scheduler, Heap *heap, uint32_t position, uint32_t slot)
+{
+    heap->items[position] = slot;
+    scheduler->slots[slot].heap_index = position;
+}
+
+static void siftUp(BtScheduler *scheduler, Heap *heap, uint32_t position)
+{
+    int ready = heap == &scheduler->ready;
+    uint32_t slot = heap->items[position];
+
+    while (position > 0)
+    {
+        uint32_t parent = (position - 1) / 2;
+        if (!before(scheduler, ready, slot, heap->items[parent]))
+            break;
+        heapPlace(scheduler, heap, position, heap->items[parent]);
+        position = parent;
+    }
+    heapPlace(scheduler, heap, position, slot);
+}
+
+static void siftDown(BtScheduler *scheduler, Heap *heap, uint32_t position)
+{
+    int ready = heap == &scheduler->ready;
+    uint32_t slot = heap->items[position];
+
+    for (;;)
+    {
+        uint32_t child = position * 2 + 1;
+        if (child >= heap->count)
+            break;
+        if (child + 1 < heap->count && before(scheduler, ready, heap->items[child + 1], heap->items[child]))
+            child++;
+        if (!before(scheduler, ready, heap->items[child], slot))
+            break;
+        heapPlace(scheduler, heap, position, heap->items[child]);
+        position = child;
+    }
+    heapPlace(scheduler, heap, position, slot);
+}
+
+// 两个堆的容量都不小于槽位数, 不会失败
+static void heapPush(BtScheduler *scheduler, Heap *heap, uint32_t slot)
+{
+    scheduler->slots[slot].heap = heap == &scheduler->ready ? HEAP_READY : HEAP_WAITING;
+    heap->items[heap->count++] = slot;
+    siftUp(scheduler, heap, heap->count - 1);
+}
+
+static void heapRemove(BtScheduler *scheduler, Heap *heap, uint32_t position)
+{
+    uint32_t last = heap->items[--heap->count];
+
+    scheduler->slots[heap->items[position]].heap = HEAP_NONE;
+    if (position == heap->count)
+        return;
+    heapPlace(scheduler, heap, position, last);
+    siftUp(scheduler, heap, position);
+    siftDown(scheduler, heap, scheduler->slots[last].heap_index);
+}
+
+static SchedSlot *slotOf(const BtScheduler *scheduler, BtTreeId id)
+{
+    uint32_t index = (id & SCHED_INDEX_MASK) - 1;
+    if (id == 0 || index >= scheduler->capacity)
+        return NULL;
+    SchedSlot *slot = &scheduler->slots[index];
+    if (!slot->in_use || slot->generation != (uint8_t)(id >> 24))
+        return NULL;
+    return slot;
+}
+
+/**
+ * @brief Creates an empty scheduler.
+ *
+ * @return BtScheduler* The scheduler, or NULL if memory ran out.
+ */
+BtScheduler *btSchedulerCreate(BtSchedPolicy policy)
+{
+    BtScheduler *scheduler = calloc(1, sizeof(BtScheduler));
+    if (!scheduler)
+        return NULL;
+    scheduler->policy = policy;
+    return scheduler;
+}
+
+/**
+ * @brief Destroys a scheduler. The trees are neither halted nor freed.
+ */
+void btSchedulerDestroy(BtScheduler *scheduler)
+{
+    if (!scheduler)
+        return;
+    free(scheduler->slots);
+    free(scheduler->waiting.items);
+    free(scheduler->ready.items);
+    free(scheduler);
+}
+
+static int grow(BtScheduler *scheduler)
+{
+    uint32_t capacity = scheduler->capacity ? scheduler->capacity * 2 : 64;
+    if (capacity > SCHED_INDEX_MASK)
+        return 0;
+
+    SchedSlot *slots = realloc(scheduler->slots, sizeof(SchedSlot) * capacity);
+    if (!slots)
+        return 0;
+    scheduler->slots = slots;
+    uint32_t *waiting = realloc(scheduler->waiting.items, sizeof(uint32_t) * capacity);
+    if (waiting)
+        scheduler->waiting.items = waiting;
+    uint32_t *ready = waiting ? realloc(scheduler->ready.items, sizeof(uint32_t) * capacity) : NULL;
+    if (ready)
+        scheduler->ready.items = ready;
+    if (!waiting || !ready)
+        return 0; // 槽位数不变, 已扩大的数组继续可用
+
+    memset(slots + scheduler->capacity, 0, sizeof(SchedSlot) * (capacity - scheduler->capacity));
+    for (uint32_t i = scheduler->capacity; i < capacity; i++)
+        slots[i].next_free = i + 2 <= capacity ? i + 2 : scheduler->free_head;
+    scheduler->free_head = scheduler->capacity + 1;
+    scheduler->capacity = capacity;
+    return 1;
+}
+
+static BtTreeId add(BtScheduler *scheduler, int priority, uint32_t period_ms, SchedSlot **out)
+{
+    if (scheduler->free_head == 0 && !grow(scheduler))
+        return 0;
+
+    uint32_t index = scheduler->free_head - 1;
+    SchedSlot *slot = &scheduler->slots[index];
+    uint8_t generation = slot->generation;
+    uint32_t next = slot->next_free;
+
+    memset(slot, 0, sizeof(*slot));
+    scheduler->free_head = next;
+    slot->generation = generation;
+    slot->in_use = 1;
+    slot->priority = priority;
+    slot->period_ns = (uint64_t)period_ms * 1000000u;
+    slot->due_ns = nowNs(); // 立即到期
+    slot->status = BT_IDLE;
+    heapPush(scheduler, &scheduler->waiting, index);
+    scheduler->count++;
+    *out = slot;
+    return ((BtTreeId)generation << 24) | (index + 1);
+}
+
+/**
+ * @brief Schedules a pointer tree, ticked with tickTreeWithContext.
+ *
+ * A tree that finishes starts over on its next tick, as when tickTree is
+ * called in a loop. The tree is due at once.
+ *
+ * @param ctx       Agent context passed to the tree, may be NULL.
+ * @param priority  Higher goes first under BT_SCHED_PRIORITY.
+ * @param period_ms Time between two ticks, 0 for every frame.
+ * @return BtTreeId The id of the tree, 0 if memory ran out.
+ */
+BtTreeId btSchedulerAddTree(BtScheduler *scheduler, BehaviorNode *root, BtContext *ctx,
+                            int priority, uint32_t period_ms)
+{
+    SchedSlot *slot;
+
+    if (!root)
+        return 0;
+    BtTreeId id = add(scheduler, priority, period_ms, &slot);
+    if (id)
+    {
+        slot->root = root;
+        slot->ctx = ctx;
+    }
+    return id;
+}
+
+/**
+ * @brief Schedules an instance of a compiled tree, ticked with tickInstance.
+ *
+ * Same as btSchedulerAddTree otherwise.
+ */
+BtTreeId btSchedulerAddInstance(BtScheduler *scheduler, const BtFlatTree *tree, BtInstance *instance,
+                                int priority, uint32_t period_ms)
+{
+    SchedSlot *slot;
+
+    if (!tree || !instance)
+        return 0;
+    BtTreeId id = add(scheduler, priority, period_ms, &slot);
+    if (id)
+    {
+        slot->tree = tree;
+        slot->instance = instance;
+    }
+    return id;
+}
+
+/**
+ * @brief Removes a tree from the scheduler, halting it if it is running.
+ *
+ * @return int 1 on success, 0 if id is not scheduled.
+ */
+int btSchedulerRemove(BtScheduler *scheduler, BtTreeId id)
+{
+    SchedSlot *slot = slotOf(scheduler, id);
+    if (!slot)
+        return 0;
+
+    if (slot->root)
+        haltTreeWithContext(slot->root, slot->ctx);
+    else
+        btHaltInstance(slot->tree, slot->instance);
+    // 在自己的 tick 中移除时不在任何堆中
+    if (slot->heap != HEAP_NONE)
+        heapRemove(scheduler, slot->heap == HEAP_READY ? &scheduler->ready : &scheduler->waiting, slot->heap_index);
+
+    uint32_t index = (uint32_t)(slot - scheduler->slots);
+    slot->in_use = 0;
+    slot->generation++;
+    slot->next_free = scheduler->free_head;
+    scheduler->free_head = index + 1;
+    scheduler->count--;
+    return 1;
+}
+
+uint32_t btSchedulerCount(const BtScheduler *scheduler)
+{
+    return scheduler->count;
+}
+
+/**
+ * @brief Ticks due trees until the frame budget is used up.
+ *
+ * Trees whose due time has passed become ready; the ready trees are ticked
+ * in policy order. No new tick starts once budget_us has elapsed, but at
+ * least one tree is ticked per frame so that a tree slower than the budget
+ * still makes progress. A tick that ends past the budget is an overrun of
+ * that tree. Ready trees left over stay ready and go first next frame.
+ *
+ * @param report Filled with what the frame did, may be NULL.
+ * @return int Number of trees ticked.
+ */
+int btSchedulerRunFrame(BtScheduler *scheduler, uint32_t budget_us, BtFrameReport *report)
+{
+    uint64_t start = nowNs();
+    uint64_t budget = (uint64_t)budget_us * 1000u;
+    uint64_t nowMs = btMonotonicMs(); // 与 tickBatch 相同, 整帧共用一个时间
+    uint64_t now = start;
+    int ticked = 0, overrun = 0;
+
+    // 到期的树进入就绪堆; 每帧都要 tick 的树从本帧开始时算起
+    while (scheduler->waiting.count > 0 && scheduler->slots[scheduler->waiting.items[0]].due_ns <= start)
+    {
+        uint32_t index = scheduler->waiting.items[0];
+        heapRemove(scheduler, &scheduler->waiting, 0);
+        if (scheduler->slots[index].period_ns == 0)
+            scheduler->slots[index].due_ns = start;
+        heapPush(scheduler, &scheduler->ready, index);
+    }
+
+    while (scheduler->ready.count > 0)
+    {
+        uint32_t index = scheduler->ready.items[0];
+        SchedSlot *slot = &scheduler->slots[index];
+        // 预计放不进剩余预算就留到下一帧, 不跳过它去 tick 后面的树
+        if (ticked > 0 && now - start + slot->estimate_ns > budget)
+            break;
+        heapRemove(scheduler, &scheduler->ready, 0);
+
+        uint8_t generation = slot->generation;
+        NodeStatus status;
+        if (slot->root)
+            status = tickTreeWithContext(slot->root, slot->ctx, nowMs);
+        else
+            status = tickInstance(slot->tree, slot->instance, nowMs);
+        uint64_t end = nowNs();
+        slot = &scheduler->slots[index]; // 动作中可能添加了树
+        ticked++;
+        if (!slot->in_use || slot->generation != generation)
+        {
+            now = end; // 动作中移除了这棵树, 槽位可能已被新树复用
+            continue;
+        }
+
+        // 截止时间是下一次到期; 每帧都要 tick 的树在推迟过一帧时算作错过
+        if (slot->period_ns ? now > slot->due_ns + slot->period_ns : slot->waited)
+            slot->missed++;
+        record(&slot->wait, now - slot->due_ns);
+        record(&slot->run, end - now);
+        slot->estimate_ns = slot->run.count == 1 ? end - now : slot->estimate_ns - slot->estimate_ns / 8 + (end - now) / 8;
+        if (end - start > budget)
+        {
+            slot->overruns++;
+            overrun = 1;
+        }
+        slot->status = (uint8_t)status;
+        slot->waited = 0;
+
+        // 保持固定节拍; 落后超过一个周期时从本次 tick 重新计算
+        slot->due_ns += slot->period_ns;
+        if (slot->due_ns <= now)
+            slot->due_ns = now + slot->period_ns;
+        heapPush(scheduler, &scheduler->waiting, index);
+        now = end;
+    }
+
+    for (uint32_t i = 0; i < scheduler->ready.count; i++)
+    {
+        SchedSlot *slot = &scheduler->slots[scheduler->ready.items[i]];
+        slot->deferred++;
+        slot->waited = 1;
+    }
+
+    scheduler->frames++;
+    scheduler->overrun_frames += overrun;
+    if (report)
+    {
+        report->ticked = (uint32_t)ticked;
+        report->deferred = scheduler->ready.count;
+        report->elapsed_ns = now - start;
+        report->overrun = overrun;
+    }
+    return ticked;
+}
+
+/**
+ * @brief Reads the statistics of a tree.
+ *
+ * @return int 1 on success, 0 if id is not scheduled.
+ */
+int btSchedulerStats(const BtScheduler *scheduler, BtTreeId id, BtTreeStats *out)
+{
+    const SchedSlot *slot = slotOf(scheduler, id);
+    if (!slot)
+        return 0;
+
+    out->ticks = slot->run.count;
+    out->overruns = slot->overruns;
+    out->missed = slot->missed;
+    out->deferred = slot->deferred;
+    out->run_p50_ns = percentile(&slot->run, 0.50);
+    out->run_p99_ns = percentile(&slot->run, 0.99);
+    out->run_max_ns = slot->run.max;
+    out->wait_p50_ns = percentile(&slot->wait, 0.50);
+    out->wait_p99_ns = percentile(&slot->wait, 0.99);
+    out->wait_max_ns = slot->wait.max;
+    out->status = slot->status;
+    return 1;
+}
+
+/**
+ * @brief Clears the statistics of all trees and of the scheduler.
+ */
+void btSchedulerResetStats(BtScheduler *scheduler)
+{
+    for (uint32_t i = 0; i < scheduler->capacity; i++)
+    {
+        SchedSlot *slot = &scheduler->slots[i];
+        slot->overruns = 0;
+        slot->missed = 0;
+        slot->deferred = 0;
+        memset(&slot->run, 0, sizeof(slot->run));
+        memset(&slot->wait, 0, sizeof(slot->wait));
+    }
+    scheduler->frames = 0;
+    scheduler->overrun_frames = 0;
+}
+
+typedef struct
+{
+    BtTreeId id;
+    BtTreeStats stats;
+} DumpRow;
+
+static int byWaitDescending(const void *a, const void *b)
+{
+    const DumpRow *x = a, *y = b;
+    if (x->stats.wait_p99_ns != y->stats.wait_p99_ns)
+        return x->stats.wait_p99_ns < y->stats.wait_p99_ns ? 1 : -1;
+    return x->id < y->id ? -1 : x->id > y->id;
+}
+
+/**
+ * @brief Prints the n trees with the longest p99 wait, all trees if n <= 0.
+ */
+void btSchedulerDump(const BtScheduler *scheduler, FILE *out, int n)
+{
+    DumpRow *rows = malloc(sizeof(DumpRow) * (scheduler->count ? scheduler->count : 1));
+    uint32_t count = 0;
+
+    if (!rows)
+        return;
+    for (uint32_t i = 0; i < scheduler->capacity; i++)
+    {
+        const SchedSlot *slot = &scheduler->slots[i];
+        if (!slot->in_use)
+            continue;
+        rows[count].id = ((BtTreeId)slot->generation << 24) | (i + 1);
+        btSchedulerStats(scheduler, rows[count].id, &rows[count].stats);
+        count++;
+    }
+    qsort(rows, count, sizeof(DumpRow), byWaitDescending);
+    if (n > 0 && (uint32_t)n < count)
+        count = (uint32_t)n;
+
+    fprintf(out, "%llu frames, %llu over budget, %u trees\n", (unsigned long long)scheduler->frames,
+            (unsigned long long)scheduler->overrun_frames, scheduler->count);
+    fprintf(out, "%10s %10s %8s %8s %8s %10s %10s %10s %10s %10s\n", "tree", "ticks", "overrun", "missed",
+            "deferred", "run p50", "run p99", "wait p50", "wait p99", "wait max");
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const BtTreeStats *s = &rows[i].stats;
+        fprintf(out, "%10u %10llu %8llu %8llu %8llu %8.1fus %8.1fus %8.1fus %8.1fus %8.1fus\n", rows[i].id,
+                (unsigned long long)s->ticks, (unsigned long long)s->overruns, (unsigned long long)s->missed,
+                (unsigned long long)s->deferred, s->run_p50_ns / 1e3, s->run_p99_ns / 1e3,
+                s->wait_p50_ns / 1e3, s->wait_p99_ns / 1e3, s->wait_max_ns / 1e3);
+    }
+    free(rows);
+}
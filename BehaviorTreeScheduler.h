@@ -0,0 +1,87 @@
+#ifndef BEHAVIOR_TREE_SCHEDULER_H
+#define BEHAVIOR_TREE_SCHEDULER_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "BehaviorTree.h"
+#include "BehaviorTreeFlat.h"
+
+/*
+ * Ticks many trees within a time budget per frame.
+ *
+ * The scheduler owns a set of trees, either pointer trees (tickTree) or
+ * instances of a compiled tree (tickInstance). Each tree is due again
+ * period_ms after its last tick (0: once per frame). btSchedulerRunFrame
+ * ticks the due trees one at a time and stops starting new ticks once the
+ * frame budget is used up; trees that were due but did not get a tick keep
+ * their place and go first in the next frame, so no tree is dropped, only
+ * delayed.
+ *
+ * The order within a frame is, by policy:
+ *   - BT_SCHED_ROUND_ROBIN: the tree that has been due the longest first.
+ *   - BT_SCHED_PRIORITY:    higher priority first; among equal priorities the
+ *                           earliest deadline (due time + period) first.
+ *
+ * For every tree the scheduler records the run time of its ticks and the
+ * wait between becoming due and being ticked, as percentiles, and counts
+ * the ticks that overran the frame budget and the deadlines it missed.
+ *
+ * A scheduler is driven by one thread. The trees may be ticked from within
+ * other frameworks as well, but not at the same time.
+ */
+typedef struct BtScheduler BtScheduler;
+typedef uint32_t BtTreeId; // 0 表示无效
+
+typedef enum
+{
+    BT_SCHED_ROUND_ROBIN,
+    BT_SCHED_PRIORITY
+} BtSchedPolicy;
+
+/**
+ * @brief Statistics of one tree. Times are in nanoseconds; percentiles are
+ * accurate to about 20 percent (log-linear histogram buckets).
+ */
+typedef struct
+{
+    uint64_t ticks;
+    uint64_t overruns;  // tick 结束时帧已超出预算的次数
+    uint64_t missed;    // 晚于截止时间的 tick 次数
+    uint64_t deferred;  // 到期但因预算用完推迟到下一帧的次数
+    uint64_t run_p50_ns;
+    uint64_t run_p99_ns;
+    uint64_t run_max_ns;
+    uint64_t wait_p50_ns; // 到期到开始 tick 的等待
+    uint64_t wait_p99_ns;
+    uint64_t wait_max_ns;
+    uint8_t status;       // 上一次 tick 的结果 (NodeStatus)
+} BtTreeStats;
+
+/**
+ * @brief What one call to btSchedulerRunFrame did.
+ */
+typedef struct
+{
+    uint32_t ticked;
+    uint32_t deferred; // 到期但没有 tick 的树
+    uint64_t elapsed_ns;
+    int overrun;       // 帧超出预算
+} BtFrameReport;
+
+BtScheduler *btSchedulerCreate(BtSchedPolicy policy);
+void btSchedulerDestroy(BtScheduler *scheduler);
+
+BtTreeId btSchedulerAddTree(BtScheduler *scheduler, BehaviorNode *root, BtContext *ctx,
+                            int priority, uint32_t period_ms);
+BtTreeId btSchedulerAddInstance(BtScheduler *scheduler, const BtFlatTree *tree, BtInstance *instance,
+                                int priority, uint32_t period_ms);
+int btSchedulerRemove(BtScheduler *scheduler, BtTreeId id);
+uint32_t btSchedulerCount(const BtScheduler *scheduler);
+
+int btSchedulerRunFrame(BtScheduler *scheduler, uint32_t budget_us, BtFrameReport *report);
+
+int btSchedulerStats(const BtScheduler *scheduler, BtTreeId id, BtTreeStats *out);
+void btSchedulerResetStats(BtScheduler *scheduler);
+void btSchedulerDump(const BtScheduler *scheduler, FILE *out, int n);
+
+#endif // BEHAVIOR_TREE_SCHEDULER_H
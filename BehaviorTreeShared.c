@@ -0,0 +1,405 @@
+#include "BehaviorTreeShared.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#define SHARED_CACHE_LINE 64
+
+struct BtSharedVersion
+{
+    atomic_uint refs;       // 作为当前版本的一个引用 + 每个绑定的 agent 一个
+    BtFlatTree *tree;
+    uint64_t number;
+    uint64_t retired_epoch; // 被替换时的纪元
+    BtSharedVersion *next;  // 回收链表
+};
+
+// 每个读者独占一个缓存行, 进出读区不会互相干扰
+struct BtSharedReader
+{
+    _Alignas(SHARED_CACHE_LINE) atomic_ullong epoch; // 读区内宣告的纪元, 0 表示不在读区内
+    atomic_int in_use;
+    uint32_t depth; // 读区嵌套层数, 只由所属线程访问
+    BtShared *shared;
+};
+
+struct BtShared
+{
+    _Atomic(BtSharedVersion *) current;
+    atomic_ullong epoch;     // 每次发布加一
+    pthread_mutex_t lock;    // 保护发布和回收链表
+    BtSharedVersion *retired;
+    uint32_t retired_count;
+    uint64_t published;
+    uint64_t freed;
+    uint32_t max_readers;
+    BtSharedReader *readers;
+};
+
+/**
+ * @brief Creates an empty publication point for up to max_readers threads.
+ *
+ * @return BtShared* The shared tree, or NULL if memory ran out.
+ */
+BtShared *btSharedCreate(uint32_t max_readers)
+{
+    BtShared *shared = calloc(1, sizeof(BtShared));
+    if (!shared)
+        return NULL;
+    if (max_readers == 0)
+        max_readers = 1;
+    shared->readers = aligned_alloc(SHARED_CACHE_LINE, sizeof(BtSharedReader) * max_readers);
+    if (!shared->readers)
+    {
+        free(shared);
+        return NULL;
+    }
+    for (uint32_t i = 0; i < max_readers; i++)
+    {
+        atomic_init(&shared->readers[i].epoch, 0);
+        atomic_init(&shared->readers[i].in_use, 0);
+        shared->readers[i].depth = 0;
+        shared->readers[i].shared = shared;
+    }
+    shared->max_readers = max_readers;
+    atomic_init(&shared->current, NULL);
+    atomic_init(&shared->epoch, 1);
+    pthread_mutex_init(&shared->lock, NULL);
+    return shared;
+}
+
+static void freeVersion(BtSharedVersion *version)
+{
+    btFreeFlatTree(version->tree);
+    free(version);
+}
+
+/**
+ * @brief Frees the shared tree and every version it still holds.
+ *
+ * All readers must be unregistered and all agents released.
+ */
+void btSharedDestroy(BtShared *shared)
+{
+    if (!shared)
+        return;
+    BtSharedVersion *current = atomic_load_explicit(&shared->current, memory_order_relaxed);
+    if (current)
+        freeVersion(current);
+    while (shared->retired)
+    {
+        BtSharedVersion *next = shared->retired->next;
+        freeVersion(shared->retired);
+        shared->retired = next;
+    }
+    pthread_mutex_destroy(&shared->lock);
+    free(shared->readers);
+    free(shared);
+}
+
+// 调用者持有 lock
+static void retireLocked(BtShared *shared, BtSharedVersion *version)
+{
+    version->next = shared->retired;
+    shared->retired = version;
+    shared->retired_count++;
+}
+
+// 放开一个引用; 最后一个引用消失时移入回收链表, 返回 1
+static int dropVersion(BtShared *shared, BtSharedVersion *version)
+{
+    if (atomic_fetch_sub_explicit(&version->refs, 1, memory_order_acq_rel) != 1)
+        return 0;
+    pthread_mutex_lock(&shared->lock);
+    retireLocked(shared, version);
+    pthread_mutex_unlock(&shared->lock);
+    return 1;
+}
+
+// 调用者持有 lock. 被替换时的纪元小于所有读区内读者宣告的纪元的版本可以释放
+static size_t collectLocked(BtShared *shared)
+{
+    uint64_t oldest = UINT64_MAX;
+    size_t freed = 0;
+
+    for (uint32_t i = 0; i < shared->max_readers; i++)
+    {
+        uint64_t epoch = atomic_load_explicit(&shared->readers[i].epoch, memory_order_seq_cst);
+        if (epoch != 0 && epoch < oldest)
+            oldest = epoch;
+    }
+
+    BtSharedVersion **link = &shared->retired;
+    while (*link)
+    {
+        BtSharedVersion *version = *link;
+        if (version->retired_epoch >= oldest)
+        {
+            link = &version->next;
+            continue;
+        }
+        *link = version->next;
+        freeVersion(version);
+        shared->retired_count--;
+        freed++;
+    }
+    shared->freed += freed;
+    return freed;
+}
+
+/**
+ * @brief Frees the retired versions that no reader can reach any more.
+ *
+ * @return size_t Number of versions freed.
+ */
+size_t btSharedCollect(BtShared *shared)
+{
+    pthread_mutex_lock(&shared->lock);
+    size_t freed = collectLocked(shared);
+    pthread_mutex_unlock(&shared->lock);
+    return freed;
+}
+
+/**
+ * @brief Makes tree the current version.
+ *
+ * The shared tree takes ownership of tree and frees it with btFreeFlatTree
+ * once it has been replaced and released by every agent and reader. Agents
+ * move to the new version on their next tick; readers see it in their next
+ * read section.
+ *
+ * @return uint64_t Version number, counting from 1, or 0 if memory ran out
+ *                  (tree then stays with the caller).
+ */
+uint64_t btSharedPublish(BtShared *shared, BtFlatTree *tree)
+{
+    if (!tree)
+        return 0;
+    BtSharedVersion *version = malloc(sizeof(BtSharedVersion));
+    if (!version)
+        return 0;
+    atomic_init(&version->refs, 1);
+    version->tree = tree;
+    version->retired_epoch = 0;
+    version->next = NULL;
+
+    pthread_mutex_lock(&shared->lock);
+    version->number = ++shared->published;
+    BtSharedVersion *old = atomic_exchange_explicit(&shared->current, version, memory_order_seq_cst);
+    // 替换之后才推进纪元: 读到旧版本的读者宣告的纪元都不大于 retired_epoch
+    uint64_t epoch = atomic_fetch_add_explicit(&shared->epoch, 1, memory_order_seq_cst);
+    if (old)
+    {
+        old->retired_epoch = epoch;
+        if (atomic_fetch_sub_explicit(&old->refs, 1, memory_order_acq_rel) == 1)
+            retireLocked(shared, old);
+    }
+    collectLocked(shared);
+    pthread_mutex_unlock(&shared->lock);
+    return version->number;
+}
+
+void btSharedGetStats(BtShared *shared, BtSharedStats *out)
+{
+    pthread_mutex_lock(&shared->lock);
+    out->published = shared->published;
+    out->freed = shared->freed;
+    out->retired = shared->retired_count;
+    out->readers = 0;
+    for (uint32_t i = 0; i < shared->max_readers; i++)
+        out->readers += (uint32_t)atomic_load_explicit(&shared->readers[i].in_use, memory_order_relaxed);
+    pthread_mutex_unlock(&shared->lock);
+}
+
+/**
+ * @brief Registers the calling thread as a reader.
+ *
+ * @return BtSharedReader* The thread's reader, NULL if max_readers threads
+ *                         are already registered.
+ */
+BtSharedReader *btSharedRegister(BtShared *shared)
+{
+    for (uint32_t i = 0; i < shared->max_readers; i++)
+    {
+        int expected = 0;
+        if (atomic_compare_exchange_strong_explicit(&shared->readers[i].in_use, &expected, 1,
+                                                    memory_order_acquire, memory_order_relaxed))
+        {
+            shared->readers[i].depth = 0;
+            return &shared->readers[i];
+        }
+    }
+    return NULL;
+}
+
+void btSharedUnregister(BtSharedReader *reader)
+{
+    if (!reader)
+        return;
+    atomic_store_explicit(&reader->epoch, 0, memory_order_release);
+    atomic_store_explicit(&reader->in_use, 0, memory_order_release);
+}
+
+static BtSharedVersion *enterVersion(BtSharedReader *reader)
+{
+    BtShared *shared = reader->shared;
+
+    // 先宣告纪元再读取当前版本, 两者都是 seq_cst, 与发布时的替换和推进纪元排成全序
+    if (reader->depth++ == 0)
+    {
+        uint64_t epoch = atomic_load_explicit(&shared->epoch, memory_order_seq_cst);
+        atomic_store_explicit(&reader->epoch, epoch, memory_order_seq_cst);
+    }
+    return atomic_load_explicit(&shared->current, memory_order_seq_cst);
+}
+
+/**
+ * @brief Starts a read section and returns the current tree.
+ *
+ * The tree stays valid until the matching btSharedExit, even if a newer
+ * version is published meanwhile. Sections may nest.
+ *
+ * @return const BtFlatTree* The current tree, NULL if none was published.
+ */
+const BtFlatTree *btSharedEnter(BtSharedReader *reader)
+{
+    BtSharedVersion *version = enterVersion(reader);
+    return version ? version->tree : NULL;
+}
+
+void btSharedExit(BtSharedReader *reader)
+{
+    if (--reader->depth == 0)
+        atomic_store_explicit(&reader->epoch, 0, memory_order_release);
+}
+
+/**
+ * @brief Runs the current tree once with executeFlat.
+ *
+ * Cache and cooldown decorators have no effect on this path, see
+ * executeFlat; agents that rely on them use btSharedTick.
+ *
+ * @return int The result, 0 if no tree was published.
+ */
+int btSharedExecute(BtSharedReader *reader, BtContext *ctx)
+{
+    BtSharedVersion *version = enterVersion(reader);
+    int result = version ? executeFlat(version->tree, ctx) : 0;
+    btSharedExit(reader);
+    return result;
+}
+
+void btSharedAgentInit(BtSharedAgent *agent, BtContext context)
+{
+    agent->version = NULL;
+    agent->instance = NULL;
+    agent->context = context;
+}
+
+/**
+ * @brief Takes a reference to the current version.
+ *
+ * A version whose count already dropped to 0 has been replaced and may be
+ * retired, so it is never revived; the current version is read again.
+ * Called inside a read section, which keeps the loaded version from being
+ * freed before its count is checked.
+ */
+static BtSharedVersion *acquireCurrent(BtSharedReader *reader)
+{
+    for (;;)
+    {
+        BtSharedVersion *version = enterVersion(reader);
+        unsigned refs = version ? atomic_load_explicit(&version->refs, memory_order_relaxed) : 0;
+        while (refs != 0)
+        {
+            if (atomic_compare_exchange_weak_explicit(&version->refs, &refs, refs + 1, memory_order_acquire,
+                                                      memory_order_relaxed))
+            {
+                btSharedExit(reader);
+                return version;
+            }
+        }
+        btSharedExit(reader);
+        if (!version)
+            return NULL;
+    }
+}
+
+// 放开引用; 是最后一个引用时尽量立即回收, 锁被占用时留给下一次回收
+static void release(BtShared *shared, BtSharedVersion *version)
+{
+    if (dropVersion(shared, version) && pthread_mutex_trylock(&shared->lock) == 0)
+    {
+        collectLocked(shared);
+        pthread_mutex_unlock(&shared->lock);
+    }
+}
+
+// 把 agent 换到新版本: 在旧树上中止运行中的节点, 为新树创建实例
+static int rebind(BtShared *shared, BtSharedReader *reader, BtSharedAgent *agent)
+{
+    BtSharedVersion *version = acquireCurrent(reader);
+    if (!version)
+        return 0;
+    BtInstance *instance = btCreateInstances(version->tree, 1);
+    if (!instance)
+    {
+        release(shared, version);
+        return 0;
+    }
+
+    BtSharedVersion *old = agent->version;
+    if (old)
+    {
+        btHaltInstance(old->tree, agent->instance);
+        agent->context = agent->instance->context; // 调用者可能改过实例中的上下文
+        btFreeInstances(agent->instance);
+        release(shared, old);
+    }
+    instance->context = agent->context;
+    agent->version = version;
+    agent->instance = instance;
+    return 1;
+}
+
+/**
+ * @brief Ticks an agent on the current version of the tree.
+ *
+ * While the agent's version is current this is tickInstance plus one atomic
+ * load: the agent's reference keeps its tree alive, so no read section is
+ * needed. After a publish the agent is halted on its old tree, gets a fresh
+ * instance for the new one and starts it from scratch.
+ *
+ * @return NodeStatus The result of the tick, BT_FAILURE if no tree was
+ *                    published or memory ran out.
+ */
+NodeStatus btSharedTick(BtSharedReader *reader, BtSharedAgent *agent, uint64_t now_ms)
+{
+    BtShared *shared = reader->shared;
+
+    // 只比较指针: agent 持有自己版本的引用, 它的地址不会被复用
+    if (atomic_load_explicit(&shared->current, memory_order_acquire) != agent->version &&
+        !rebind(shared, reader, agent))
+    {
+        return BT_FAILURE;
+    }
+    if (!agent->version)
+        return BT_FAILURE;
+    return tickInstance(agent->version->tree, agent->instance, now_ms);
+}
+
+/**
+ * @brief Halts an agent and releases its instance and its version.
+ */
+void btSharedAgentRelease(BtShared *shared, BtSharedAgent *agent)
+{
+    if (!agent->version)
+        return;
+    btHaltInstance(agent->version->tree, agent->instance);
+    agent->context = agent->instance->context;
+    btFreeInstances(agent->instance);
+    if (dropVersion(shared, agent->version))
+        btSharedCollect(shared);
+    agent->version = NULL;
+    agent->instance = NULL;
+}
@@ -0,0 +1,72 @@
+#ifndef BEHAVIOR_TREE_SHARED_H
+#define BEHAVIOR_TREE_SHARED_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "BehaviorTreeFlat.h"
+
+/*
+ * One compiled tree shared by many worker threads, RCU style.
+ *
+ * A BtShared holds the current version of a tree, a BtFlatTree that is
+ * never written once published. Workers run it without locks or copies,
+ * each agent keeping its per-node state in its own BtInstance; a writer
+ * replaces the tree with btSharedPublish (e.g. to hot-reload it) while the
+ * workers keep running. A replaced version is freed only when no worker can
+ * reach it any more:
+ *
+ *   - every worker thread registers a BtSharedReader and brackets each use
+ *     of the tree with btSharedEnter / btSharedExit. Inside, the reader
+ *     announces the global epoch; a version replaced during epoch E is not
+ *     freed while some reader announced an epoch <= E;
+ *   - a BtSharedAgent holds an atomic reference to the version its instance
+ *     was created for, so a running agent keeps its tree alive outside any
+ *     read section. On its next tick it moves to the newest version,
+ *     halting whatever was running on the old one first.
+ *
+ * Versions whose last reference is gone are freed by btSharedCollect, which
+ * btSharedPublish and the tick that drops the last reference also call.
+ *
+ * A tick on the current version costs one atomic load on top of
+ * tickInstance; entering a read section costs two stores and two loads.
+ * Only moving an agent to a new version allocates or takes a lock.
+ */
+typedef struct BtShared BtShared;
+typedef struct BtSharedReader BtSharedReader;
+typedef struct BtSharedVersion BtSharedVersion;
+
+/**
+ * @brief An agent running the shared tree, owned by one thread at a time.
+ */
+typedef struct BtSharedAgent
+{
+    BtSharedVersion *version; // 实例所属的版本, 持有它的一个引用
+    BtInstance *instance;
+    BtContext context;        // 第一次绑定时复制给实例, 之后以实例中的为准并带到新版本
+} BtSharedAgent;
+
+typedef struct BtSharedStats
+{
+    uint64_t published;
+    uint64_t freed;
+    uint32_t retired; // 已无引用, 等待读者离开的版本
+    uint32_t readers;
+} BtSharedStats;
+
+BtShared *btSharedCreate(uint32_t max_readers);
+void btSharedDestroy(BtShared *shared);
+uint64_t btSharedPublish(BtShared *shared, BtFlatTree *tree);
+size_t btSharedCollect(BtShared *shared);
+void btSharedGetStats(BtShared *shared, BtSharedStats *out);
+
+BtSharedReader *btSharedRegister(BtShared *shared);
+void btSharedUnregister(BtSharedReader *reader);
+const BtFlatTree *btSharedEnter(BtSharedReader *reader);
+void btSharedExit(BtSharedReader *reader);
+int btSharedExecute(BtSharedReader *reader, BtContext *ctx);
+
+void btSharedAgentInit(BtSharedAgent *agent, BtContext context);
+NodeStatus btSharedTick(BtSharedReader *reader, BtSharedAgent *agent, uint64_t now_ms);
+void btSharedAgentRelease(BtShared *shared, BtSharedAgent *agent);
+
+#endif // BEHAVIOR_TREE_SHARED_H
@@ -0,0 +1,318 @@
+#include "BehaviorTreeTimer.h"
+#include <stdlib.h>
+
+#define ROOT_BITS 8
+#define ROOT_SIZE (1u << ROOT_BITS)
+#define LEVEL_BITS 6
+#define LEVEL_SIZE (1u << LEVEL_BITS)
+#define UPPER_LEVELS 3
+#define MAX_DELTA ((uint64_t)1 << (ROOT_BITS + UPPER_LEVELS * LEVEL_BITS))
+
+// 槽是带哨兵的双向循环链表
+typedef struct
+{
+    BtTimer head;
+} TimerSlot;
+
+struct BtTimerWheel
+{
+    uint64_t current; // 下一个要处理的毫秒
+    uint32_t count;
+    uint64_t root_bits[ROOT_SIZE / 64];
+    uint64_t level_bits[UPPER_LEVELS];
+    TimerSlot root[ROOT_SIZE];
+    TimerSlot levels[UPPER_LEVELS][LEVEL_SIZE];
+};
+
+static void slotInit(TimerSlot *slot)
+{
+    slot->head.next = &slot->head;
+    slot->head.prev = &slot->head;
+}
+
+static int slotEmpty(const TimerSlot *slot)
+{
+    return slot->head.next == &slot->head;
+}
+
+static unsigned levelShift(int level)
+{
+    return ROOT_BITS + (unsigned)level * LEVEL_BITS;
+}
+
+/**
+ * @brief Creates an empty wheel whose clock starts at now_ms.
+ *
+ * @return BtTimerWheel* The wheel, or NULL if memory could not be allocated.
+ */
+BtTimerWheel *btTimerWheelCreate(uint64_t now_ms)
+{
+    BtTimerWheel *wheel = calloc(1, sizeof(BtTimerWheel));
+    if (!wheel)
+        return NULL;
+    wheel->current = now_ms;
+    for (unsigned i = 0; i < ROOT_SIZE; i++)
+        slotInit(&wheel->root[i]);
+    for (int level = 0; level < UPPER_LEVELS; level++)
+    {
+        for (unsigned i = 0; i < LEVEL_SIZE; i++)
+            slotInit(&wheel->levels[level][i]);
+    }
+    return wheel;
+}
+
+/**
+ * @brief Frees the wheel. Pending timers are dropped without firing.
+ */
+void btTimerWheelDestroy(BtTimerWheel *wheel)
+{
+    free(wheel);
+}
+
+void btTimerInit(BtTimer *timer, void (*callback)(BtTimer *timer, void *user), void *user)
+{
+    timer->next = NULL;
+    timer->prev = NULL;
+    timer->expires = 0;
+    timer->callback = callback;
+    timer->user = user;
+}
+
+int btTimerPending(const BtTimer *timer)
+{
+    return timer->prev != NULL;
+}
+
+static void insertTimer(BtTimerWheel *wheel, BtTimer *timer)
+{
+    uint64_t expires = timer->expires;
+    TimerSlot *slot;
+
+    if ((int64_t)(expires - wheel->current) < 0)
+        expires = wheel->current; // 已过期, 下次推进时触发
+    uint64_t delta = expires - wheel->current;
+
+    if (delta < ROOT_SIZE)
+    {
+        unsigned index = (unsigned)(expires & (ROOT_SIZE - 1));
+        slot = &wheel->root[index];
+        wheel->root_bits[index / 64] |= 1ull << (index % 64);
+    }
+    else
+    {
+        int level = 0;
+        if (delta >= MAX_DELTA)
+            expires = wheel->current + MAX_DELTA - 1; // 放在最高层, 级联时重新归档
+        while (level < UPPER_LEVELS - 1 && delta >= ((uint64_t)1 << levelShift(level + 1)))
+            level++;
+        unsigned index = (unsigned)((expires >> levelShift(level)) & (LEVEL_SIZE - 1));
+        slot = &wheel->levels[level][index];
+        wheel->level_bits[level] |= 1ull << index;
+    }
+
+    timer->next = &slot->head;
+    timer->prev = slot->head.prev;
+    slot->head.prev->next = timer;
+    slot->head.prev = timer;
+}
+
+static void unlinkTimer(BtTimer *timer)
+{
+    timer->prev->next = timer->next;
+    timer->next->prev = timer->prev;
+    timer->next = NULL;
+    timer->prev = NULL;
+}
+
+/**
+ * @brief Schedules (or reschedules) a timer to fire at expires_ms.
+ *
+ * A time in the past fires on the next btTimerWheelAdvance.
+ */
+void btTimerSchedule(BtTimerWheel *wheel, BtTimer *timer, uint64_t expires_ms)
+{
+    if (btTimerPending(timer))
+        btTimerCancel(wheel, timer);
+    timer->expires = expires_ms;
+    insertTimer(wheel, timer);
+    wheel->count++;
+}
+
+/**
+ * @brief Removes a pending timer. Does nothing if the timer is not scheduled.
+ *
+ * The occupancy bit of the slot is cleared lazily by the next scan.
+ */
+void btTimerCancel(BtTimerWheel *wheel, BtTimer *timer)
+{
+    if (!btTimerPending(timer))
+        return;
+    unlinkTimer(timer);
+    wheel->count--;
+}
+
+static void cascade(BtTimerWheel *wheel, int level)
+{
+    unsigned index = (unsigned)((wheel->current >> levelShift(level)) & (LEVEL_SIZE - 1));
+    TimerSlot *slot = &wheel->levels[level][index];
+    TimerSlot moved;
+
+    if (!(wheel->level_bits[level] & (1ull << index)))
+        return;
+    wheel->level_bits[level] &= ~(1ull << index);
+    if (slotEmpty(slot))
+        return;
+
+    // 先整体摘下, 再逐个重新插入到更低的层
+    moved.head.next = slot->head.next;
+    moved.head.prev = slot->head.prev;
+    moved.head.next->prev = &moved.head;
+    moved.head.prev->next = &moved.head;
+    slotInit(slot);
+    while (!slotEmpty(&moved))
+    {
+        BtTimer *timer = moved.head.next;
+        unlinkTimer(timer);
+        insertTimer(wheel, timer);
+    }
+}
+
+static int fireSlot(BtTimerWheel *wheel, unsigned index)
+{
+    TimerSlot *slot = &wheel->root[index];
+    int fired = 0;
+
+    wheel->root_bits[index / 64] &= ~(1ull << (index % 64));
+    // 回调中新加入本槽的定时器也在这里触发
+    while (!slotEmpty(slot))
+    {
+        BtTimer *timer = slot->head.next;
+        unlinkTimer(timer);
+        wheel->count--;
+        fired++;
+        timer->callback(timer, timer->user);
+    }
+    return fired;
+}
+
+// 返回 [from, ROOT_SIZE) 中第一个被占用的槽, 没有则返回 ROOT_SIZE
+static unsigned nextRootSlot(const BtTimerWheel *wheel, unsigned from)
+{
+    for (unsigned word = from / 64; word < ROOT_SIZE / 64; word++)
+    {
+        uint64_t bits = wheel->root_bits[word];
+        if (word == from / 64)
+            bits &= ~0ull << (from % 64);
+        if (bits)
+            return word * 64 + (unsigned)__builtin_ctzll(bits);
+    }
+    return ROOT_SIZE;
+}
+
+/**
+ * @brief Advances the wheel clock to now_ms and fires every timer that is due.
+ *
+ * Callbacks may schedule or cancel timers, including the one being fired.
+ *
+ * @return int Number of timers fired.
+ */
+int btTimerWheelAdvance(BtTimerWheel *wheel, uint64_t now_ms)
+{
+    int fired = 0;
+
+    while ((int64_t)(now_ms - wheel->current) >= 0)
+    {
+        unsigned index = (unsigned)(wheel->current & (ROOT_SIZE - 1));
+
+        if (wheel->count == 0)
+        {
+            wheel->current = now_ms + 1;
+            break;
+        }
+        if (index == 0)
+        {
+            // 在层边界上从高到低级联
+            for (int level = UPPER_LEVELS - 1; level >= 0; level--)
+            {
+                uint64_t mask = ((uint64_t)1 << levelShift(level)) - 1;
+                if ((wheel->current & mask) == 0)
+                    cascade(wheel, level);
+            }
+        }
+        if (wheel->root_bits[index / 64] & (1ull << (index % 64)))
+            fired += fireSlot(wheel, index);
+
+        // 跳到下一个被占用的槽或下一个层边界
+        unsigned next = nextRootSlot(wheel, index + 1);
+        uint64_t target = (wheel->current - index) + next;
+        if ((int64_t)(target - now_ms) > 0)
+            target = now_ms + 1;
+        wheel->current = target;
+    }
+    return fired;
+}
+
+static uint64_t slotMinimum(const TimerSlot *slot)
+{
+    uint64_t minimum = BT_TIMER_NONE;
+    for (const BtTimer *timer = slot->head.next; timer != &slot->head; timer = timer->next)
+    {
+        if (timer->expires < minimum)
+            minimum = timer->expires;
+    }
+    return minimum;
+}
+
+/**
+ * @brief Returns the expiry time of the earliest pending timer.
+ *
+ * A tick loop can sleep until this time, since nothing can become due
+ * earlier unless a new timer is scheduled.
+ *
+ * @return uint64_t Milliseconds on the wheel clock, or BT_TIMER_NONE if no timer is pending.
+ */
+uint64_t btTimerWheelNextWakeup(const BtTimerWheel *wheel)
+{
+    uint64_t earliest = BT_TIMER_NONE;
+    unsigned index = (unsigned)(wheel->current & (ROOT_SIZE - 1));
+
+    if (wheel->count == 0)
+        return BT_TIMER_NONE;
+
+    // 根层: 同一个槽里的定时器时间相同, 取循环顺序中第一个非空槽
+    for (unsigned step = 0; step < ROOT_SIZE; step++)
+    {
+        unsigned slot = (index + step) & (ROOT_SIZE - 1);
+        if (!(wheel->root_bits[slot / 64] & (1ull << (slot % 64))))
+            continue;
+        if (!slotEmpty(&wheel->root[slot]))
+        {
+            earliest = slotMinimum(&wheel->root[slot]);
+            break;
+        }
+    }
+
+    // 高层: 当前窗口的槽可能已级联过 (里面是一整圈之后的定时器),
+    // 所以取它和之后第一个非空槽两者的最小值
+    for (int level = 0; level < UPPER_LEVELS; level++)
+    {
+        unsigned start = (unsigned)((wheel->current >> levelShift(level)) & (LEVEL_SIZE - 1));
+        for (unsigned step = 0; step < LEVEL_SIZE; step++)
+        {
+            unsigned slot = (start + step) & (LEVEL_SIZE - 1);
+            if (!(wheel->level_bits[level] & (1ull << slot)) || slotEmpty(&wheel->levels[level][slot]))
+                continue;
+            uint64_t minimum = slotMinimum(&wheel->levels[level][slot]);
+            if (minimum < earliest)
+                earliest = minimum;
+            if (step > 0)
+                break;
+        }
+    }
+    return earliest;
+}
+
+uint32_t btTimerWheelCount(const BtTimerWheel *wheel)
+{
+    return wheel->count;
+}
@@ -0,0 +1,39 @@
+#ifndef BEHAVIOR_TREE_TIMER_H
+#define BEHAVIOR_TREE_TIMER_H
+
+#include <stdint.h>
+
+/**
+ * @brief Hierarchical timer wheel with millisecond resolution.
+ *
+ * Four levels (256 x 1 ms, 64 x 256 ms, 64 x 16 s, 64 x 17 min); later
+ * timers wait in the last level and are re-filed when it cascades.
+ * Scheduling and cancelling are O(1), and advancing the clock only touches
+ * occupied slots and level boundaries, so idle timers cost nothing.
+ *
+ * Timers are intrusive: the caller owns the BtTimer storage.
+ */
+typedef struct BtTimer
+{
+    struct BtTimer *next;
+    struct BtTimer *prev; // 未调度时为 NULL
+    uint64_t expires;
+    void (*callback)(struct BtTimer *timer, void *user);
+    void *user;
+} BtTimer;
+
+typedef struct BtTimerWheel BtTimerWheel;
+
+#define BT_TIMER_NONE UINT64_MAX
+
+BtTimerWheel *btTimerWheelCreate(uint64_t now_ms);
+void btTimerWheelDestroy(BtTimerWheel *wheel);
+void btTimerInit(BtTimer *timer, void (*callback)(BtTimer *timer, void *user), void *user);
+void btTimerSchedule(BtTimerWheel *wheel, BtTimer *timer, uint64_t expires_ms);
+void btTimerCancel(BtTimerWheel *wheel, BtTimer *timer);
+int btTimerPending(const BtTimer *timer);
+int btTimerWheelAdvance(BtTimerWheel *wheel, uint64_t now_ms);
+uint64_t btTimerWheelNextWakeup(const BtTimerWheel *wheel);
+uint32_t btTimerWheelCount(const BtTimerWheel *wheel);
+
+#endif // BEHAVIOR_TREE_TIMER_H
@@ -0,0 +1,292 @@
+#include "BehaviorTreeTrace.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define TRACE_BYTE_ORDER 0x01020304u
+#define TRACE_MASK (BT_TRACE_RING_SIZE - 1u)
+
+// 单生产者 (所属线程) 单消费者 (排空线程) 环形缓冲
+typedef struct TraceRing
+{
+    _Alignas(64) atomic_uint head; // 只由所属线程写
+    _Alignas(64) atomic_uint tail; // 只由排空线程写
+    atomic_uint dropped;
+    uint32_t thread;
+    struct TraceRing *next;
+    BtTraceEvent events[BT_TRACE_RING_SIZE];
+} TraceRing;
+
+atomic_int btTraceEnabled;
+
+// 环在进程内一直保留, 线程退出后剩余事件仍会被排空
+static _Atomic(TraceRing *) rings;
+static atomic_uint threadCount;
+static _Thread_local TraceRing *localRing;
+
+static pthread_mutex_t drainLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t drainCond = PTHREAD_COND_INITIALIZER;
+static pthread_t drainThread;
+static FILE *traceFile;
+static uint32_t flushInterval;
+static int running;
+static int stopping;
+static int writeFailed;
+
+static inline uint64_t nowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static TraceRing *createRing(void)
+{
+    size_t size = (sizeof(TraceRing) + 63u) & ~(size_t)63u;
+    TraceRing *ring = aligned_alloc(64, size);
+    if (!ring)
+        return NULL;
+    memset(ring, 0, sizeof(TraceRing));
+    ring->thread = atomic_fetch_add_explicit(&threadCount, 1, memory_order_relaxed);
+
+    TraceRing *first = atomic_load_explicit(&rings, memory_order_relaxed);
+    do
+    {
+        ring->next = first;
+    } while (!atomic_compare_exchange_weak_explicit(&rings, &first, ring, memory_order_release, memory_order_relaxed));
+    return ring;
+}
+
+/**
+ * @brief Appends an event to the calling thread's ring.
+ *
+ * Called through btTraceCreate/btTraceResult/btTraceFlatResult, which check
+ * btTraceEnabled.
+ */
+void btTraceRecord(uint64_t node, uint8_t kind, uint8_t node_type, uint8_t status)
+{
+    TraceRing *ring = localRing;
+    if (!ring)
+    {
+        ring = localRing = createRing();
+        if (!ring)
+            return;
+    }
+
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head - tail == BT_TRACE_RING_SIZE)
+    {
+        atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    BtTraceEvent *event = &ring->events[head & TRACE_MASK];
+    event->time_ns = nowNs();
+    event->node = node;
+    event->kind = kind;
+    event->status = status;
+    event->node_type = node_type;
+    memset(event->reserved, 0, sizeof(event->reserved));
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+// 把每个环中已有的事件写成一个块
+static void drainRings(void)
+{
+    for (TraceRing *ring = atomic_load_explicit(&rings, memory_order_acquire); ring; ring = ring->next)
+    {
+        uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        uint32_t dropped = atomic_exchange_explicit(&ring->dropped, 0, memory_order_relaxed);
+
+        if (head == tail && dropped == 0)
+            continue;
+
+        BtTraceBlockHeader block = {ring->thread, head - tail, dropped, 0};
+        uint32_t start = tail & TRACE_MASK;
+        uint32_t first = block.count < BT_TRACE_RING_SIZE - start ? block.count : BT_TRACE_RING_SIZE - start;
+
+        if (fwrite(&block, sizeof(block), 1, traceFile) != 1 ||
+            fwrite(&ring->events[start], sizeof(BtTraceEvent), first, traceFile) != first ||
+            fwrite(&ring->events[0], sizeof(BtTraceEvent), block.count - first, traceFile) != block.count - first)
+        {
+            writeFailed = 1;
+        }
+        atomic_store_explicit(&ring->tail, head, memory_order_release);
+    }
+}
+
+static void *drainMain(void *arg)
+{
+    (void)arg;
+    pthread_mutex_lock(&drainLock);
+    while (!stopping)
+    {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += flushInterval / 1000u;
+        deadline.tv_nsec += (long)(flushInterval % 1000u) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L)
+        {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&drainCond, &drainLock, &deadline);
+        drainRings();
+    }
+    pthread_mutex_unlock(&drainLock);
+    return NULL;
+}
+
+/**
+ * @brief Starts recording events into a trace file.
+ *
+ * @param path              File to create.
+ * @param flush_interval_ms How often the drainer thread empties the rings;
+ *                          a ring must not receive more than
+ *                          BT_TRACE_RING_SIZE events in that time or events
+ *                          are dropped. 0 selects 10 ms.
+ * @return int 1 on success, 0 if tracing already runs or the file or thread could not be created.
+ */
+int btTraceStart(const char *path, uint32_t flush_interval_ms)
+{
+    pthread_mutex_lock(&drainLock);
+    if (running)
+    {
+        pthread_mutex_unlock(&drainLock);
+        return 0;
+    }
+
+    traceFile = fopen(path, "wb");
+    if (!traceFile)
+    {
+        pthread_mutex_unlock(&drainLock);
+        return 0;
+    }
+
+    // 丢弃上一次追踪停止后残留的事件
+    for (TraceRing *ring = atomic_load_explicit(&rings, memory_order_acquire); ring; ring = ring->next)
+    {
+        atomic_store_explicit(&ring->tail, atomic_load_explicit(&ring->head, memory_order_acquire), memory_order_release);
+        atomic_store_explicit(&ring->dropped, 0, memory_order_relaxed);
+    }
+
+    BtTraceFileHeader header = {0};
+    header.magic = BT_TRACE_MAGIC;
+    header.version = BT_TRACE_VERSION;
+    header.event_size = sizeof(BtTraceEvent);
+    header.byte_order = TRACE_BYTE_ORDER;
+    header.start_ns = nowNs();
+
+    flushInterval = flush_interval_ms ? flush_interval_ms : 10u;
+    stopping = 0;
+    writeFailed = fwrite(&header, sizeof(header), 1, traceFile) != 1;
+    if (writeFailed || pthread_create(&drainThread, NULL, drainMain, NULL) != 0)
+    {
+        fclose(traceFile);
+        traceFile = NULL;
+        pthread_mutex_unlock(&drainLock);
+        return 0;
+    }
+    running = 1;
+    atomic_store_explicit(&btTraceEnabled, 1, memory_order_relaxed);
+    pthread_mutex_unlock(&drainLock);
+    return 1;
+}
+
+/**
+ * @brief Stops recording, writes the remaining events and closes the file.
+ *
+ * Events recorded by threads that are still running trees while this is
+ * called may be lost.
+ *
+ * @return int 1 if the whole trace was written, 0 if tracing was not running or a write failed.
+ */
+int btTraceStop(void)
+{
+    pthread_mutex_lock(&drainLock);
+    if (!running)
+    {
+        pthread_mutex_unlock(&drainLock);
+        return 0;
+    }
+    atomic_store_explicit(&btTraceEnabled, 0, memory_order_relaxed);
+    stopping = 1;
+    pthread_cond_signal(&drainCond);
+    pthread_mutex_unlock(&drainLock);
+    pthread_join(drainThread, NULL);
+
+    pthread_mutex_lock(&drainLock);
+    drainRings();
+    int ok = !writeFailed;
+    if (fclose(traceFile) != 0)
+        ok = 0;
+    traceFile = NULL;
+    running = 0;
+    pthread_mutex_unlock(&drainLock);
+    return ok;
+}
+
+static const char *typeName(uint8_t type)
+{
+    static const char *const names[] = {"action", "condition", "sequence", "selector",
+                                        "parallel", "decorator", "memory", "utility"};
+    return type < sizeof(names) / sizeof(names[0]) ? names[type] : "unknown";
+}
+
+static const char *statusName(uint8_t status)
+{
+    static const char *const names[] = {"failure", "success", "running", "idle"};
+    return status < sizeof(names) / sizeof(names[0]) ? names[status] : "unknown";
+}
+
+/**
+ * @brief Converts a trace file to text, one event per line:
+ *
+ *     <ms since start> thread <n> result node <address> <type> <status>
+ *     <ms since start> thread <n> result flat <index> <type> <status>
+ *     <ms since start> thread <n> create node <address> <type>
+ *     thread <n> dropped <count>
+ *
+ * Events of different threads are not merged; each drained block is printed
+ * in order.
+ *
+ * @return int 1 on success, 0 if the file is not a valid trace.
+ */
+int btTraceDecode(FILE *in, FILE *out)
+{
+    BtTraceFileHeader header;
+    BtTraceBlockHeader block;
+    BtTraceEvent event;
+
+    if (fread(&header, sizeof(header), 1, in) != 1 || header.magic != BT_TRACE_MAGIC ||
+        header.version != BT_TRACE_VERSION || header.byte_order != TRACE_BYTE_ORDER ||
+        header.event_size != sizeof(BtTraceEvent))
+    {
+        return 0;
+    }
+
+    while (fread(&block, sizeof(block), 1, in) == 1)
+    {
+        if (block.dropped)
+            fprintf(out, "thread %u dropped %u\n", block.thread, block.dropped);
+        for (uint32_t i = 0; i < block.count; i++)
+        {
+            if (fread(&event, sizeof(event), 1, in) != 1)
+                return 0; // 文件被截断
+            double ms = (double)(int64_t)(event.time_ns - header.start_ns) / 1e6;
+            if (event.kind == BT_TRACE_FLAT_RESULT)
+                fprintf(out, "%.6f thread %u result flat %llu %s %s\n", ms, block.thread,
+                        (unsigned long long)event.node, typeName(event.node_type), statusName(event.status));
+            else if (event.kind == BT_TRACE_CREATE)
+                fprintf(out, "%.6f thread %u create node %016llx %s\n", ms, block.thread,
+                        (unsigned long long)event.node, typeName(event.node_type));
+            else
+                fprintf(out, "%.6f thread %u result node %016llx %s %s\n", ms, block.thread,
+                        (unsigned long long)event.node, typeName(event.node_type), statusName(event.status));
+        }
+    }
+    return !ferror(in);
+}
@@ -0,0 +1,99 @@
+#ifndef BEHAVIOR_TREE_TRACE_H
+#define BEHAVIOR_TREE_TRACE_H
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include "BehaviorTree.h"
+
+/*
+ * Binary execution trace of the pointer engines (executeNode, tickTree) and
+ * of the flat engines (executeFlat, tickInstance, tickBatch).
+ *
+ * Every thread that records an event gets its own ring of BT_TRACE_RING_SIZE
+ * events. The thread is the only writer and a drainer thread started by
+ * btTraceStart the only reader, so recording is a relaxed load of the tail,
+ * one 24-byte store and a release store of the head: no lock, no stdio. When
+ * a ring is full new events are dropped and counted, the traced thread never
+ * waits. While tracing is off recording costs one relaxed load.
+ *
+ * File layout, all integers in host byte order:
+ *
+ *     BtTraceFileHeader
+ *     { BtTraceBlockHeader, BtTraceEvent[count] } ...   // 每次排空一个块
+ *
+ * btTraceDecode (tool: bt_trace_decode) turns a file into text.
+ */
+#define BT_TRACE_MAGIC 0x52545442u // "BTTR"
+#define BT_TRACE_VERSION 2u // 2: node 扩展为 64 位
+#define BT_TRACE_RING_SIZE 4096u // 每个线程的事件数, 2 的幂
+
+// BtTraceEvent.kind
+enum
+{
+    BT_TRACE_CREATE = 1, // 节点被创建 (原来 createBehaviorNode 的 printf)
+    BT_TRACE_RESULT = 2, // 节点执行结束, status 为结果
+    BT_TRACE_FLAT_RESULT = 3 // 编译后的树中的节点执行结束, node 为先序下标
+};
+
+/**
+ * @brief One trace event.
+ *
+ * For pointer trees node holds the full node address, which tells the nodes
+ * apart on any host and matches the addresses of the create events. For compiled trees it is the pre-order index of the node in the
+ * BtFlatTree, the same in every instance and in a mapped file of the tree.
+ */
+typedef struct BtTraceEvent
+{
+    uint64_t time_ns;   // CLOCK_MONOTONIC
+    uint64_t node;
+    uint8_t kind;
+    uint8_t status;     // NodeStatus
+    uint8_t node_type;  // NodeType
+    uint8_t reserved[5];
+} BtTraceEvent;
+
+typedef struct BtTraceFileHeader
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t event_size;
+    uint32_t byte_order;
+    uint32_t reserved;
+    uint64_t start_ns; // btTraceStart 的时间, 解码时作为零点
+} BtTraceFileHeader;
+
+typedef struct BtTraceBlockHeader
+{
+    uint32_t thread;  // 线程编号, 按首次记录的顺序
+    uint32_t count;   // 后面的事件数
+    uint32_t dropped; // 上次排空以来因环满丢弃的事件数
+    uint32_t reserved;
+} BtTraceBlockHeader;
+
+int btTraceStart(const char *path, uint32_t flush_interval_ms);
+int btTraceStop(void);
+int btTraceDecode(FILE *in, FILE *out);
+
+// 引擎内部使用
+extern atomic_int btTraceEnabled;
+void btTraceRecord(uint64_t node, uint8_t kind, uint8_t node_type, uint8_t status);
+
+static inline void btTraceCreate(const BehaviorNode *node, NodeType type)
+{
+    if (atomic_load_explicit(&btTraceEnabled, memory_order_relaxed))
+        btTraceRecord((uint64_t)(uintptr_t)node, BT_TRACE_CREATE, (uint8_t)type, BT_IDLE);
+}
+
+static inline void btTraceResult(const BehaviorNode *node, NodeStatus status)
+{
+    if (atomic_load_explicit(&btTraceEnabled, memory_order_relaxed))
+        btTraceRecord((uint64_t)(uintptr_t)node, BT_TRACE_RESULT, (uint8_t)node->type, (uint8_t)status);
+}
+
+static inline void btTraceFlatResult(uint32_t index, uint8_t node_type, NodeStatus status)
+{
+    if (atomic_load_explicit(&btTraceEnabled, memory_order_relaxed))
+        btTraceRecord(index, BT_TRACE_FLAT_RESULT, node_type, (uint8_t)status);
+}
+
+#endif // BEHAVIOR_TREE_TRACE_H
@@ -0,0 +1,439 @@
+#include "BehaviorTreeUtility.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#include <immintrin.h>
+#define UTILITY_X86
+#endif
+
+#define UTILITY_LANES 8u          // 每行按 8 个选项对齐, 一个 AVX 寄存器
+#define UTILITY_ALIGN 32u
+#define UTILITY_STACK_INPUTS 64u  // btUtilityChoose 在栈上的缓冲区大小
+#define UTILITY_STACK_SCORES 1024u
+
+// weights 第 0 行是 bias, 第 k + 1 行是输入 k 的权重
+typedef void (*ScoreKernel)(const float *weights, uint32_t stride, uint32_t input_count,
+                            const float *inputs, float *scores);
+
+struct BtUtility
+{
+    uint32_t option_count;
+    uint32_t input_count;
+    uint32_t stride; // 每行的浮点数个数
+    float *weights;  // (input_count + 1) * stride, 32 字节对齐
+    BbKey *keys;     // 每个输入的黑板键
+    BtUtilityInputs inputs;
+    void *user;
+    ScoreKernel score;
+};
+
+#ifndef UTILITY_X86
+static void scoreScalar(const float *weights, uint32_t stride, uint32_t input_count,
+                        const float *inputs, float *scores)
+{
+    memcpy(scores, weights, sizeof(float) * stride);
+    for (uint32_t k = 0; k < input_count; k++)
+    {
+        const float *row = weights + (size_t)(k + 1) * stride;
+        float input = inputs[k];
+        for (uint32_t o = 0; o < stride; o++)
+            scores[o] += row[o] * input;
+    }
+}
+#else
+static void scoreSse2(const float *weights, uint32_t stride, uint32_t input_count,
+                      const float *inputs, float *scores)
+{
+    for (uint32_t o = 0; o < stride; o += 8)
+    {
+        __m128 a = _mm_load_ps(weights + o);
+        __m128 b = _mm_load_ps(weights + o + 4);
+        for (uint32_t k = 0; k < input_count; k++)
+        {
+            const float *row = weights + (size_t)(k + 1) * stride + o;
+            __m128 input = _mm_set1_ps(inputs[k]);
+            a = _mm_add_ps(a, _mm_mul_ps(_mm_load_ps(row), input));
+            b = _mm_add_ps(b, _mm_mul_ps(_mm_load_ps(row + 4), input));
+        }
+        _mm_storeu_ps(scores + o, a);
+        _mm_storeu_ps(scores + o + 4, b);
+    }
+}
+
+// 一次 32 个选项, 四个累加器掩盖加法延迟; 不用 FMA, 与标量版本的舍入一致
+__attribute__((target("avx"))) static void scoreAvx(const float *weights, uint32_t stride, uint32_t input_count,
+                                                    const float *inputs, float *scores)
+{
+    uint32_t o = 0;
+
+    for (; o + 32 <= stride; o += 32)
+    {
+        __m256 a = _mm256_load_ps(weights + o);
+        __m256 b = _mm256_load_ps(weights + o + 8);
+        __m256 c = _mm256_load_ps(weights + o + 16);
+        __m256 d = _mm256_load_ps(weights + o + 24);
+        for (uint32_t k = 0; k < input_count; k++)
+        {
+            const float *row = weights + (size_t)(k + 1) * stride + o;
+            __m256 input = _mm256_set1_ps(inputs[k]);
+            a = _mm256_add_ps(a, _mm256_mul_ps(_mm256_load_ps(row), input));
+            b = _mm256_add_ps(b, _mm256_mul_ps(_mm256_load_ps(row + 8), input));
+            c = _mm256_add_ps(c, _mm256_mul_ps(_mm256_load_ps(row + 16), input));
+            d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_load_ps(row + 24), input));
+        }
+        _mm256_storeu_ps(scores + o, a);
+        _mm256_storeu_ps(scores + o + 8, b);
+        _mm256_storeu_ps(scores + o + 16, c);
+        _mm256_storeu_ps(scores + o + 24, d);
+    }
+    for (; o < stride; o += 8)
+    {
+        __m256 a = _mm256_load_ps(weights + o);
+        for (uint32_t k = 0; k < input_count; k++)
+        {
+            const float *row = weights + (size_t)(k + 1) * stride + o;
+            a = _mm256_add_ps(a, _mm256_mul_ps(_mm256_load_ps(row), _mm256_set1_ps(inputs[k])));
+        }
+        _mm256_storeu_ps(scores + o, a);
+    }
+}
+
+// 最大值; NaN 被 max 忽略, 因为累加器在第二个操作数
+static float maxSse2(const float *scores, uint32_t count)
+{
+    __m128 m = _mm_set1_ps(-INFINITY);
+    uint32_t i = 0;
+
+    for (; i + 4 <= count; i += 4)
+        m = _mm_max_ps(_mm_loadu_ps(scores + i), m);
+    m = _mm_max_ps(_mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 0, 3, 2)), m);
+    m = _mm_max_ps(_mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)), m);
+    float best = _mm_cvtss_f32(m);
+    for (; i < count; i++)
+        best = scores[i] > best ? scores[i] : best;
+    return best;
+}
+
+__attribute__((target("avx"))) static float maxAvx(const float *scores, uint32_t count)
+{
+    __m256 a = _mm256_set1_ps(-INFINITY), b = a;
+    uint32_t i = 0;
+
+    for (; i + 16 <= count; i += 16)
+    {
+        a = _mm256_max_ps(_mm256_loadu_ps(scores + i), a);
+        b = _mm256_max_ps(_mm256_loadu_ps(scores + i + 8), b);
+    }
+    a = _mm256_max_ps(a, b);
+    __m128 m = _mm_max_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+    m = _mm_max_ps(_mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 0, 3, 2)), m);
+    m = _mm_max_ps(_mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)), m);
+    float best = _mm_cvtss_f32(m);
+    for (; i < count; i++)
+        best = scores[i] > best ? scores[i] : best;
+    return best;
+}
+#endif
+
+static float maxScore(const float *scores, uint32_t count)
+{
+#ifdef UTILITY_X86
+    if (__builtin_cpu_supports("avx"))
+        return maxAvx(scores, count);
+    return maxSse2(scores, count);
+#else
+    float best = -INFINITY;
+    for (uint32_t i = 0; i < count; i++)
+        best = scores[i] > best ? scores[i] : best;
+    return best;
+#endif
+}
+
+static ScoreKernel pickKernel(const char **name)
+{
+#ifdef UTILITY_X86
+    if (__builtin_cpu_supports("avx"))
+    {
+        *name = "avx";
+        return scoreAvx;
+    }
+    *name = "sse2";
+    return scoreSse2;
+#else
+    *name = "scalar";
+    return scoreScalar;
+#endif
+}
+
+/**
+ * @brief Returns the scoring kernel used on this CPU: "avx", "sse2" or "scalar".
+ */
+const char *btUtilityKernelName(void)
+{
+    const char *name;
+    pickKernel(&name);
+    return name;
+}
+
+/**
+ * @brief Creates a scoring table with all weights and biases 0.
+ *
+ * @param option_count Number of options, the child count of the utility node.
+ * @param input_count  Number of inputs, may be 0 (scores are then the biases).
+ * @return BtUtility* The table, or NULL if a count is 0 or memory ran out.
+ */
+BtUtility *btUtilityCreate(uint32_t option_count, uint32_t input_count)
+{
+    const char *kernel;
+
+    if (option_count == 0 || option_count > UINT32_MAX - UTILITY_LANES || input_count > UINT32_MAX - 1)
+        return NULL;
+
+    BtUtility *table = malloc(sizeof(BtUtility));
+    if (!table)
+        return NULL;
+    table->option_count = option_count;
+    table->input_count = input_count;
+    table->stride = (option_count + UTILITY_LANES - 1) & ~(UTILITY_LANES - 1);
+    table->inputs = NULL;
+    table->user = NULL;
+    table->score = pickKernel(&kernel);
+
+    // stride 是 8 的倍数, 大小自然是 32 的倍数
+    size_t size = sizeof(float) * table->stride * ((size_t)input_count + 1);
+    table->weights = aligned_alloc(UTILITY_ALIGN, size);
+    table->keys = malloc(sizeof(BbKey) * (input_count ? input_count : 1));
+    if (!table->weights || !table->keys)
+    {
+        btUtilityDestroy(table);
+        return NULL;
+    }
+    memset(table->weights, 0, size);
+    for (uint32_t k = 0; k < input_count; k++)
+        table->keys[k] = BB_INVALID_KEY;
+    return table;
+}
+
+/**
+ * @brief Destroys a table. Nodes that use it must not be ticked afterwards.
+ */
+void btUtilityDestroy(BtUtility *table)
+{
+    if (!table)
+        return;
+    free(table->weights);
+    free(table->keys);
+    free(table);
+}
+
+uint32_t btUtilityOptionCount(const BtUtility *table)
+{
+    return table->option_count;
+}
+
+uint32_t btUtilityInputCount(const BtUtility *table)
+{
+    return table->input_count;
+}
+
+/**
+ * @brief Returns the row length of btUtilityScoreBatch's score array, a
+ * multiple of 8 that is at least the option count.
+ */
+uint32_t btUtilityStride(const BtUtility *table)
+{
+    return table->stride;
+}
+
+/**
+ * @brief Sets how much an input adds to the score of an option per unit.
+ *
+ * @return int 1 on success, 0 if option or input is out of range.
+ */
+int btUtilitySetWeight(BtUtility *table, uint32_t option, uint32_t input, float weight)
+{
+    if (option >= table->option_count || input >= table->input_count)
+        return 0;
+    table->weights[(size_t)(input + 1) * table->stride + option] = weight;
+    return 1;
+}
+
+/**
+ * @brief Sets the constant part of an option's score.
+ *
+ * @return int 1 on success, 0 if option is out of range.
+ */
+int btUtilitySetBias(BtUtility *table, uint32_t option, float bias)
+{
+    if (option >= table->option_count)
+        return 0;
+    table->weights[option] = bias;
+    return 1;
+}
+
+/**
+ * @brief Reads an input from the agent's blackboard.
+ *
+ * key must be a BB_TYPE_FLOAT key. Inputs without a key, and all inputs of
+ * an agent without a blackboard, are 0.
+ *
+ * @return int 1 on success, 0 if input is out of range.
+ */
+int btUtilitySetInputKey(BtUtility *table, uint32_t input, BbKey key)
+{
+    if (input >= table->input_count)
+        return 0;
+    table->keys[input] = key;
+    return 1;
+}
+
+/**
+ * @brief Fills the inputs with a callback instead of blackboard keys.
+ *
+ * @param inputs Called with room for input_count floats; NULL to go back to the keys.
+ */
+void btUtilitySetInputs(BtUtility *table, BtUtilityInputs inputs, void *user)
+{
+    table->inputs = inputs;
+    table->user = user;
+}
+
+/**
+ * @brief Scores every option for one set of inputs.
+ *
+ * @param inputs input_count values.
+ * @param scores Room for btUtilityStride(table) floats; entries past the
+ *               option count are padding.
+ */
+void btUtilityScore(const BtUtility *table, const float *inputs, float *scores)
+{
+    table->score(table->weights, table->stride, table->input_count, inputs, scores);
+}
+
+/**
+ * @brief Scores the options for many agents at once.
+ *
+ * The weight rows stay in cache for the whole batch.
+ *
+ * @param inputs agent_count rows of input_count values.
+ * @param scores agent_count rows of btUtilityStride(table) floats.
+ */
+void btUtilityScoreBatch(const BtUtility *table, const float *inputs, uint32_t agent_count, float *scores)
+{
+    for (uint32_t i = 0; i < agent_count; i++)
+    {
+        table->score(table->weights, table->stride, table->input_count,
+              inputs + (size_t)i * table->input_count, scores + (size_t)i * table->stride);
+    }
+}
+
+/**
+ * @brief Returns the index of the highest score, the first one on ties.
+ *
+ * The maximum is found with the SIMD kernel, then its first occurrence.
+ * NaN scores are never chosen; 0 is returned if every score is NaN.
+ */
+uint32_t btUtilityArgmax(const float *scores, uint32_t count)
+{
+    float best = maxScore(scores, count);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (scores[i] == best)
+            return i;
+    }
+    return 0;
+}
+
+// xorshift32, 状态不能为 0
+static uint32_t nextRandom(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static uint32_t pickWeighted(const float *scores, uint32_t count, uint32_t *rng, BtContext *ctx)
+{
+    float total = 0.0f;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (scores[i] > 0.0f)
+            total += scores[i];
+    }
+    if (!(total > 0.0f))
+        return btUtilityArgmax(scores, count);
+
+    if (*rng == 0)
+    {
+        // 每个 agent 的序列不同, 但可以复现
+        uint32_t seed = (uint32_t)(uintptr_t)(ctx ? ctx->agent : NULL) * 0x9E3779B1u;
+        *rng = seed ? seed : 0x2545F491u;
+    }
+    float target = (float)(nextRandom(rng) >> 8) * (1.0f / 16777216.0f) * total;
+    uint32_t last = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (!(scores[i] > 0.0f))
+            continue;
+        if (target < scores[i])
+            return i;
+        target -= scores[i];
+        last = i;
+    }
+    return last; // 舍入误差
+}
+
+/**
+ * @brief Gathers the agent's inputs, scores the options and picks one.
+ *
+ * @param rng xorshift state of the node, 0 seeds it from the agent pointer.
+ * @return uint32_t The chosen option, 0 if scratch memory ran out.
+ */
+uint32_t btUtilityChoose(const BtUtility *table, BtContext *ctx, BtUtilityMode mode, uint32_t *rng)
+{
+    _Alignas(UTILITY_ALIGN) float scoreBuffer[UTILITY_STACK_SCORES];
+    float inputBuffer[UTILITY_STACK_INPUTS];
+    float *scores = scoreBuffer, *inputs = inputBuffer;
+    uint32_t chosen = 0;
+
+    if (table->stride > UTILITY_STACK_SCORES)
+        scores = malloc(sizeof(float) * table->stride);
+    if (table->input_count > UTILITY_STACK_INPUTS)
+        inputs = malloc(sizeof(float) * table->input_count);
+    if (!scores || !inputs)
+        goto done;
+
+    if (table->inputs)
+    {
+        table->inputs(ctx, inputs, table->user);
+    }
+    else
+    {
+        const Blackboard *blackboard = ctx ? ctx->blackboard : NULL;
+        for (uint32_t k = 0; k < table->input_count; k++)
+        {
+            BbKey key = table->keys[k];
+            inputs[k] = blackboard && key < blackboard->slot_count ? (float)bbGetFloat(blackboard, key) : 0.0f;
+        }
+    }
+
+    table->score(table->weights, table->stride, table->input_count, inputs, scores);
+    if (mode == BT_UTILITY_WEIGHTED_RANDOM)
+        chosen = pickWeighted(scores, table->option_count, rng, ctx);
+    else
+        chosen = btUtilityArgmax(scores, table->option_count);
+
+done:
+    if (scores != scoreBuffer)
+        free(scores);
+    if (inputs != inputBuffer)
+        free(inputs);
+    return chosen;
+}
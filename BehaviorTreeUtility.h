@@ -0,0 +1,51 @@
+#ifndef BEHAVIOR_TREE_UTILITY_H
+#define BEHAVIOR_TREE_UTILITY_H
+
+#include "BehaviorTree.h"
+#include "Blackboard.h"
+
+/*
+ * Utility scoring for NODE_TYPE_UTILITY (see createUtilityNode).
+ *
+ * A table scores option_count options from input_count inputs with one
+ * linear function per option:
+ *
+ *     score[o] = bias[o] + sum_k weight[k][o] * input[k]
+ *
+ * The weights are stored input by input (struct of arrays, one row per
+ * input, rows padded to a multiple of 8 options and 32-byte aligned), so
+ * scoring walks every row once and updates 8 options per AVX instruction
+ * (4 with SSE2, or one at a time with the scalar fallback). The kernel is
+ * picked once per process from the CPU features. Scoring hundreds of
+ * options with a few inputs takes well under a microsecond.
+ *
+ * The inputs of an agent are read from its blackboard (one BB_TYPE_FLOAT key
+ * per input, see btUtilitySetInputKey) or filled by a callback
+ * (btUtilitySetInputs). btUtilityScoreBatch scores many agents whose inputs
+ * were gathered beforehand.
+ */
+typedef struct BtUtility BtUtility;
+
+// 填写 input_count 个输入, 代替黑板键
+typedef void (*BtUtilityInputs)(BtContext *ctx, float *inputs, void *user);
+
+BtUtility *btUtilityCreate(uint32_t option_count, uint32_t input_count);
+void btUtilityDestroy(BtUtility *table);
+uint32_t btUtilityOptionCount(const BtUtility *table);
+uint32_t btUtilityInputCount(const BtUtility *table);
+uint32_t btUtilityStride(const BtUtility *table);
+const char *btUtilityKernelName(void);
+
+int btUtilitySetWeight(BtUtility *table, uint32_t option, uint32_t input, float weight);
+int btUtilitySetBias(BtUtility *table, uint32_t option, float bias);
+int btUtilitySetInputKey(BtUtility *table, uint32_t input, BbKey key);
+void btUtilitySetInputs(BtUtility *table, BtUtilityInputs inputs, void *user);
+
+void btUtilityScore(const BtUtility *table, const float *inputs, float *scores);
+void btUtilityScoreBatch(const BtUtility *table, const float *inputs, uint32_t agent_count, float *scores);
+uint32_t btUtilityArgmax(const float *scores, uint32_t count);
+
+// 引擎内部使用
+uint32_t btUtilityChoose(const BtUtility *table, BtContext *ctx, BtUtilityMode mode, uint32_t *rng);
+
+#endif // BEHAVIOR_TREE_UTILITY_H
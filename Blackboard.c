@@ -0,0 +1,250 @@
+#include "Blackboard.h"
+#include <stdlib.h>
+#include <string.h>
+
+struct BbSchema
+{
+    char **names;
+    uint8_t *types;
+    uint32_t count;
+    uint32_t capacity;
+    BbKey *table; // 名字 -> key 的开放寻址哈希表
+    uint32_t table_size; // 2 的幂
+};
+
+static uint32_t hashName(const char *name)
+{
+    uint32_t hash = 2166136261u; // FNV-1a
+    while (*name)
+    {
+        hash ^= (uint8_t)*name++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static int rebuildTable(BbSchema *schema, uint32_t tableSize)
+{
+    BbKey *table = malloc(tableSize * sizeof(BbKey));
+    if (!table)
+        return 0;
+    for (uint32_t i = 0; i < tableSize; i++)
+        table[i] = BB_INVALID_KEY;
+    for (BbKey key = 0; key < schema->count; key++)
+    {
+        uint32_t slot = hashName(schema->names[key]) & (tableSize - 1);
+        while (table[slot] != BB_INVALID_KEY)
+            slot = (slot + 1) & (tableSize - 1);
+        table[slot] = key;
+    }
+    free(schema->table);
+    schema->table = table;
+    schema->table_size = tableSize;
+    return 1;
+}
+
+/**
+ * @brief Creates an empty blackboard schema.
+ *
+ * @return BbSchema* The schema, or NULL if memory could not be allocated.
+ */
+BbSchema *bbSchemaCreate(void)
+{
+    BbSchema *schema = calloc(1, sizeof(BbSchema));
+    if (!schema)
+        return NULL;
+    if (!rebuildTable(schema, 16))
+    {
+        free(schema);
+        return NULL;
+    }
+    return schema;
+}
+
+/**
+ * @brief Frees a schema. Blackboards created from it must not be used afterwards.
+ */
+void bbSchemaDestroy(BbSchema *schema)
+{
+    if (!schema)
+        return;
+    for (uint32_t i = 0; i < schema->count; i++)
+        free(schema->names[i]);
+    free(schema->names);
+    free(schema->types);
+    free(schema->table);
+    free(schema);
+}
+
+/**
+ * @brief Looks up a key by name.
+ *
+ * @return BbKey The key, or BB_INVALID_KEY if the name was never interned.
+ */
+BbKey bbFindKey(const BbSchema *schema, const char *name)
+{
+    uint32_t slot = hashName(name) & (schema->table_size - 1);
+    while (schema->table[slot] != BB_INVALID_KEY)
+    {
+        BbKey key = schema->table[slot];
+        if (strcmp(schema->names[key], name) == 0)
+            return key;
+        slot = (slot + 1) & (schema->table_size - 1);
+    }
+    return BB_INVALID_KEY;
+}
+
+/**
+ * @brief Interns a key, or returns the existing one with the same name.
+ *
+ * Keys are numbered from 0 in interning order. All keys should be interned
+ * before the first blackboard is created from the schema, because a
+ * blackboard only has slots for the keys that existed at its creation.
+ *
+ * @return BbKey The key, or BB_INVALID_KEY if the name exists with another
+ *               type or memory could not be allocated.
+ */
+BbKey bbIntern(BbSchema *schema, const char *name, BbType type)
+{
+    BbKey key = bbFindKey(schema, name);
+    if (key != BB_INVALID_KEY)
+        return schema->types[key] == type ? key : BB_INVALID_KEY;
+
+    if (schema->count == schema->capacity)
+    {
+        uint32_t capacity = schema->capacity ? schema->capacity * 2 : 16;
+        char **names = realloc(schema->names, capacity * sizeof(char *));
+        if (!names)
+            return BB_INVALID_KEY;
+        schema->names = names;
+        uint8_t *types = realloc(schema->types, capacity);
+        if (!types)
+            return BB_INVALID_KEY;
+        schema->types = types;
+        schema->capacity = capacity;
+    }
+    if ((schema->count + 1) * 2 > schema->table_size &&
+        !rebuildTable(schema, schema->table_size * 2))
+        return BB_INVALID_KEY;
+
+    size_t length = strlen(name) + 1;
+    char *copy = malloc(length);
+    if (!copy)
+        return BB_INVALID_KEY;
+    memcpy(copy, name, length);
+
+    key = schema->count++;
+    schema->names[key] = copy;
+    schema->types[key] = (uint8_t)type;
+
+    uint32_t slot = hashName(name) & (schema->table_size - 1);
+    while (schema->table[slot] != BB_INVALID_KEY)
+        slot = (slot + 1) & (schema->table_size - 1);
+    schema->table[slot] = key;
+    return key;
+}
+
+const char *bbKeyName(const BbSchema *schema, BbKey key)
+{
+    return key < schema->count ? schema->names[key] : NULL;
+}
+
+BbType bbKeyType(const BbSchema *schema, BbKey key)
+{
+    return (BbType)schema->types[key];
+}
+
+uint32_t bbKeyCount(const BbSchema *schema)
+{
+    return schema->count;
+}
+
+/**
+ * @brief Returns the number of bytes a blackboard for this schema needs.
+ *
+ * Together with bbInit this lets callers place many blackboards in one
+ * array or arena.
+ */
+size_t bbSizeOf(const BbSchema *schema)
+{
+    return sizeof(Blackboard) + sizeof(BbValue) * schema->count;
+}
+
+/**
+ * @brief Initialises a blackboard in caller-provided memory of bbSizeOf bytes.
+ *
+ * All slots start as zero.
+ */
+Blackboard *bbInit(void *memory, const BbSchema *schema)
+{
+    Blackboard *blackboard = (Blackboard *)memory;
+    blackboard->schema = schema;
+    blackboard->listener = NULL;
+    blackboard->listener_user = NULL;
+    blackboard->slot_count = schema->count;
+    memset(blackboard->slots, 0, sizeof(BbValue) * schema->count);
+    return blackboard;
+}
+
+/**
+ * @brief Allocates and initialises a blackboard for one agent.
+ *
+ * @return Blackboard* The blackboard, or NULL if memory could not be allocated.
+ */
+Blackboard *bbCreate(const BbSchema *schema)
+{
+    void *memory = malloc(bbSizeOf(schema));
+    if (!memory)
+        return NULL;
+    return bbInit(memory, schema);
+}
+
+void bbDestroy(Blackboard *blackboard)
+{
+    free(blackboard);
+}
+
+/**
+ * @brief Installs the function called when a write changes a value.
+ *
+ * Writes that store the value already in the slot do not notify. Pass NULL
+ * to remove the listener.
+ */
+void bbSetListener(Blackboard *blackboard, BbListener listener, void *user)
+{
+    blackboard->listener = listener;
+    blackboard->listener_user = user;
+}
+
+static void storeValue(Blackboard *blackboard, BbKey key, BbValue value)
+{
+    BbValue *slot = &blackboard->slots[key];
+    if (memcmp(slot, &value, sizeof(BbValue)) == 0)
+        return; // 值未变化, 不通知
+    *slot = value;
+    if (blackboard->listener)
+        blackboard->listener(blackboard->listener_user, key);
+}
+
+void bbSetInt(Blackboard *blackboard, BbKey key, int64_t value)
+{
+    storeValue(blackboard, key, (BbValue){.i = value});
+}
+
+void bbSetFloat(Blackboard *blackboard, BbKey key, double value)
+{
+    storeValue(blackboard, key, (BbValue){.f = value});
+}
+
+void bbSetBool(Blackboard *blackboard, BbKey key, int value)
+{
+    storeValue(blackboard, key, (BbValue){.i = value != 0});
+}
+
+void bbSetPointer(Blackboard *blackboard, BbKey key, void *value)
+{
+    BbValue slot;
+    memset(&slot, 0, sizeof(slot)); // 32 位平台上补齐高位
+    slot.p = value;
+    storeValue(blackboard, key, slot);
+}
@@ -0,0 +1,90 @@
+#ifndef BLACKBOARD_H
+#define BLACKBOARD_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "BehaviorTree.h"
+
+/**
+ * @brief Blackboard: typed per-agent storage addressed by interned keys.
+ *
+ * Keys are interned once in a BbSchema (at start-up or when a tree is
+ * loaded) and are plain slot indices afterwards, so a read or write is a
+ * single indexed access. Every Blackboard created from a schema is one
+ * contiguous block of 8-byte slots.
+ *
+ * For compile-time keys, declare an enum and intern the names in the same
+ * order; bbIntern returns the enum value.
+ */
+typedef enum
+{
+    BB_TYPE_INT,
+    BB_TYPE_FLOAT,
+    BB_TYPE_BOOL,
+    BB_TYPE_POINTER
+} BbType;
+
+typedef uint32_t BbKey;
+#define BB_INVALID_KEY UINT32_MAX
+
+typedef union
+{
+    int64_t i;
+    double f;
+    void *p;
+} BbValue;
+
+typedef struct BbSchema BbSchema;
+
+// 键的值发生变化时调用
+typedef void (*BbListener)(void *user, BbKey key);
+
+struct Blackboard
+{
+    const BbSchema *schema;
+    BbListener listener;
+    void *listener_user;
+    uint32_t slot_count;
+    BbValue slots[]; // 与结构体连续存放
+};
+
+BbSchema *bbSchemaCreate(void);
+void bbSchemaDestroy(BbSchema *schema);
+BbKey bbIntern(BbSchema *schema, const char *name, BbType type);
+BbKey bbFindKey(const BbSchema *schema, const char *name);
+const char *bbKeyName(const BbSchema *schema, BbKey key);
+BbType bbKeyType(const BbSchema *schema, BbKey key);
+uint32_t bbKeyCount(const BbSchema *schema);
+
+size_t bbSizeOf(const BbSchema *schema);
+Blackboard *bbInit(void *memory, const BbSchema *schema);
+Blackboard *bbCreate(const BbSchema *schema);
+void bbDestroy(Blackboard *blackboard);
+
+void bbSetListener(Blackboard *blackboard, BbListener listener, void *user);
+void bbSetInt(Blackboard *blackboard, BbKey key, int64_t value);
+void bbSetFloat(Blackboard *blackboard, BbKey key, double value);
+void bbSetBool(Blackboard *blackboard, BbKey key, int value);
+void bbSetPointer(Blackboard *blackboard, BbKey key, void *value);
+
+static inline int64_t bbGetInt(const Blackboard *blackboard, BbKey key)
+{
+    return blackboard->slots[key].i;
+}
+
+static inline double bbGetFloat(const Blackboard *blackboard, BbKey key)
+{
+    return blackboard->slots[key].f;
+}
+
+static inline int bbGetBool(const Blackboard *blackboard, BbKey key)
+{
+    return blackboard->slots[key].i != 0;
+}
+
+static inline void *bbGetPointer(const Blackboard *blackboard, BbKey key)
+{
+    return blackboard->slots[key].p;
+}
+
+#endif // BLACKBOARD_H
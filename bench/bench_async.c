@@ -0,0 +1,145 @@
+/*
+ * Many agents share a flat tree whose middle leaf is an async "scan" that
+ * takes 2 ms (a timerfd stands in for a sensor read or a network request).
+ * Ticking all agents and polling the async loop keeps every scan in flight
+ * at once; running the same tree with executeFlat waits for each scan in
+ * turn. Results are printed on stderr:
+ *
+ *     ./bench_async [agents] [rounds]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+#include "BehaviorTree.h"
+#include "BehaviorTreeAsync.h"
+#include "BehaviorTreeFlat.h"
+
+#define SCAN_NS 2000000L
+
+typedef struct
+{
+    int timer; // 每个 agent 一个 timerfd, 反复使用
+    int scans;
+} Agent;
+
+static double nowSeconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static int checkAgent(BtContext *ctx)
+{
+    return ctx->agent != NULL;
+}
+
+static int reportScan(BtContext *ctx)
+{
+    ((Agent *)ctx->agent)->scans++;
+    return 1;
+}
+
+static NodeStatus scanReady(int fd, uint32_t events, void *user)
+{
+    uint64_t expirations;
+    (void)events;
+    (void)user;
+    return read(fd, &expirations, sizeof(expirations)) == sizeof(expirations) ? BT_SUCCESS : BT_FAILURE;
+}
+
+static BtAsyncHandle startScan(BtAsyncLoop *loop, BtContext *ctx, void *user)
+{
+    Agent *agent = ctx->agent;
+    struct itimerspec spec = {{0, 0}, {0, SCAN_NS}};
+    (void)user;
+
+    BtAsyncHandle handle = btAsyncBegin(loop);
+    if (handle == 0)
+        return 0;
+    if (timerfd_settime(agent->timer, 0, &spec, NULL) != 0 ||
+        !btAsyncWatchFd(loop, handle, agent->timer, EPOLLIN, scanReady, NULL))
+    {
+        btAsyncRelease(loop, handle);
+        return 0;
+    }
+    return handle;
+}
+
+int main(int argc, char **argv)
+{
+    int agents = argc > 1 ? atoi(argv[1]) : 500;
+    int rounds = argc > 2 ? atoi(argv[2]) : 20;
+
+    BtAsyncLoop *loop = btAsyncLoopCreate((uint32_t)agents);
+    if (!loop)
+    {
+        fprintf(stderr, "cannot create async loop\n");
+        return 1;
+    }
+    BtAsyncAction scan = {loop, startScan, NULL};
+
+    BehaviorNode *steps[3] = {
+        createContextNode(NODE_TYPE_CONDITION, checkAgent),
+        createAsyncNode(NODE_TYPE_ACTION, &scan),
+        createContextNode(NODE_TYPE_ACTION, reportScan),
+    };
+    BehaviorNode *root = createBehaviorNode(steps, 3, NODE_TYPE_SEQUENCE, NULL);
+    BtFlatTree *tree = btCompileTree(root);
+    BtInstance *instances = btCreateInstances(tree, agents);
+    Agent *state = calloc((size_t)agents, sizeof(Agent));
+    for (int i = 0; i < agents; i++)
+    {
+        state[i].timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        instances[i].context.agent = &state[i];
+    }
+
+    // 异步: 每轮所有 agent 的扫描同时进行, 之后只 tick 仍在运行的实例
+    int polls = 0;
+    double start = nowSeconds();
+    for (int r = 0; r < rounds; r++)
+    {
+        int running = tickBatch(tree, instances, agents);
+        while (running > 0)
+        {
+            btAsyncPoll(loop, -1);
+            polls++;
+            running = 0;
+            uint64_t now = btMonotonicMs();
+            for (int i = 0; i < agents; i++)
+            {
+                if (instances[i].status == BT_RUNNING)
+                    running += tickInstance(tree, &instances[i], now) == BT_RUNNING;
+            }
+        }
+    }
+    double async = (nowSeconds() - start) / rounds;
+
+    // 阻塞: executeFlat 逐个等待扫描, 只跑一轮
+    start = nowSeconds();
+    int failures = 0;
+    for (int i = 0; i < agents; i++)
+        failures += !executeFlat(tree, &instances[i].context);
+    double blocking = nowSeconds() - start;
+
+    int scans = 0;
+    for (int i = 0; i < agents; i++)
+        scans += state[i].scans;
+
+    fprintf(stderr, "agents %d, scan %.1f ms, %d scans, %d failures\n", agents, SCAN_NS / 1e6, scans, failures);
+    fprintf(stderr, "async:    %8.2f ms per round (%.1f polls per round)\n", async * 1e3, (double)polls / rounds);
+    fprintf(stderr, "blocking: %8.2f ms per round\n", blocking * 1e3);
+    fprintf(stderr, "speedup:  %8.1fx\n", blocking / async);
+
+    for (int i = 0; i < agents; i++)
+        close(state[i].timer);
+    free(state);
+    btFreeInstances(instances);
+    btFreeFlatTree(tree);
+    freeBehaviorTree(root);
+    btAsyncLoopDestroy(loop);
+    return scans == agents * (rounds + 1) && failures == 0 ? 0 : 1;
+}
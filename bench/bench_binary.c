@@ -0,0 +1,269 @@
+/*
+ * Saves a compiled tree with btSaveTree, maps it back with btMapTree and
+ * checks that executeFlat on the mapped tree calls the actions in the same
+ * order and gives the same results as on the source tree. Reports the file
+ * size and how long compiling, saving and mapping (verified and trusted)
+ * take, then checks that btMapTree rejects copies of the file with an
+ * unknown node kind, an unknown decorator type or a bad cache index.
+ * Results are printed on stderr:
+ *
+ *     ./bench_binary [blocks] [path]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include "BehaviorTree.h"
+#include "BehaviorTreeBinary.h"
+#include "BehaviorTreeCache.h"
+#include "BehaviorTreeFlat.h"
+#include "BehaviorTreeRegistry.h"
+
+#define ITERATIONS 200
+
+static uint32_t calls;
+static uint64_t trail; // 调用顺序的指纹
+
+static double nowSeconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// 结果只取决于第几次调用, 两棵树得到相同的结果序列
+static int probe(BtContext *ctx)
+{
+    uint32_t hash = ++calls * 2654435761u;
+    (void)ctx;
+    trail = trail * 31 + calls;
+    return (hash >> 29) != 0;
+}
+
+static int scout(BtContext *ctx)
+{
+    (void)ctx;
+    trail = trail * 31 + 7;
+    return 1;
+}
+
+static BehaviorNode *decorate(BehaviorNode **children, int count, Decorator *decorator)
+{
+    BehaviorNode *node = createBehaviorNode(children, count, NODE_TYPE_DECORATOR, NULL);
+    node->decorator = decorator;
+    return node;
+}
+
+// cached 被所有块共享, 编译后每个副本都指向第一个副本的缓存条目
+static BehaviorNode *block(BehaviorNode *cached)
+{
+    BehaviorNode *inverted = createContextNode(NODE_TYPE_CONDITION, probe);
+    BehaviorNode *repeated = createContextNode(NODE_TYPE_ACTION, probe);
+    BehaviorNode *guard[3] = {
+        createContextNode(NODE_TYPE_CONDITION, probe),
+        decorate(&inverted, 1, createDecorator(DECORATOR_TYPE_INVERT, NULL)),
+        cached,
+    };
+    BehaviorNode *options[2] = {createContextNode(NODE_TYPE_ACTION, scout), createContextNode(NODE_TYPE_ACTION, probe)};
+    BehaviorNode *steps[3] = {
+        createBehaviorNode(guard, 3, NODE_TYPE_SEQUENCE, NULL),
+        decorate(&repeated, 1, createRepeatDecorator(2)),
+        createMemoryNode(options, 2, MEMORY_SELECTOR),
+    };
+    BehaviorNode *body[2] = {
+        createBehaviorNode(steps, 3, NODE_TYPE_SEQUENCE, NULL),
+        createContextNode(NODE_TYPE_ACTION, probe),
+    };
+    return createBehaviorNode(body, 2, NODE_TYPE_SELECTOR, NULL);
+}
+
+static BehaviorNode *build(int blocks)
+{
+    BehaviorNode *condition = createContextNode(NODE_TYPE_CONDITION, scout);
+    BehaviorNode *cached = decorate(&condition, 1, createCacheDecorator(BT_CACHE_PER_TICK));
+    BehaviorNode **children = malloc(sizeof(BehaviorNode *) * (size_t)blocks);
+    for (int i = 0; i < blocks; i++)
+        children[i] = block(cached);
+    // 失败阈值大于块数, parallel 不会提前结束, 每个块都执行
+    BehaviorNode *root = createParallelNode(children, blocks, 0, (uint32_t)blocks + 1);
+    free(children);
+    return root;
+}
+
+typedef struct
+{
+    uint64_t trail;
+    uint32_t calls;
+    uint32_t results;
+    double seconds;
+} Run;
+
+static Run run(const BtFlatTree *tree)
+{
+    Run result = {0, 0, 0, 0};
+
+    calls = 0;
+    trail = 0;
+    double start = nowSeconds();
+    for (int i = 0; i < ITERATIONS; i++)
+        result.results = result.results * 3 + (uint32_t)executeFlat(tree, NULL);
+    result.seconds = (nowSeconds() - start) / ITERATIONS;
+    result.trail = trail;
+    result.calls = calls;
+    return result;
+}
+
+static void *readFile(const char *path, size_t *size)
+{
+    FILE *file = fopen(path, "rb");
+    void *data = NULL;
+
+    if (!file)
+        return NULL;
+    if (fseek(file, 0, SEEK_END) == 0 && (*size = (size_t)ftell(file)) > 0 && fseek(file, 0, SEEK_SET) == 0 &&
+        (data = malloc(*size)) && fread(data, 1, *size, file) != *size)
+    {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    return data;
+}
+
+/**
+ * @brief Writes data to path with one byte (or word) replaced and maps it.
+ *
+ * @return int 1 if btMapTree rejects the damaged file.
+ */
+static int rejects(const char *path, const void *data, size_t size, size_t offset, const void *value,
+                   size_t length, const BtRegistry *registry)
+{
+    unsigned char *copy = malloc(size);
+    int ok = 0;
+
+    memcpy(copy, data, size);
+    memcpy(copy + offset, value, length);
+    FILE *file = fopen(path, "wb");
+    if (file && fwrite(copy, 1, size, file) == size && fclose(file) == 0)
+    {
+        BtMappedTree *mapped = btMapTree(path, registry, 0);
+        ok = mapped == NULL;
+        btUnmapTree(mapped);
+    }
+    free(copy);
+    return ok;
+}
+
+// 在文件的副本中逐一破坏 kind, dec_type 和缓存下标, 每个都必须被拒绝
+static int checkDamage(const char *path, const BtFlatTree *tree, const BtRegistry *registry)
+{
+    size_t size;
+    unsigned char *data = readFile(path, &size);
+    uint32_t n = tree->node_count, cache = n, decorator = n;
+    int failures = 0;
+
+    if (!data)
+    {
+        fprintf(stderr, "could not read %s\n", path);
+        return 1;
+    }
+    for (uint32_t i = n; i-- > 0;)
+    {
+        if (tree->kind[i] != NODE_TYPE_DECORATOR)
+            continue;
+        decorator = i;
+        if (tree->dec_type[i] == DECORATOR_TYPE_CACHE)
+            cache = i;
+    }
+
+    size_t actionOffset = sizeof(BtFileHeader) + 2 * (size_t)n * sizeof(uint32_t);
+    size_t kindOffset = actionOffset + ((size_t)n + tree->action_count) * sizeof(uint32_t);
+    size_t decTypeOffset = kindOffset + n;
+    uint8_t badKind = NODE_TYPE_UTILITY + 1, badType = DECORATOR_TYPE_CACHE + 1;
+    uint32_t badIndex = cache + 1;
+
+    if (!rejects(path, data, size, kindOffset + n - 1, &badKind, 1, registry))
+    {
+        fprintf(stderr, "unknown node kind accepted\n");
+        failures++;
+    }
+    if (decorator < n && !rejects(path, data, size, decTypeOffset + decorator, &badType, 1, registry))
+    {
+        fprintf(stderr, "unknown decorator type accepted\n");
+        failures++;
+    }
+    if (cache < n && !rejects(path, data, size, actionOffset + cache * sizeof(uint32_t), &badIndex,
+                              sizeof(badIndex), registry))
+    {
+        fprintf(stderr, "bad cache index accepted\n");
+        failures++;
+    }
+    fprintf(stderr, "damaged copies rejected: %s\n", failures == 0 ? "yes" : "no");
+    free(data);
+    return failures;
+}
+
+int main(int argc, char **argv)
+{
+    int blocks = argc > 1 ? atoi(argv[1]) : 5000;
+    const char *path = argc > 2 ? argv[2] : "bench_binary.btree";
+    BtRegistry *registry = btRegistryCreate();
+    int failures = 0;
+
+    btRegistryAddContext(registry, "probe", probe);
+    btRegistryAddContext(registry, "scout", scout);
+    BehaviorNode *root = build(blocks);
+
+    double start = nowSeconds();
+    BtFlatTree *tree = btCompileTree(root);
+    double compileSeconds = nowSeconds() - start;
+    start = nowSeconds();
+    int saved = tree && btSaveTree(tree, registry, path);
+    double saveSeconds = nowSeconds() - start;
+    if (!saved)
+    {
+        fprintf(stderr, "could not compile and save the tree to %s\n", path);
+        return 1;
+    }
+
+    start = nowSeconds();
+    BtMappedTree *mapped = btMapTree(path, registry, 0);
+    double mapSeconds = nowSeconds() - start;
+    start = nowSeconds();
+    BtMappedTree *trusted = btMapTree(path, registry, BT_MAP_TRUSTED);
+    double trustedSeconds = nowSeconds() - start;
+    if (!mapped || !trusted)
+    {
+        fprintf(stderr, "could not map %s\n", path);
+        return 1;
+    }
+
+    struct stat st;
+    stat(path, &st);
+    fprintf(stderr, "nodes:       %u\n", tree->node_count);
+    fprintf(stderr, "file:        %lld bytes\n", (long long)st.st_size);
+    fprintf(stderr, "compile:     %8.1f us\n", compileSeconds * 1e6);
+    fprintf(stderr, "save:        %8.1f us\n", saveSeconds * 1e6);
+    fprintf(stderr, "map:         %8.1f us\n", mapSeconds * 1e6);
+    fprintf(stderr, "map trusted: %8.1f us\n", trustedSeconds * 1e6);
+
+    Run reference = run(tree);
+    Run result = run(btMappedFlatTree(mapped));
+    if (result.trail != reference.trail || result.calls != reference.calls || result.results != reference.results)
+    {
+        fprintf(stderr, "mapped tree differs from the source tree\n");
+        failures++;
+    }
+    fprintf(stderr, "executeFlat: %8.1f us source, %8.1f us mapped\n", reference.seconds * 1e6, result.seconds * 1e6);
+
+    failures += checkDamage(path, tree, registry);
+
+    btUnmapTree(trusted);
+    btUnmapTree(mapped);
+    remove(path);
+    btFreeFlatTree(tree);
+    freeBehaviorTree(root);
+    btRegistryDestroy(registry);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,167 @@
+/*
+ * Builds a generated-style tree of many small blocks (sequences, selectors,
+ * a memory selector, a conditional, inverts and repeats), reports its memory
+ * as pointer nodes, as a BtFlatTree and as a BtCompactTree, then again after
+ * btDedupTree. executeNode, executeFlat and executeCompact must call the
+ * actions in the same order and give the same results. Results are printed
+ * on stderr:
+ *
+ *     ./bench_compact [blocks]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "BehaviorTree.h"
+#include "BehaviorTreeCompact.h"
+#include "BehaviorTreeDedup.h"
+#include "BehaviorTreeFlat.h"
+
+#define ITERATIONS 200
+
+enum
+{
+    ENGINE_NODE,
+    ENGINE_FLAT,
+    ENGINE_COMPACT
+};
+
+static uint32_t calls;
+static uint64_t trail; // 调用顺序的指纹
+
+static double nowSeconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// 结果只取决于第几次调用, 三种执行方式得到相同的结果序列
+static int probe(BtContext *ctx)
+{
+    uint32_t hash = ++calls * 2654435761u;
+    (void)ctx;
+    trail = trail * 31 + calls;
+    return (hash >> 29) != 0;
+}
+
+static BehaviorNode *leaf(NodeType type)
+{
+    return createContextNode(type, probe);
+}
+
+static BehaviorNode *decorate(BehaviorNode **children, int count, Decorator *decorator)
+{
+    BehaviorNode *node = createBehaviorNode(children, count, NODE_TYPE_DECORATOR, NULL);
+    node->decorator = decorator;
+    return node;
+}
+
+static BehaviorNode *block(void)
+{
+    BehaviorNode *inverted = leaf(NODE_TYPE_CONDITION);
+    BehaviorNode *repeated = leaf(NODE_TYPE_ACTION);
+    BehaviorNode *guard[2] = {
+        leaf(NODE_TYPE_CONDITION),
+        decorate(&inverted, 1, createDecorator(DECORATOR_TYPE_INVERT, NULL)),
+    };
+    BehaviorNode *branch[3] = {leaf(NODE_TYPE_CONDITION), leaf(NODE_TYPE_ACTION), leaf(NODE_TYPE_ACTION)};
+    BehaviorNode *options[3] = {leaf(NODE_TYPE_ACTION), leaf(NODE_TYPE_ACTION), leaf(NODE_TYPE_ACTION)};
+    BehaviorNode *steps[4] = {
+        createBehaviorNode(guard, 2, NODE_TYPE_SEQUENCE, NULL),
+        decorate(&repeated, 1, createRepeatDecorator(2)),
+        decorate(branch, 3, createDecorator(DECORATOR_TYPE_CONDITIONAL, NULL)),
+        createMemoryNode(options, 3, MEMORY_SELECTOR),
+    };
+    BehaviorNode *body[2] = {
+        createBehaviorNode(steps, 4, NODE_TYPE_SEQUENCE, NULL),
+        leaf(NODE_TYPE_ACTION),
+    };
+    return createBehaviorNode(body, 2, NODE_TYPE_SELECTOR, NULL);
+}
+
+static BehaviorNode *build(int blocks)
+{
+    BehaviorNode **children = malloc(sizeof(BehaviorNode *) * (size_t)blocks);
+    for (int i = 0; i < blocks; i++)
+        children[i] = block();
+    // 失败阈值大于块数, parallel 不会提前结束, 每个块都执行
+    BehaviorNode *root = createParallelNode(children, blocks, 0, (uint32_t)blocks + 1);
+    free(children);
+    return root;
+}
+
+typedef struct
+{
+    uint64_t trail;
+    uint32_t calls;
+    uint32_t results;
+    double seconds;
+} Run;
+
+static Run run(int engine, BehaviorNode *root, const BtFlatTree *flat, const BtCompactTree *compact)
+{
+    Run result = {0, 0, 0, 0};
+
+    calls = 0;
+    trail = 0;
+    double start = nowSeconds();
+    for (int i = 0; i < ITERATIONS; i++)
+    {
+        int status = engine == ENGINE_NODE ? executeNode(root)
+                     : engine == ENGINE_FLAT ? executeFlat(flat, NULL)
+                                             : executeCompact(compact, NULL);
+        result.results = result.results * 3 + (uint32_t)status;
+    }
+    result.seconds = (nowSeconds() - start) / ITERATIONS;
+    result.trail = trail;
+    result.calls = calls;
+    return result;
+}
+
+static int report(const char *label, BehaviorNode *root)
+{
+    const char *engines[3] = {"executeNode", "executeFlat", "executeCompact"};
+    BtFootprint footprint;
+    BtFlatTree *flat = btCompileTree(root);
+    BtCompactTree *compact = btCompactTree(root);
+    int mismatches = 0;
+
+    if (!flat || !compact || !btMeasureFootprint(root, &footprint))
+    {
+        fprintf(stderr, "%s: could not build the tree\n", label);
+        btFreeFlatTree(flat);
+        btFreeCompactTree(compact);
+        return 1;
+    }
+    fprintf(stderr, "%s:\n", label);
+    btPrintFootprint(&footprint, stderr);
+
+    Run reference = run(ENGINE_NODE, root, flat, compact);
+    for (int engine = ENGINE_NODE; engine <= ENGINE_COMPACT; engine++)
+    {
+        Run result = engine == ENGINE_NODE ? reference : run(engine, root, flat, compact);
+        if (result.trail != reference.trail || result.calls != reference.calls ||
+            result.results != reference.results)
+            mismatches++;
+        fprintf(stderr, "%-15s %8.1f us\n", engines[engine], result.seconds * 1e6);
+    }
+    fprintf(stderr, "%d mismatches\n\n", mismatches);
+
+    btFreeFlatTree(flat);
+    btFreeCompactTree(compact);
+    return mismatches;
+}
+
+int main(int argc, char **argv)
+{
+    int blocks = argc > 1 ? atoi(argv[1]) : 5000;
+    BehaviorNode *root = build(blocks);
+    int failures = report("tree", root);
+
+    BtDedupStats stats;
+    btDedupTree(root, 0, &stats);
+    failures += report("after btDedupTree", root);
+
+    freeBehaviorTree(root);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,95 @@
+/*
+ * Builds a generated-style tree that repeats the same patrol block many
+ * times, merges identical subtrees with btDedupTree and compares memory and
+ * executeNode speed before and after. Results are printed on stderr:
+ *
+ *     ./bench_dedup [blocks]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "BehaviorTree.h"
+#include "BehaviorTreeDedup.h"
+
+#define ITERATIONS 200
+
+static int succeed(void)
+{
+    return 1;
+}
+
+static int fail(void)
+{
+    return 0;
+}
+
+static double nowSeconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static BehaviorNode *decorate(BehaviorNode *child, Decorator *decorator)
+{
+    BehaviorNode *node = createBehaviorNode(&child, 1, NODE_TYPE_DECORATOR, NULL);
+    node->decorator = decorator;
+    return node;
+}
+
+// 巡逻块: 检查条件、移动、在失败时转向; 每个块都是单独构造的
+static BehaviorNode *patrolBlock(int variant)
+{
+    BehaviorNode *check[3] = {
+        createBehaviorNode(NULL, 0, NODE_TYPE_CONDITION, succeed),
+        decorate(createBehaviorNode(NULL, 0, NODE_TYPE_CONDITION, fail), createDecorator(DECORATOR_TYPE_INVERT, NULL)),
+        createBehaviorNode(NULL, 0, NODE_TYPE_ACTION, succeed),
+    };
+    BehaviorNode *steps[3] = {
+        createBehaviorNode(check, 3, NODE_TYPE_SEQUENCE, NULL),
+        decorate(createBehaviorNode(NULL, 0, NODE_TYPE_ACTION, succeed), createRepeatDecorator(2)),
+        createBehaviorNode(NULL, 0, NODE_TYPE_ACTION, variant % 4 == 0 ? fail : succeed),
+    };
+    return createBehaviorNode(steps, 3, NODE_TYPE_SEQUENCE, NULL);
+}
+
+static double timeTicks(BehaviorNode *root, int *result)
+{
+    double start = nowSeconds();
+    for (int i = 0; i < ITERATIONS; i++)
+        *result = executeNode(root);
+    return (nowSeconds() - start) / ITERATIONS;
+}
+
+int main(int argc, char **argv)
+{
+    int blocks = argc > 1 ? atoi(argv[1]) : 20000;
+    BehaviorNode **children = malloc(sizeof(BehaviorNode *) * (size_t)blocks);
+
+    for (int i = 0; i < blocks; i++)
+        children[i] = patrolBlock(i);
+    // parallel 保证每个块都执行
+    BehaviorNode *root = createParallelNode(children, blocks, 0, 0);
+    free(children);
+
+    int before, after;
+    double tree = timeTicks(root, &before);
+    BtDedupStats stats;
+    double start = nowSeconds();
+    btDedupTree(root, 0, &stats);
+    double dedup = nowSeconds() - start;
+    double dag = timeTicks(root, &after);
+
+    if (before != after)
+    {
+        fprintf(stderr, "result changed by btDedupTree\n");
+        return 1;
+    }
+    fprintf(stderr, "nodes:       %u -> %u\n", stats.nodes_before, stats.nodes_after);
+    fprintf(stderr, "bytes saved: %zu\n", stats.bytes_saved);
+    fprintf(stderr, "dedup time:  %.2f ms\n", dedup * 1e3);
+    fprintf(stderr, "tick:        %.1f us -> %.1f us\n", tree * 1e6, dag * 1e6);
+
+    freeBehaviorTree(root);
+    return 0;
+}
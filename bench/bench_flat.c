@@ -0,0 +1,111 @@
+/*
+ * Compares executeNode on the pointer tree with executeFlat on the compiled
+ * tree. Results are printed on stderr:
+ *
+ *     ./bench_flat
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "BehaviorTree.h"
+#include "BehaviorTreeFlat.h"
+
+static int succeed(void)
+{
+    return 1;
+}
+
+static int fail(void)
+{
+    return 0;
+}
+
+static double nowSeconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Builds a tree of about nodeCount nodes that is visited completely.
+ *
+ * Leaves alternate between a succeeding action and an inverted failing one,
+ * and are grouped four at a time into sequences, so every sequence runs all
+ * of its children.
+ */
+static BehaviorNode *buildTree(int nodeCount, int *built)
+{
+    int leaves = (int)(nodeCount / 1.83);
+    BehaviorNode **level = malloc(sizeof(BehaviorNode *) * leaves);
+    int count = 0;
+
+    for (int i = 0; i < leaves; i++)
+    {
+        if (i % 2 == 0)
+        {
+            level[i] = createBehaviorNode(NULL, 0, NODE_TYPE_ACTION, succeed);
+            count++;
+        }
+        else
+        {
+            BehaviorNode *leaf = createBehaviorNode(NULL, 0, NODE_TYPE_ACTION, fail);
+            level[i] = createBehaviorNode(&leaf, 1, NODE_TYPE_DECORATOR, NULL);
+            level[i]->decorator = createDecorator(DECORATOR_TYPE_INVERT, NULL);
+            count += 2;
+        }
+    }
+
+    int width = leaves;
+    while (width > 1)
+    {
+        int parents = 0;
+        for (int i = 0; i < width; i += 4)
+        {
+            int n = width - i < 4 ? width - i : 4;
+            level[parents++] = createBehaviorNode(&level[i], n, NODE_TYPE_SEQUENCE, NULL);
+            count++;
+        }
+        width = parents;
+    }
+
+    BehaviorNode *root = level[0];
+    free(level);
+    *built = count;
+    return root;
+}
+
+int main(void)
+{
+    static const int sizes[] = {10000, 100000, 1000000};
+
+    fprintf(stderr, "%10s %14s %14s %10s\n", "nodes", "pointer ns/node", "flat ns/node", "speedup");
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+        int nodes;
+        BehaviorNode *root = buildTree(sizes[s], &nodes);
+        BtFlatTree *flat = btCompileTree(root);
+        int iterations = 20000000 / nodes + 1;
+
+        if (executeNode(root) != executeFlat(flat, NULL))
+        {
+            fprintf(stderr, "result mismatch at %d nodes\n", nodes);
+            return 1;
+        }
+
+        double start = nowSeconds();
+        for (int i = 0; i < iterations; i++)
+            executeNode(root);
+        double pointer = (nowSeconds() - start) / iterations / nodes * 1e9;
+
+        start = nowSeconds();
+        for (int i = 0; i < iterations; i++)
+            executeFlat(flat, NULL);
+        double compiled = (nowSeconds() - start) / iterations / nodes * 1e9;
+
+        fprintf(stderr, "%10d %14.2f %14.2f %9.2fx\n", nodes, pointer, compiled, pointer / compiled);
+        btFreeFlatTree(flat);
+        freeBehaviorTree(root);
+    }
+    return 0;
+}
@@ -0,0 +1,157 @@
+/*
+ * Builds a tree the way export tools tend to write it (sequences wrapped in
+ * sequences, double inverts, repeat(1), one-child selectors, a fallback
+ * behind a repeat-until-success), optimizes a copy with btOptimizeTree and
+ * runs both with executeNode and tickTree. Both copies must call the actions
+ * in the same order and give the same results. Results are printed on
+ * stderr:
+ *
+ *     ./bench_optimize [blocks]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "BehaviorTree.h"
+#include "BehaviorTreeOptimize.h"
+
+#define ITERATIONS 200
+
+static uint32_t calls;
+static uint64_t trail; // 调用顺序的指纹
+static int ticking;
+
+static double nowSeconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// 结果只取决于第几次调用, 两棵等价的树得到相同的结果序列
+static int probe(BtContext *ctx)
+{
+    uint32_t hash = ++calls * 2654435761u;
+    (void)ctx;
+    trail = trail * 31 + calls;
+    if (ticking && (hash >> 28) == 0)
+        return BT_RUNNING;
+    return (hash >> 29) != 0;
+}
+
+static BehaviorNode *leaf(NodeType type)
+{
+    return createContextNode(type, probe);
+}
+
+static BehaviorNode *decorate(BehaviorNode *child, Decorator *decorator)
+{
+    BehaviorNode *node = createBehaviorNode(&child, 1, NODE_TYPE_DECORATOR, NULL);
+    node->decorator = decorator;
+    return node;
+}
+
+static BehaviorNode *composite(NodeType type, BehaviorNode **children, int count)
+{
+    return createBehaviorNode(children, count, type, NULL);
+}
+
+static BehaviorNode *invert(BehaviorNode *child)
+{
+    return decorate(child, createDecorator(DECORATOR_TYPE_INVERT, NULL));
+}
+
+static BehaviorNode *block(void)
+{
+    BehaviorNode *guard[2] = {leaf(NODE_TYPE_CONDITION), invert(invert(leaf(NODE_TYPE_CONDITION)))};
+    BehaviorNode *choice[2] = {decorate(leaf(NODE_TYPE_ACTION), createRepeatDecorator(1)), leaf(NODE_TYPE_ACTION)};
+    BehaviorNode *inner = composite(NODE_TYPE_SELECTOR, choice, 2);
+    BehaviorNode *single = leaf(NODE_TYPE_ACTION);
+    uint32_t unused = 0;
+    BehaviorNode *fallback[3] = {
+        leaf(NODE_TYPE_ACTION),
+        decorate(leaf(NODE_TYPE_ACTION), createDecorator(DECORATOR_TYPE_REPEAT_UNTIL_SUCCESS, &unused)),
+        leaf(NODE_TYPE_ACTION), // 不可达
+    };
+    BehaviorNode *steps[5] = {
+        composite(NODE_TYPE_SEQUENCE, guard, 2),
+        composite(NODE_TYPE_SELECTOR, &inner, 1),
+        composite(NODE_TYPE_SEQUENCE, &single, 1),
+        decorate(leaf(NODE_TYPE_ACTION), createRepeatDecorator(2)),
+        composite(NODE_TYPE_SELECTOR, fallback, 3),
+    };
+    BehaviorNode *body = composite(NODE_TYPE_SEQUENCE, steps, 5);
+    return composite(NODE_TYPE_SEQUENCE, &body, 1);
+}
+
+static BehaviorNode *build(int blocks)
+{
+    BehaviorNode **children = malloc(sizeof(BehaviorNode *) * (size_t)blocks);
+    for (int i = 0; i < blocks; i++)
+        children[i] = block();
+    // 失败阈值大于块数, parallel 不会提前结束, 每个块都执行
+    BehaviorNode *root = createParallelNode(children, blocks, 0, (uint32_t)blocks + 1);
+    free(children);
+    return root;
+}
+
+typedef struct
+{
+    uint64_t trail;
+    uint32_t calls;
+    uint32_t results;
+    double seconds;
+} Run;
+
+static Run run(BehaviorNode *root, int tick)
+{
+    Run result = {0, 0, 0, 0};
+
+    calls = 0;
+    trail = 0;
+    ticking = tick;
+    double start = nowSeconds();
+    for (int i = 0; i < ITERATIONS; i++)
+    {
+        uint32_t status = tick ? (uint32_t)tickTreeAt(root, (uint64_t)i) : (uint32_t)executeNode(root);
+        result.results = result.results * 3 + status;
+    }
+    result.seconds = (nowSeconds() - start) / ITERATIONS;
+    haltTree(root);
+    result.trail = trail;
+    result.calls = calls;
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    int blocks = argc > 1 ? atoi(argv[1]) : 5000;
+    BehaviorNode *original = build(blocks);
+    BehaviorNode *optimized = build(blocks);
+
+    BtOptimizeStats stats;
+    double start = nowSeconds();
+    btOptimizeTree(&optimized, &stats);
+    double pass = nowSeconds() - start;
+
+    int mismatches = 0;
+    const char *labels[2] = {"executeNode", "tickTree"};
+    fprintf(stderr, "nodes:      %u -> %u (%u removed)\n", stats.nodes_before, stats.nodes_after,
+            stats.nodes_before - stats.nodes_after);
+    fprintf(stderr, "rewrites:   %u flattened, %u folded, %u collapsed, %u pruned\n", stats.flattened,
+            stats.folded, stats.collapsed, stats.pruned);
+    fprintf(stderr, "pass time:  %.2f ms\n", pass * 1e3);
+    for (int tick = 0; tick < 2; tick++)
+    {
+        Run before = run(original, tick);
+        Run after = run(optimized, tick);
+        if (before.trail != after.trail || before.calls != after.calls || before.results != after.results)
+            mismatches++;
+        fprintf(stderr, "%-11s %8.1f us -> %8.1f us (%.2fx)\n", labels[tick], before.seconds * 1e6,
+                after.seconds * 1e6, before.seconds / after.seconds);
+    }
+    fprintf(stderr, "%d mismatches\n", mismatches);
+
+    freeBehaviorTree(original);
+    freeBehaviorTree(optimized);
+    return mismatches == 0 ? 0 : 1;
+}
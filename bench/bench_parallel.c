@@ -0,0 +1,75 @@
+/*
+ * Runs a parallel node with CPU-heavy action children sequentially
+ * (executeNode) and on work-stealing executors of increasing size
+ * (executeNodeParallel). Results are printed on stderr:
+ *
+ *     ./bench_parallel > /dev/null
+ */
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include "BehaviorTree.h"
+#include "BehaviorTreeParallel.h"
+
+#define CHILDREN 32
+
+static int heavyAction(void)
+{
+    // 纯计算, 线程安全
+    uint64_t value = 88172645463325252ull;
+    for (int i = 0; i < 2000000; i++)
+    {
+        value ^= value << 13;
+        value ^= value >> 7;
+        value ^= value << 17;
+    }
+    volatile uint64_t sink = value; // 防止循环被优化掉
+    (void)sink;
+    return 1;
+}
+
+static double nowSeconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+int main(void)
+{
+    BehaviorNode *children[CHILDREN];
+    for (int i = 0; i < CHILDREN; i++)
+    {
+        BehaviorNode *leaf = createBehaviorNode(NULL, 0, NODE_TYPE_ACTION, heavyAction);
+        // 每两个叶子组成一个顺序节点, 让子树也有一定深度
+        BehaviorNode *pair[] = {leaf, leaf};
+        children[i] = createBehaviorNode(pair, 2, NODE_TYPE_SEQUENCE, NULL);
+    }
+    BehaviorNode *root = createParallelNode(children, CHILDREN, 0, 0);
+
+    double start = nowSeconds();
+    int expected = executeNode(root);
+    double sequential = nowSeconds() - start;
+    fprintf(stderr, "%8s %10s %8s\n", "threads", "seconds", "speedup");
+    fprintf(stderr, "%8s %10.3f %8.2fx\n", "serial", sequential, 1.0);
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    long maxThreads = cpus < 4 ? 4 : cpus;
+    for (int threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        // 调用线程也参与执行, 所以只创建 threads - 1 个工作线程
+        BtExecutor *executor = btExecutorCreate(threads > 1 ? threads - 1 : 1);
+        start = nowSeconds();
+        int result = executeNodeParallel(executor, root, NULL);
+        double elapsed = nowSeconds() - start;
+        btExecutorDestroy(executor);
+
+        if (result != expected)
+        {
+            fprintf(stderr, "result mismatch with %d threads\n", threads);
+            return 1;
+        }
+        fprintf(stderr, "%8d %10.3f %8.2fx\n", threads, elapsed, sequential / elapsed);
+    }
+    return 0;
+}
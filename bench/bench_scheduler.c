@@ -0,0 +1,130 @@
+/*
+ * Many agents share a compiled tree whose action costs a few microseconds.
+ * Ticking every agent each frame (tickBatch) makes the frame time grow with
+ * the fleet; the scheduler ticks them within a fixed budget per frame and
+ * carries the rest over, with a small group of high-priority agents that
+ * must be ticked every frame. Results are printed on stderr:
+ *
+ *     ./bench_scheduler [agents] [budget_us] [frames] [dump]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "BehaviorTree.h"
+#include "BehaviorTreeFlat.h"
+#include "BehaviorTreeScheduler.h"
+
+#define WORK_NS 2000L
+#define HIGH_PRIORITY_EVERY 50 // 每 50 个 agent 中有一个高优先级
+
+static uint64_t nowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static int senseEnemy(BtContext *ctx)
+{
+    (void)ctx;
+    return 1;
+}
+
+// 模拟寻路等耗时工作
+static int planPath(BtContext *ctx)
+{
+    uint64_t until = nowNs() + WORK_NS;
+    (void)ctx;
+    while (nowNs() < until)
+        ;
+    return 1;
+}
+
+static int compare(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void printFrames(const char *label, uint64_t *frames, int count)
+{
+    qsort(frames, (size_t)count, sizeof(uint64_t), compare);
+    fprintf(stderr, "%-10s frame p50 %8.3f ms, p99 %8.3f ms, max %8.3f ms\n", label,
+            frames[count / 2] / 1e6, frames[count * 99 / 100] / 1e6, frames[count - 1] / 1e6);
+}
+
+int main(int argc, char **argv)
+{
+    int agents = argc > 1 ? atoi(argv[1]) : 2000;
+    uint32_t budget = argc > 2 ? (uint32_t)atoi(argv[2]) : 2000;
+    int frameCount = argc > 3 ? atoi(argv[3]) : 100;
+
+    BehaviorNode *steps[2] = {
+        createContextNode(NODE_TYPE_CONDITION, senseEnemy),
+        createContextNode(NODE_TYPE_ACTION, planPath),
+    };
+    BehaviorNode *root = createBehaviorNode(steps, 2, NODE_TYPE_SEQUENCE, NULL);
+    BtFlatTree *tree = btCompileTree(root);
+    BtInstance *instances = btCreateInstances(tree, agents);
+    uint64_t *frames = malloc(sizeof(uint64_t) * (size_t)frameCount);
+    BtTreeId *ids = malloc(sizeof(BtTreeId) * (size_t)agents);
+
+    // 全部 tick: 帧时间随 agent 数增长
+    for (int f = 0; f < frameCount; f++)
+    {
+        uint64_t start = nowNs();
+        tickBatch(tree, instances, agents);
+        frames[f] = nowNs() - start;
+    }
+    printFrames("tickBatch", frames, frameCount);
+
+    // 调度器: 高优先级 agent 每帧 tick, 其余轮流使用剩下的预算
+    BtScheduler *scheduler = btSchedulerCreate(BT_SCHED_PRIORITY);
+    for (int i = 0; i < agents; i++)
+        ids[i] = btSchedulerAddInstance(scheduler, tree, &instances[i], i % HIGH_PRIORITY_EVERY == 0, 0);
+
+    uint64_t ticks = 0;
+    for (int f = 0; f < frameCount; f++)
+    {
+        BtFrameReport report;
+        btSchedulerRunFrame(scheduler, budget, &report);
+        frames[f] = report.elapsed_ns;
+        ticks += report.ticked;
+    }
+    printFrames("scheduler", frames, frameCount);
+
+    BtTreeStats high, low, stats;
+    btSchedulerStats(scheduler, ids[0], &high);
+    btSchedulerStats(scheduler, ids[1], &low);
+    uint64_t lowTicks = 0, missed = 0, highWait = 0;
+    for (int i = 0; i < agents; i++)
+    {
+        btSchedulerStats(scheduler, ids[i], &stats);
+        if (i % HIGH_PRIORITY_EVERY)
+        {
+            lowTicks += stats.ticks;
+            continue;
+        }
+        missed += stats.missed;
+        if (stats.wait_p99_ns > highWait)
+            highWait = stats.wait_p99_ns;
+    }
+
+    fprintf(stderr, "agents %d, work %.1f us, budget %.1f ms, %.1f ticks per frame\n", agents, WORK_NS / 1e3,
+            budget / 1e3, (double)ticks / frameCount);
+    fprintf(stderr, "high priority: %llu ticks each, %llu missed in total, worst wait p99 %.3f ms\n",
+            (unsigned long long)high.ticks, (unsigned long long)missed, highWait / 1e6);
+    fprintf(stderr, "low priority:  %.1f ticks each, wait p50 %.3f ms, p99 %.3f ms\n",
+            (double)lowTicks / (agents - (agents + HIGH_PRIORITY_EVERY - 1) / HIGH_PRIORITY_EVERY),
+            low.wait_p50_ns / 1e6, low.wait_p99_ns / 1e6);
+    if (argc > 4)
+        btSchedulerDump(scheduler, stderr, 10);
+
+    btSchedulerDestroy(scheduler);
+    free(ids);
+    free(frames);
+    btFreeInstances(instances);
+    btFreeFlatTree(tree);
+    freeBehaviorTree(root);
+    return high.ticks == (uint64_t)frameCount ? 0 : 1;
+}
@@ -0,0 +1,253 @@
+/*
+ * Worker threads tick their agents on one compiled tree while the main
+ * thread publishes a new version of the tree every few milliseconds. Three
+ * ways to share the tree are compared:
+ *
+ *   private: every thread compiles its own copy, never reloaded (upper bound)
+ *   rwlock:  one tree behind a pthread_rwlock, read-locked for every tick
+ *   shared:  btSharedTick, versions reclaimed once no reader can reach them
+ *
+ * Every version must be freed once the agents are released. Results are
+ * printed on stderr:
+ *
+ *     ./bench_shared [threads] [agents per thread] [ms]
+ */
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "BehaviorTree.h"
+#include "BehaviorTreeFlat.h"
+#include "BehaviorTreeShared.h"
+
+#define PUBLISH_EVERY_MS 2
+#define MAX_VERSIONS 4096
+
+enum
+{
+    MODE_PRIVATE,
+    MODE_RWLOCK,
+    MODE_SHARED
+};
+
+typedef struct
+{
+    int mode;
+    int agents;
+    uint64_t ticks;
+    uint64_t halted; // 换版本时被中止的 agent
+    pthread_t thread;
+} Worker;
+
+static BehaviorNode *root;
+static atomic_int running;
+static BtShared *shared;
+static pthread_rwlock_t treeLock = PTHREAD_RWLOCK_INITIALIZER;
+static const BtFlatTree *lockedTree;
+
+static double nowSeconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static int sense(BtContext *ctx)
+{
+    return (++*(uint64_t *)ctx->agent & 7) != 0;
+}
+
+static int act(BtContext *ctx)
+{
+    // 每隔几次 tick 运行一次, 让换版本时有节点需要中止
+    return (*(uint64_t *)ctx->agent & 3) == 0 ? BT_RUNNING : BT_SUCCESS;
+}
+
+static BehaviorNode *buildTree(void)
+{
+    BehaviorNode *steps[3] = {
+        createContextNode(NODE_TYPE_CONDITION, sense),
+        createContextNode(NODE_TYPE_CONDITION, sense),
+        createContextNode(NODE_TYPE_ACTION, act),
+    };
+    BehaviorNode *options[2] = {
+        createBehaviorNode(steps, 3, NODE_TYPE_SEQUENCE, NULL),
+        createContextNode(NODE_TYPE_ACTION, act),
+    };
+    return createBehaviorNode(options, 2, NODE_TYPE_SELECTOR, NULL);
+}
+
+static void *workerMain(void *arg)
+{
+    Worker *worker = arg;
+    uint64_t *counters = calloc((size_t)worker->agents, sizeof(uint64_t));
+    uint64_t now = 0;
+
+    if (worker->mode == MODE_PRIVATE)
+    {
+        BtFlatTree *tree = btCompileTree(root);
+        BtInstance *instances = btCreateInstances(tree, worker->agents);
+        for (int i = 0; i < worker->agents; i++)
+            instances[i].context.agent = &counters[i];
+        while (atomic_load_explicit(&running, memory_order_relaxed))
+        {
+            for (int i = 0; i < worker->agents; i++)
+                tickInstance(tree, &instances[i], now);
+            worker->ticks += (uint64_t)worker->agents;
+            now++;
+        }
+        btFreeInstances(instances);
+        btFreeFlatTree(tree);
+    }
+    else if (worker->mode == MODE_RWLOCK)
+    {
+        // 旧版本由主线程保留到结束, 这里只需在读锁内换实例
+        const BtFlatTree **trees = calloc((size_t)worker->agents, sizeof(BtFlatTree *));
+        BtInstance **instances = calloc((size_t)worker->agents, sizeof(BtInstance *));
+        while (atomic_load_explicit(&running, memory_order_relaxed))
+        {
+            for (int i = 0; i < worker->agents; i++)
+            {
+                pthread_rwlock_rdlock(&treeLock);
+                if (trees[i] != lockedTree)
+                {
+                    if (instances[i])
+                    {
+                        btHaltInstance(trees[i], instances[i]);
+                        btFreeInstances(instances[i]);
+                        worker->halted++;
+                    }
+                    trees[i] = lockedTree;
+                    instances[i] = btCreateInstances(lockedTree, 1);
+                    instances[i]->context.agent = &counters[i];
+                }
+                tickInstance(trees[i], instances[i], now);
+                pthread_rwlock_unlock(&treeLock);
+            }
+            worker->ticks += (uint64_t)worker->agents;
+            now++;
+        }
+        for (int i = 0; i < worker->agents; i++)
+            btFreeInstances(instances[i]);
+        free(instances);
+        free(trees);
+    }
+    else
+    {
+        BtSharedReader *reader = btSharedRegister(shared);
+        BtSharedAgent *agents = malloc(sizeof(BtSharedAgent) * (size_t)worker->agents);
+        for (int i = 0; i < worker->agents; i++)
+            btSharedAgentInit(&agents[i], (BtContext){&counters[i], NULL});
+        while (atomic_load_explicit(&running, memory_order_relaxed))
+        {
+            for (int i = 0; i < worker->agents; i++)
+                btSharedTick(reader, &agents[i], now);
+            worker->ticks += (uint64_t)worker->agents;
+            now++;
+        }
+        for (int i = 0; i < worker->agents; i++)
+            btSharedAgentRelease(shared, &agents[i]);
+        free(agents);
+        btSharedUnregister(reader);
+    }
+    free(counters);
+    return NULL;
+}
+
+static double run(int mode, int threads, int agents, int ms, uint64_t *versions)
+{
+    Worker *workers = calloc((size_t)threads, sizeof(Worker));
+    BtFlatTree **kept = calloc(MAX_VERSIONS, sizeof(BtFlatTree *));
+    int keptCount = 0;
+
+    *versions = 0;
+    if (mode == MODE_RWLOCK)
+    {
+        kept[keptCount++] = btCompileTree(root);
+        lockedTree = kept[0];
+    }
+    else if (mode == MODE_SHARED)
+    {
+        btSharedPublish(shared, btCompileTree(root));
+    }
+
+    atomic_store(&running, 1);
+    for (int t = 0; t < threads; t++)
+    {
+        workers[t].mode = mode;
+        workers[t].agents = agents;
+        pthread_create(&workers[t].thread, NULL, workerMain, &workers[t]);
+    }
+
+    double start = nowSeconds();
+    struct timespec pause = {0, PUBLISH_EVERY_MS * 1000000L};
+    while (nowSeconds() - start < ms / 1e3)
+    {
+        nanosleep(&pause, NULL);
+        // 模拟热更新: 重新编译并发布
+        BtFlatTree *tree = btCompileTree(root);
+        if (mode == MODE_RWLOCK && keptCount < MAX_VERSIONS)
+        {
+            kept[keptCount++] = tree;
+            pthread_rwlock_wrlock(&treeLock);
+            lockedTree = tree;
+            pthread_rwlock_unlock(&treeLock);
+            (*versions)++;
+        }
+        else if (mode == MODE_SHARED)
+        {
+            btSharedPublish(shared, tree);
+            (*versions)++;
+        }
+        else
+        {
+            btFreeFlatTree(tree);
+        }
+    }
+    atomic_store(&running, 0);
+    double elapsed = nowSeconds() - start;
+
+    uint64_t ticks = 0;
+    for (int t = 0; t < threads; t++)
+    {
+        pthread_join(workers[t].thread, NULL);
+        ticks += workers[t].ticks;
+    }
+    for (int i = 0; i < keptCount; i++)
+        btFreeFlatTree(kept[i]);
+    free(kept);
+    free(workers);
+    return (double)ticks / elapsed;
+}
+
+int main(int argc, char **argv)
+{
+    int threads = argc > 1 ? atoi(argv[1]) : 4;
+    int agents = argc > 2 ? atoi(argv[2]) : 256;
+    int ms = argc > 3 ? atoi(argv[3]) : 500;
+    const char *labels[3] = {"private", "rwlock", "shared"};
+    uint64_t versions;
+
+    root = buildTree();
+    shared = btSharedCreate((uint32_t)threads);
+
+    fprintf(stderr, "%d threads x %d agents, new version every %d ms\n", threads, agents, PUBLISH_EVERY_MS);
+    for (int mode = MODE_PRIVATE; mode <= MODE_SHARED; mode++)
+    {
+        double rate = run(mode, threads, agents, ms, &versions);
+        fprintf(stderr, "%-8s %8.1f M ticks/s, %llu versions published\n", labels[mode], rate / 1e6,
+                (unsigned long long)versions);
+    }
+
+    // agent 全部释放后, 除当前版本外的所有版本都应已回收
+    BtSharedStats stats;
+    btSharedCollect(shared);
+    btSharedGetStats(shared, &stats);
+    fprintf(stderr, "shared:  %llu published, %llu freed, %u waiting, %u readers\n",
+            (unsigned long long)stats.published, (unsigned long long)stats.freed, stats.retired, stats.readers);
+
+    btSharedDestroy(shared);
+    freeBehaviorTree(root);
+    return stats.freed + 1 == stats.published && stats.retired == 0 ? 0 : 1;
+}
@@ -0,0 +1,141 @@
+/*
+ * Ticks a batch of instances of a compiled tree with tracing off and on,
+ * reports the cost of recording, then decodes the trace with btTraceDecode
+ * and checks that it holds one flat result per node and tick: recorded
+ * events plus the events the rings dropped. The ticks are paced so that the
+ * drainer empties the ring between them; only the ticks are timed. With the
+ * default sizes one tick records fewer than BT_TRACE_RING_SIZE events and
+ * nothing should be dropped. Results are printed on stderr:
+ *
+ *     ./bench_trace [instances] [ticks] [path]
+ *
+ * The decoded trace (bt_trace_decode prints the same) looks like
+ *
+ *     0.012345 thread 0 result flat 3 action success
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "BehaviorTree.h"
+#include "BehaviorTreeFlat.h"
+#include "BehaviorTreeTrace.h"
+
+static double nowSeconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static int succeed(void)
+{
+    return 1;
+}
+
+// 每个块都访问到所有节点: 序列的子节点都成功, 选择器的第一个子节点失败
+static BehaviorNode *block(void)
+{
+    BehaviorNode *failing = createBehaviorNode(NULL, 0, NODE_TYPE_CONDITION, succeed);
+    BehaviorNode *inverted = createBehaviorNode(&failing, 1, NODE_TYPE_DECORATOR, NULL);
+    inverted->decorator = createDecorator(DECORATOR_TYPE_INVERT, NULL);
+    BehaviorNode *options[2] = {inverted, createBehaviorNode(NULL, 0, NODE_TYPE_ACTION, succeed)};
+    BehaviorNode *steps[3] = {
+        createBehaviorNode(NULL, 0, NODE_TYPE_CONDITION, succeed),
+        createBehaviorNode(options, 2, NODE_TYPE_SELECTOR, NULL),
+        createBehaviorNode(NULL, 0, NODE_TYPE_ACTION, succeed),
+    };
+    return createBehaviorNode(steps, 3, NODE_TYPE_SEQUENCE, NULL);
+}
+
+static double run(const BtFlatTree *tree, BtInstance *instances, int count, int ticks)
+{
+    struct timespec pause = {0, 3000000L}; // 排空间隔的 3 倍
+    double elapsed = 0;
+
+    for (int i = 0; i < ticks; i++)
+    {
+        double start = nowSeconds();
+        tickBatch(tree, instances, count);
+        elapsed += nowSeconds() - start;
+        nanosleep(&pause, NULL);
+    }
+    return elapsed;
+}
+
+// 解码并统计 flat 结果行和丢弃的事件数
+static int countEvents(const char *path, unsigned long *results, unsigned long *dropped)
+{
+    FILE *in = fopen(path, "rb");
+    FILE *text = tmpfile();
+    char line[160];
+    int ok = in && text && btTraceDecode(in, text);
+
+    *results = 0;
+    *dropped = 0;
+    if (ok)
+    {
+        rewind(text);
+        while (fgets(line, sizeof(line), text))
+        {
+            unsigned thread, count;
+            if (strstr(line, " result flat "))
+                (*results)++;
+            else if (sscanf(line, "thread %u dropped %u", &thread, &count) == 2)
+                *dropped += count;
+        }
+    }
+    if (in)
+        fclose(in);
+    if (text)
+        fclose(text);
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    int count = argc > 1 ? atoi(argv[1]) : 50;
+    int ticks = argc > 2 ? atoi(argv[2]) : 200;
+    const char *path = argc > 3 ? argv[3] : "bench_trace.bin";
+    BehaviorNode *children[8];
+
+    for (int i = 0; i < 8; i++)
+        children[i] = block();
+    BehaviorNode *root = createBehaviorNode(children, 8, NODE_TYPE_SEQUENCE, NULL);
+    BtFlatTree *tree = btCompileTree(root);
+    BtInstance *instances = btCreateInstances(tree, count);
+    if (!tree || !instances)
+    {
+        fprintf(stderr, "could not compile the tree\n");
+        return 1;
+    }
+
+    double off = run(tree, instances, count, ticks);
+    if (!btTraceStart(path, 1))
+    {
+        fprintf(stderr, "could not start tracing to %s\n", path);
+        return 1;
+    }
+    double on = run(tree, instances, count, ticks);
+    int written = btTraceStop();
+
+    unsigned long results, dropped;
+    unsigned long expected = (unsigned long)tree->node_count * (unsigned long)count * (unsigned long)ticks;
+    int decoded = countEvents(path, &results, &dropped);
+    double perNode = 1e9 / ((double)tree->node_count * count * ticks);
+
+    fprintf(stderr, "nodes:       %u x %d instances x %d ticks\n", tree->node_count, count, ticks);
+    fprintf(stderr, "trace off:   %6.2f ns/node\n", off * perNode);
+    fprintf(stderr, "trace on:    %6.2f ns/node\n", on * perNode);
+    fprintf(stderr, "events:      %lu recorded, %lu dropped, %lu expected\n", results, dropped, expected);
+
+    int failures = !written || !decoded || results + dropped != expected || results == 0;
+    if (failures)
+        fprintf(stderr, "trace does not match the ticks\n");
+
+    remove(path);
+    btFreeInstances(instances);
+    btFreeFlatTree(tree);
+    freeBehaviorTree(root);
+    return failures;
+}
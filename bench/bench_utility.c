@@ -0,0 +1,187 @@
+/*
+ * A utility selector chooses among many options for many agents. The
+ * baseline gives every option its own scoring callback that reads the
+ * agent's blackboard, the usual way to write a utility selector; the
+ * utility node scores all options with the SoA table and the SIMD kernel.
+ * Both must pick the same option for every agent. Results are printed on
+ * stderr:
+ *
+ *     ./bench_utility [options] [agents]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "BehaviorTree.h"
+#include "BehaviorTreeFlat.h"
+#include "BehaviorTreeUtility.h"
+#include "Blackboard.h"
+
+#define INPUTS 8
+#define ROUNDS 20
+
+typedef struct
+{
+    float bias;
+    float weights[INPUTS];
+} Option;
+
+static BbKey keys[INPUTS];
+
+static double nowSeconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static float randomWeight(void)
+{
+    return (float)rand() / (float)RAND_MAX * 2.0f - 1.0f;
+}
+
+// 基线: 每个选项一个评分回调, 各自读取黑板
+static float scoreOption(const Option *option, const Blackboard *blackboard)
+{
+    float score = option->bias;
+    for (int k = 0; k < INPUTS; k++)
+        score += option->weights[k] * (float)bbGetFloat(blackboard, keys[k]);
+    return score;
+}
+
+static int chooseBaseline(const Option *options, int count, const Blackboard *blackboard)
+{
+    float (*volatile score)(const Option *, const Blackboard *) = scoreOption; // 模拟间接调用
+    int best = 0;
+    float bestScore = score(&options[0], blackboard);
+
+    for (int i = 1; i < count; i++)
+    {
+        float value = score(&options[i], blackboard);
+        if (value > bestScore)
+        {
+            best = i;
+            bestScore = value;
+        }
+    }
+    return best;
+}
+
+static int succeed(BtContext *ctx)
+{
+    (void)ctx;
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    int optionCount = argc > 1 ? atoi(argv[1]) : 256;
+    int agents = argc > 2 ? atoi(argv[2]) : 1000;
+
+    BbSchema *schema = bbSchemaCreate();
+    for (int k = 0; k < INPUTS; k++)
+    {
+        char name[16];
+        snprintf(name, sizeof(name), "input%d", k);
+        keys[k] = bbIntern(schema, name, BB_TYPE_FLOAT);
+    }
+
+    BtUtility *table = btUtilityCreate((uint32_t)optionCount, INPUTS);
+    Option *options = malloc(sizeof(Option) * (size_t)optionCount);
+    for (int i = 0; i < optionCount; i++)
+    {
+        options[i].bias = randomWeight();
+        btUtilitySetBias(table, (uint32_t)i, options[i].bias);
+        for (int k = 0; k < INPUTS; k++)
+        {
+            options[i].weights[k] = randomWeight();
+            btUtilitySetWeight(table, (uint32_t)i, (uint32_t)k, options[i].weights[k]);
+        }
+    }
+    for (int k = 0; k < INPUTS; k++)
+        btUtilitySetInputKey(table, (uint32_t)k, keys[k]);
+
+    BehaviorNode **children = malloc(sizeof(BehaviorNode *) * (size_t)optionCount);
+    for (int i = 0; i < optionCount; i++)
+        children[i] = createContextNode(NODE_TYPE_ACTION, succeed);
+    BehaviorNode *root = createUtilityNode(children, optionCount, table, BT_UTILITY_MAX);
+    BtFlatTree *tree = btCompileTree(root);
+    BtInstance *instances = btCreateInstances(tree, agents);
+
+    Blackboard **boards = malloc(sizeof(Blackboard *) * (size_t)agents);
+    float *inputs = malloc(sizeof(float) * INPUTS * (size_t)agents);
+    float *scores = malloc(sizeof(float) * btUtilityStride(table) * (size_t)agents);
+    int *expected = malloc(sizeof(int) * (size_t)agents);
+    for (int a = 0; a < agents; a++)
+    {
+        boards[a] = bbCreate(schema);
+        for (int k = 0; k < INPUTS; k++)
+        {
+            float value = randomWeight();
+            bbSetFloat(boards[a], keys[k], value);
+            inputs[(size_t)a * INPUTS + k] = value;
+        }
+        instances[a].context.blackboard = boards[a];
+        expected[a] = chooseBaseline(options, optionCount, boards[a]);
+    }
+
+    // 基线
+    volatile int sink = 0;
+    double start = nowSeconds();
+    for (int r = 0; r < ROUNDS; r++)
+    {
+        for (int a = 0; a < agents; a++)
+            sink += chooseBaseline(options, optionCount, boards[a]);
+    }
+    double baseline = (nowSeconds() - start) / ROUNDS / agents;
+
+    int mismatches = 0;
+    for (int a = 0; a < agents; a++)
+    {
+        uint32_t rng = 0;
+        mismatches += (int)btUtilityChoose(table, &instances[a].context, BT_UTILITY_MAX, &rng) != expected[a];
+    }
+
+    // utility 节点: 每次 tick 读取黑板、打分并执行选中的叶子
+    start = nowSeconds();
+    for (int r = 0; r < ROUNDS; r++)
+    {
+        for (int a = 0; a < agents; a++)
+            tickInstance(tree, &instances[a], 0);
+    }
+    double node = (nowSeconds() - start) / ROUNDS / agents;
+
+    // 批量: 输入已经收集好, 一次为所有 agent 打分
+    start = nowSeconds();
+    for (int r = 0; r < ROUNDS; r++)
+        btUtilityScoreBatch(table, inputs, (uint32_t)agents, scores);
+    double batch = (nowSeconds() - start) / ROUNDS / agents;
+
+    for (int a = 0; a < agents; a++)
+    {
+        const float *row = scores + (size_t)a * btUtilityStride(table);
+        mismatches += (int)btUtilityArgmax(row, (uint32_t)optionCount) != expected[a];
+    }
+
+    fprintf(stderr, "options %d, inputs %d, agents %d, kernel %s, %d mismatches\n",
+            optionCount, INPUTS, agents, btUtilityKernelName(), mismatches);
+    fprintf(stderr, "callbacks:     %8.3f us per choice\n", baseline * 1e6);
+    fprintf(stderr, "utility node:  %8.3f us per tick\n", node * 1e6);
+    fprintf(stderr, "score batch:   %8.3f us per agent\n", batch * 1e6);
+    fprintf(stderr, "speedup:       %8.1fx (node), %.1fx (batch)\n", baseline / node, baseline / batch);
+
+    for (int a = 0; a < agents; a++)
+        bbDestroy(boards[a]);
+    free(boards);
+    free(inputs);
+    free(scores);
+    free(expected);
+    free(children);
+    free(options);
+    btFreeInstances(instances);
+    btFreeFlatTree(tree);
+    freeBehaviorTree(root);
+    btUtilityDestroy(table);
+    bbSchemaDestroy(schema);
+    (void)sink;
+    return mismatches == 0 ? 0 : 1;
+}
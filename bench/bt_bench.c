@@ -0,0 +1,469 @@
+/*
+ * Tick throughput benchmarks on synthetic trees, reported as JSON so runs
+ * can be compared:
+ *
+ *     ./bt_bench [--filter <substring>] [--min-time <seconds>] > result.json
+ *
+ * Every tree is measured with four engines: executeNode on the pointer tree
+ * with the recursive ("pointer") and the iterative ("iterative") engine,
+ * executeFlat on the compiled tree ("flat") and tickInstance on one
+ * instance of it ("tick"). Trees are built in an arena. When the target is linked with
+ * -Wl,--wrap=malloc (see CMakeLists.txt) allocations are counted as well.
+ *
+ * Every tree is also written out as a text definition and read back with
+ * btParseTree ("parse"); there one iteration is one parse into a reset arena,
+ * so ticks_per_sec is parses per second.
+ *
+ * ns_per_node divides by the size of the tree. Every tree visits all of its
+ * nodes on each tick.
+ */
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "BehaviorTree.h"
+#include "BehaviorTreeArena.h"
+#include "BehaviorTreeFlat.h"
+#include "BehaviorTreeParser.h"
+
+#ifdef BT_BENCH_COUNT_ALLOCS
+// 由链接器 --wrap 重定向, 统计库内外所有堆分配
+static unsigned long allocCount;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+    allocCount++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size)
+{
+    allocCount++;
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    allocCount++;
+    return __real_realloc(ptr, size);
+}
+
+static long allocations(void)
+{
+    return (long)allocCount;
+}
+#else
+static long allocations(void)
+{
+    return 0;
+}
+#endif
+
+static int succeed(void)
+{
+    return 1;
+}
+
+static int fail(void)
+{
+    return 0;
+}
+
+static double nowSeconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* ---------------------------------------------------------------- */
+/* Generators                                                       */
+/* ---------------------------------------------------------------- */
+
+typedef BehaviorNode *(*Generator)(BtArena *arena, int size, int *nodes);
+
+static BehaviorNode *leaf(BtArena *arena, int (*action)(void), int *nodes)
+{
+    (*nodes)++;
+    return btArenaCreateBehaviorNode(arena, NULL, 0, NODE_TYPE_ACTION, action);
+}
+
+static BehaviorNode *decorate(BtArena *arena, BehaviorNode *child, Decorator *decorator, int *nodes)
+{
+    BehaviorNode *node = btArenaCreateBehaviorNode(arena, &child, 1, NODE_TYPE_DECORATOR, NULL);
+    node->decorator = decorator;
+    (*nodes)++;
+    return node;
+}
+
+static BehaviorNode *composite(BtArena *arena, NodeType type, BehaviorNode **children, int count, int *nodes)
+{
+    (*nodes)++;
+    return btArenaCreateBehaviorNode(arena, children, count, type, NULL);
+}
+
+// size 层只有一个子节点的 sequence, 测试深度
+static BehaviorNode *genChain(BtArena *arena, int size, int *nodes)
+{
+    BehaviorNode *node = leaf(arena, succeed, nodes);
+    for (int i = 0; i < size; i++)
+        node = composite(arena, NODE_TYPE_SEQUENCE, &node, 1, nodes);
+    return node;
+}
+
+// size 个成功子节点, 全部执行
+static BehaviorNode *genWideSequence(BtArena *arena, int size, int *nodes)
+{
+    BehaviorNode **children = malloc(sizeof(BehaviorNode *) * (size_t)size);
+    for (int i = 0; i < size; i++)
+        children[i] = leaf(arena, succeed, nodes);
+    BehaviorNode *root = composite(arena, NODE_TYPE_SEQUENCE, children, size, nodes);
+    free(children);
+    return root;
+}
+
+// 只有最后一个子节点成功, 全部执行
+static BehaviorNode *genWideSelector(BtArena *arena, int size, int *nodes)
+{
+    BehaviorNode **children = malloc(sizeof(BehaviorNode *) * (size_t)size);
+    for (int i = 0; i < size; i++)
+        children[i] = leaf(arena, i == size - 1 ? succeed : fail, nodes);
+    BehaviorNode *root = composite(arena, NODE_TYPE_SELECTOR, children, size, nodes);
+    free(children);
+    return root;
+}
+
+// 半数子节点成功; 失败阈值大于子节点数, 全部执行后因未全部成功而失败
+static BehaviorNode *genWideParallel(BtArena *arena, int size, int *nodes)
+{
+    BehaviorNode **children = malloc(sizeof(BehaviorNode *) * (size_t)size);
+    for (int i = 0; i < size; i++)
+        children[i] = leaf(arena, i % 2 ? fail : succeed, nodes);
+    BehaviorNode *root = composite(arena, NODE_TYPE_PARALLEL, children, size, nodes);
+    root->params.parallel.failure_threshold = (uint32_t)size + 1;
+    free(children);
+    return root;
+}
+
+// 每个叶子套 4 层装饰器, 结果仍为成功
+static BehaviorNode *genDecorated(BtArena *arena, int size, int *nodes)
+{
+    BehaviorNode **children = malloc(sizeof(BehaviorNode *) * (size_t)size);
+    for (int i = 0; i < size; i++)
+    {
+        BehaviorNode *node = leaf(arena, fail, nodes);
+        node = decorate(arena, node, btArenaCreateDecorator(arena, DECORATOR_TYPE_INVERT, NULL), nodes);
+        node = decorate(arena, node, btArenaCreateRepeatDecorator(arena, 1), nodes);
+        node = decorate(arena, node, btArenaCreateDecorator(arena, DECORATOR_TYPE_INVERT, NULL), nodes);
+        children[i] = decorate(arena, node, btArenaCreateDecorator(arena, DECORATOR_TYPE_INVERT, NULL), nodes);
+    }
+    BehaviorNode *root = composite(arena, NODE_TYPE_SEQUENCE, children, size, nodes);
+    free(children);
+    return root;
+}
+
+static uint32_t randomState;
+
+static uint32_t nextRandom(void)
+{
+    // xorshift32, 固定种子保证每次运行生成同一棵树
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+/*
+ * want 是让父节点继续执行下一个子节点的结果 (sequence 为成功, selector 为失败),
+ * 每棵子树都返回它, 所以每次执行都访问所有节点: 要成功的组合节点是 sequence,
+ * 要失败的是 selector, parallel 的阈值只在最后一个子节点处达到.
+ */
+static BehaviorNode *genRandomNode(BtArena *arena, int *budget, int depth, int want, int *nodes)
+{
+    uint32_t pick = nextRandom() % 8;
+
+    if (depth == 0)
+        pick = 4 + pick % 4; // 根节点总是组合节点
+    if (*budget <= 1 || depth >= 12 || pick < 3)
+    {
+        (*budget)--;
+        return leaf(arena, want ? succeed : fail, nodes);
+    }
+    if (pick == 3)
+    {
+        (*budget)--;
+        BehaviorNode *child = genRandomNode(arena, budget, depth + 1, !want, nodes);
+        return decorate(arena, child, btArenaCreateDecorator(arena, DECORATOR_TYPE_INVERT, NULL), nodes);
+    }
+
+    NodeType type = pick == 7 ? NODE_TYPE_PARALLEL : want ? NODE_TYPE_SEQUENCE : NODE_TYPE_SELECTOR;
+    BehaviorNode *children[8];
+    int count = 2 + (int)(nextRandom() % 7);
+
+    (*budget)--;
+    for (int i = 0; i < count; i++)
+        children[i] = genRandomNode(arena, budget, depth + 1, want, nodes);
+    BehaviorNode *node = composite(arena, type, children, count, nodes);
+    // 成功时全部成功才达到成功阈值; 失败时全部失败才达到失败阈值
+    if (type == NODE_TYPE_PARALLEL)
+        node->params.parallel.failure_threshold = want ? (uint32_t)count + 1 : (uint32_t)count;
+    return node;
+}
+
+// 随机混合各种节点, 约 size 个节点
+static BehaviorNode *genMixed(BtArena *arena, int size, int *nodes)
+{
+    int budget = size;
+    randomState = 0x9E3779B9u;
+    return genRandomNode(arena, &budget, 0, 1, nodes);
+}
+
+/* ---------------------------------------------------------------- */
+/* Text definitions                                                 */
+/* ---------------------------------------------------------------- */
+
+typedef struct
+{
+    char *data;
+    size_t length;
+    size_t capacity;
+} Text;
+
+static void append(Text *text, const char *format, ...)
+{
+    va_list args;
+
+    for (;;)
+    {
+        va_start(args, format);
+        int length = vsnprintf(text->data + text->length, text->capacity - text->length, format, args);
+        va_end(args);
+        if (text->length + (size_t)length < text->capacity)
+        {
+            text->length += (size_t)length;
+            return;
+        }
+        text->capacity = text->capacity ? text->capacity * 2 : 4096;
+        text->data = realloc(text->data, text->capacity);
+    }
+}
+
+// 生成器只用到这些节点类型; 缩进最多 16 层, 以免 chain 的文本过大
+static void writeNode(Text *text, const BehaviorNode *node, int depth)
+{
+    append(text, "%*s", (depth < 16 ? depth : 16) * 2, "");
+    switch (node->type)
+    {
+    case NODE_TYPE_ACTION:
+        append(text, "action %s\n", node->action == succeed ? "succeed" : "fail");
+        return;
+    case NODE_TYPE_DECORATOR:
+        if (node->decorator->type == DECORATOR_TYPE_REPEAT)
+            append(text, "repeat %u {\n", node->decorator->params.repeat);
+        else
+            append(text, "invert {\n");
+        break;
+    case NODE_TYPE_PARALLEL:
+        append(text, "parallel %u %u {\n", node->params.parallel.success_threshold,
+               node->params.parallel.failure_threshold);
+        break;
+    default:
+        append(text, "%s {\n", node->type == NODE_TYPE_SEQUENCE ? "sequence" : "selector");
+        break;
+    }
+    for (int i = 0; i < node->child_count; i++)
+        writeNode(text, node->children[i], depth + 1);
+    append(text, "%*s}\n", (depth < 16 ? depth : 16) * 2, "");
+}
+
+typedef struct
+{
+    Text text;
+    BtRegistry *registry;
+    BtArena *arena; // 每次解析前重置
+} ParseInput;
+
+/* ---------------------------------------------------------------- */
+/* Runner                                                           */
+/* ---------------------------------------------------------------- */
+
+typedef struct
+{
+    const char *name;
+    Generator generate;
+    int size;
+} Benchmark;
+
+static const Benchmark benchmarks[] = {
+    // 各节点类型的微基准
+    {"micro_sequence", genWideSequence, 8},
+    {"micro_selector", genWideSelector, 8},
+    {"micro_decorator", genDecorated, 1},
+    {"micro_parallel", genWideParallel, 8},
+    // 合成树
+    {"chain_1000", genChain, 1000},
+    {"wide_sequence_10000", genWideSequence, 10000},
+    {"wide_selector_10000", genWideSelector, 10000},
+    {"decorated_2000", genDecorated, 2000},
+    {"mixed_10000", genMixed, 10000},
+    {"mixed_100000", genMixed, 100000},
+};
+
+enum
+{
+    ENGINE_POINTER,
+    ENGINE_ITERATIVE,
+    ENGINE_FLAT,
+    ENGINE_TICK,
+    ENGINE_PARSE,
+    ENGINE_COUNT
+};
+
+static const char *const engineNames[ENGINE_COUNT] = {"pointer", "iterative", "flat", "tick", "parse"};
+
+static int runEngine(int engine, BehaviorNode *root, const BtFlatTree *flat, BtInstance *instance,
+                     ParseInput *parse, long iterations)
+{
+    int result = 0;
+    btSetEngine(engine == ENGINE_ITERATIVE ? BT_ENGINE_ITERATIVE : BT_ENGINE_RECURSIVE);
+    for (long i = 0; i < iterations; i++)
+    {
+        switch (engine)
+        {
+        case ENGINE_POINTER:
+        case ENGINE_ITERATIVE:
+            result = executeNode(root);
+            break;
+        case ENGINE_FLAT:
+            result = executeFlat(flat, NULL);
+            break;
+        case ENGINE_TICK:
+            result = tickInstance(flat, instance, 0) == BT_SUCCESS;
+            break;
+        default:
+            btArenaReset(parse->arena);
+            result = btParseTree(parse->text.data, parse->text.length, parse->registry, parse->arena, NULL) != NULL;
+            break;
+        }
+    }
+    return result;
+}
+
+static volatile int sink;
+
+int main(int argc, char **argv)
+{
+    const char *filter = NULL;
+    double minTime = 0.2;
+    int first = 1;
+    ParseInput parse = {{NULL, 0, 0}, btRegistryCreate(), btArenaCreate(0)};
+
+    btRegistryAdd(parse.registry, "succeed", succeed);
+    btRegistryAdd(parse.registry, "fail", fail);
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+            filter = argv[++i];
+        else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc)
+            minTime = atof(argv[++i]);
+        else
+        {
+            fprintf(stderr, "usage: %s [--filter <substring>] [--min-time <seconds>]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    printf("{\n  \"alloc_counting\": %s,\n  \"min_time_s\": %g,\n  \"benchmarks\": [",
+#ifdef BT_BENCH_COUNT_ALLOCS
+           "true",
+#else
+           "false",
+#endif
+           minTime);
+
+    for (size_t b = 0; b < sizeof(benchmarks) / sizeof(benchmarks[0]); b++)
+    {
+        const Benchmark *bench = &benchmarks[b];
+        if (filter && !strstr(bench->name, filter))
+            continue;
+
+        int nodes = 0;
+        long allocStart = allocations();
+        BtArena *arena = btArenaCreate(0);
+        BehaviorNode *root = bench->generate(arena, bench->size, &nodes);
+        long buildAllocs = allocations() - allocStart;
+
+        allocStart = allocations();
+        BtFlatTree *flat = btCompileTree(root);
+        BtInstance *instance = btCreateInstances(flat, 1);
+        long compileAllocs = allocations() - allocStart;
+
+        parse.text.length = 0;
+        writeNode(&parse.text, root, 0);
+        BtParseError error;
+        btArenaReset(parse.arena);
+        BehaviorNode *parsed = btParseTree(parse.text.data, parse.text.length, parse.registry, parse.arena, &error);
+        if (!parsed)
+        {
+            fprintf(stderr, "%s: line %d: %s\n", bench->name, error.line, error.message);
+            return 1;
+        }
+
+        btSetEngine(BT_ENGINE_RECURSIVE);
+        int expected = executeNode(root);
+        if (executeNode(parsed) != expected)
+        {
+            fprintf(stderr, "%s: parsed tree differs from the generated one\n", bench->name);
+            return 1;
+        }
+        btSetEngine(BT_ENGINE_ITERATIVE);
+        if (executeNode(root) != expected || executeFlat(flat, NULL) != expected)
+        {
+            fprintf(stderr, "%s: pointer, iterative and flat results differ\n", bench->name);
+            return 1;
+        }
+
+        for (int engine = 0; engine < ENGINE_COUNT; engine++)
+        {
+            long iterations = 1;
+            double elapsed;
+            long tickAllocs;
+
+            // 迭代次数翻倍, 直到单次测量超过 minTime
+            for (;;)
+            {
+                allocStart = allocations();
+                double start = nowSeconds();
+                sink = runEngine(engine, root, flat, instance, &parse, iterations);
+                elapsed = nowSeconds() - start;
+                tickAllocs = allocations() - allocStart;
+                if (elapsed >= minTime || iterations >= (1L << 40))
+                    break;
+                iterations *= 2;
+            }
+
+            printf("%s\n    {\"name\": \"%s\", \"engine\": \"%s\", \"nodes\": %d, \"iterations\": %ld, "
+                   "\"ticks_per_sec\": %.1f, \"ns_per_node\": %.3f, \"allocs_build\": %ld, "
+                   "\"allocs_compile\": %ld, \"allocs_per_tick\": %.3f}",
+                   first ? "" : ",", bench->name, engineNames[engine], nodes, iterations,
+                   iterations / elapsed, elapsed / iterations / nodes * 1e9, buildAllocs,
+                   compileAllocs, (double)tickAllocs / iterations);
+            first = 0;
+        }
+
+        btFreeInstances(instance);
+        btFreeFlatTree(flat);
+        btArenaDestroy(arena);
+    }
+    printf("\n  ]\n}\n");
+    free(parse.text.data);
+    btArenaDestroy(parse.arena);
+    btRegistryDestroy(parse.registry);
+    return 0;
+}
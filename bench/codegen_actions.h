@@ -0,0 +1,38 @@
+/*
+ * Actions shared by the codegen benchmark and its generator. They are
+ * static inline so that the generated tree can inline them; they read
+ * bench_sensors so that the compiler cannot fold the tree to a constant.
+ */
+#ifndef CODEGEN_ACTIONS_H
+#define CODEGEN_ACTIONS_H
+
+#include <stddef.h>
+#include "BehaviorTree.h"
+#include "BehaviorTreeRegistry.h"
+
+extern int bench_sensors[8];
+
+static inline int always(void) { return 1; }
+static inline int never(void) { return 0; }
+static inline int sensor0(void) { return bench_sensors[0]; }
+static inline int sensor1(void) { return bench_sensors[1]; }
+static inline int sensor2(void) { return bench_sensors[2]; }
+static inline int sensor3(void) { return bench_sensors[3]; }
+static inline int sensor4(void) { return bench_sensors[4]; }
+static inline int sensor5(void) { return bench_sensors[5]; }
+static inline int hasAgent(BtContext *ctx) { return ctx != NULL && ctx->agent != NULL; }
+
+static inline void registerCodegenActions(BtRegistry *registry)
+{
+    btRegistryAdd(registry, "always", always);
+    btRegistryAdd(registry, "never", never);
+    btRegistryAdd(registry, "sensor0", sensor0);
+    btRegistryAdd(registry, "sensor1", sensor1);
+    btRegistryAdd(registry, "sensor2", sensor2);
+    btRegistryAdd(registry, "sensor3", sensor3);
+    btRegistryAdd(registry, "sensor4", sensor4);
+    btRegistryAdd(registry, "sensor5", sensor5);
+    btRegistryAddContext(registry, "hasAgent", hasAgent);
+}
+
+#endif // CODEGEN_ACTIONS_H
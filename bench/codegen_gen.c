@@ -0,0 +1,49 @@
+/*
+ * Build-time generator: parses a tree definition with the actions of
+ * codegen_actions.h and writes the equivalent C function.
+ *
+ *     codegen_gen <tree.bt> <out.c> <function> [include]
+ */
+#include <stdio.h>
+#include "BehaviorTreeCodegen.h"
+#include "BehaviorTreeParser.h"
+#include "codegen_actions.h"
+
+int bench_sensors[8];
+
+int main(int argc, char **argv)
+{
+    if (argc < 4)
+    {
+        fprintf(stderr, "usage: %s <tree.bt> <out.c> <function> [include]\n", argv[0]);
+        return 2;
+    }
+
+    BtRegistry *registry = btRegistryCreate();
+    BtArena *arena = btArenaCreate(1 << 16);
+    BtParseError error;
+    registerCodegenActions(registry);
+
+    BehaviorNode *root = btParseTreeFile(argv[1], registry, arena, &error);
+    if (!root)
+    {
+        fprintf(stderr, "%s:%d: %s\n", argv[1], error.line, error.message);
+        return 1;
+    }
+
+    BtFlatTree *tree = btCompileTree(root);
+    FILE *out = fopen(argv[2], "w");
+    int ok = tree && out && btGenerateC(tree, registry, argv[3], argc > 4 ? argv[4] : NULL, out);
+    if (out && fclose(out) != 0)
+        ok = 0;
+    if (!ok)
+    {
+        fprintf(stderr, "%s: cannot generate %s\n", argv[0], argv[2]);
+        remove(argv[2]);
+    }
+
+    btFreeFlatTree(tree);
+    btArenaDestroy(arena);
+    btRegistryDestroy(registry);
+    return ok ? 0 : 1;
+}
@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include "BehaviorTree.h"
+#include "Blackboard.h"
 // Action functions
 int actionA()
 {
@@ -24,19 +25,24 @@ int actionFail()
 int beep()
 {
     printf("Beep is start\n");
+    return 1;
 }
 
 int motor()
 {
     printf("Motor is start\n");
+    return 1;
 }
 
-// Example condition function
-int checkCondition()
+// Example condition function: 计数保存在 agent 的黑板中, 不再使用静态变量
+static BbKey conditionCountKey;
+
+int checkCondition(BtContext *ctx)
 {
-    static int count = 0;
-    printf("Condition checked %d \n", count);
-    if (count++ > 3)
+    int64_t count = bbGetInt(ctx->blackboard, conditionCountKey);
+    printf("Condition checked %lld \n", (long long)count);
+    bbSetInt(ctx->blackboard, conditionCountKey, count + 1);
+    if (count > 3)
     {
         return 1;
     }
@@ -63,6 +69,10 @@ int else_test()
 int main()
 {
     int consult = 0;
+    BbSchema *schema = bbSchemaCreate();
+    conditionCountKey = bbIntern(schema, "condition_count", BB_TYPE_INT);
+    Blackboard *blackboard = bbCreate(schema);
+    BtContext agent = {NULL, blackboard};
     // Create action nodes
     BehaviorNode *action1 = createBehaviorNode(NULL,
                                                0,
@@ -81,10 +91,8 @@ int main()
                                              0,
                                              NODE_TYPE_ACTION,
                                              motor);
-    BehaviorNode *conditionNode = createBehaviorNode(NULL,
-                                                     0,
-                                                     NODE_TYPE_CONDITION,
-                                                     checkCondition);
+    BehaviorNode *conditionNode = createContextNode(NODE_TYPE_CONDITION,
+                                                    checkCondition);
     // Create a sequence node
     BehaviorNode *sequenceChildren[] = {Motor, Beep};
     BehaviorNode *sequence = createBehaviorNode(sequenceChildren,
@@ -147,10 +155,18 @@ int main()
                                             NODE_TYPE_PARALLEL,
                                             NULL);
 
-    executeNode(root);
-    printf("--\n");
+    // tick 模式: 延时不再阻塞线程, 每 10ms tick 一次直到完成
+    int ticks = 1;
+    while (tickTreeWithContext(root, &agent, btMonotonicMs()) == BT_RUNNING)
+    {
+        usleep(10000);
+        ticks++;
+    }
+    printf("-- finished after %d ticks\n", ticks);
     // Free memory
     freeBehaviorTree(root);
     printf("freeBehaviorTree(root)\n");
+    bbDestroy(blackboard);
+    bbSchemaDestroy(schema);
     return 0;
 }
\ No newline at end of file
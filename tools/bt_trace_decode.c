@@ -0,0 +1,38 @@
+/*
+ * Prints a trace written by btTraceStart as text:
+ *
+ *     bt_trace_decode trace.bin [out.txt]
+ */
+#include <stdio.h>
+#include "BehaviorTreeTrace.h"
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <trace> [output]\n", argv[0]);
+        return 2;
+    }
+
+    FILE *in = fopen(argv[1], "rb");
+    if (!in)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+    FILE *out = argc > 2 ? fopen(argv[2], "w") : stdout;
+    if (!out)
+    {
+        perror(argv[2]);
+        fclose(in);
+        return 1;
+    }
+
+    int ok = btTraceDecode(in, out);
+    if (!ok)
+        fprintf(stderr, "%s: not a valid trace file\n", argv[1]);
+    fclose(in);
+    if (out != stdout)
+        fclose(out);
+    return ok ? 0 : 1;
+}